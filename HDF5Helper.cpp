@@ -1,7 +1,618 @@
 #include "HDF5Helper.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <filesystem>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define HDF5HELPER_STAT 1
+#endif
+
+namespace
+{
+    bool AddCompoundSegments(hid_t src, hid_t dst, size_t srcBase, size_t dstBase, std::vector<HDF5Utils::CompoundCopyPlan::Segment> &segments)
+    {
+        const int nmembers = H5Tget_nmembers(dst);
+        for(int i = 0; i < nmembers; ++i)
+        {
+            char *name = H5Tget_member_name(dst, static_cast<unsigned>(i));
+            const int j = H5Tget_member_index(src, name);
+            H5free_memory(name);
+            if(j < 0)
+            {
+                return false;
+            }
+
+            const hid_t dst_member = H5Tget_member_type(dst, static_cast<unsigned>(i));
+            const hid_t src_member = H5Tget_member_type(src, static_cast<unsigned>(j));
+            const size_t dst_offset = dstBase + H5Tget_member_offset(dst, static_cast<unsigned>(i));
+            const size_t src_offset = srcBase + H5Tget_member_offset(src, static_cast<unsigned>(j));
+            bool ok;
+            if(H5Tget_class(dst_member) == H5T_COMPOUND and H5Tget_class(src_member) == H5T_COMPOUND)
+            {
+                ok = AddCompoundSegments(src_member, dst_member, src_offset, dst_offset, segments);
+            }
+            else if(H5Tdetect_class(dst_member, H5T_VLEN) > 0 or H5Tis_variable_str(dst_member) > 0)
+            {
+                ok = false;
+            }
+            else
+            {
+                ok = H5Tequal(src_member, dst_member) > 0;
+                if(ok)
+                {
+                    segments.push_back({src_offset, dst_offset, H5Tget_size(dst_member)});
+                }
+            }
+            H5Tclose(dst_member);
+            H5Tclose(src_member);
+            if(not ok)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<size_t N>
+    void CopyMember(const char *src, size_t srcStride, char *dst, size_t dstStride, size_t count)
+    {
+        for(size_t r = 0; r < count; ++r)
+        {
+            std::memcpy(dst + r * dstStride, src + r * srcStride, N);
+        }
+    }
+
+    const char *DriverName(HDF5Utils::FileDriver driver)
+    {
+        switch(driver)
+        {
+            case HDF5Utils::FileDriver::Direct: return "direct";
+            case HDF5Utils::FileDriver::Split: return "split";
+            case HDF5Utils::FileDriver::Family: return "family";
+            default: return "sec2";
+        }
+    }
+
+    void WriteAttribute(H5::Group &group, const char *name, hsize_t value)
+    {
+        if(group.attrExists(name))
+        {
+            group.removeAttr(name);
+        }
+        group.createAttribute(name, H5::PredType::STD_U64LE, H5::DataSpace()).write(H5::PredType::NATIVE_ULLONG, &value);
+    }
+
+    void WriteAttribute(H5::Group &group, const char *name, const std::string &value)
+    {
+        if(group.attrExists(name))
+        {
+            group.removeAttr(name);
+        }
+        const H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+        group.createAttribute(name, str_type, H5::DataSpace()).write(str_type, value);
+    }
+
+    template<typename T>
+    void ReadAttribute(const H5::Group &group, const char *name, T &value)
+    {
+        if(not group.attrExists(name))
+        {
+            return;
+        }
+        const H5::Attribute attribute = group.openAttribute(name);
+        if constexpr(std::is_same_v<T, std::string>)
+        {
+            attribute.read(attribute.getStrType(), value);
+        }
+        else
+        {
+            unsigned long long stored = 0;
+            attribute.read(H5::PredType::NATIVE_ULLONG, &stored);
+            value = static_cast<T>(stored);
+        }
+    }
+
+    std::string NormalizePath(const std::string &path)
+    {
+        std::string normalized = path.empty() or path.front() != '/' ? "/" + path : path;
+        while(normalized.size() > 1 and normalized.back() == '/')
+        {
+            normalized.pop_back();
+        }
+        return normalized;
+    }
+
+    // State of one BuildCatalog() visit.
+    struct CatalogVisit
+    {
+        HDF5Utils::Catalog *catalog = nullptr;
+        std::unordered_map<std::string, std::string> groups;            // object address -> first path of the group
+        std::vector<std::pair<std::string, std::string>> aliases;       // further path of a group -> first path
+    };
+
+    void DescribeDataSet(hid_t dataset, HDF5Utils::CatalogEntry &entry)
+    {
+        entry.type = H5O_TYPE_DATASET;
+        const hid_t space = H5Dget_space(dataset);
+        entry.dims.resize(std::max(0, H5Sget_simple_extent_ndims(space)));
+        H5Sget_simple_extent_dims(space, entry.dims.data(), nullptr);
+        H5Sclose(space);
+        const hid_t type = H5Dget_type(dataset);
+        entry.typeName = HDF5Utils::DescribeType(type);
+        H5Tclose(type);
+        const hid_t plist = H5Dget_create_plist(dataset);
+        entry.layout = HDF5Utils::DescribeLayout(H5Pget_layout(plist));
+        H5Pclose(plist);
+    }
+
+    herr_t VisitLink(hid_t root, const char *name, const H5L_info_t *info, void *data)
+    {
+        CatalogVisit &visit = *static_cast<CatalogVisit*>(data);
+        HDF5Utils::CatalogEntry entry;
+        entry.path = std::string("/") + name;
+        if(entry.path == HDF5Utils::CatalogDataset)
+        {
+            return 0;
+        }
+        entry.link = info->type;
+        const hid_t id = info->type == H5L_TYPE_HARD ? H5Oopen(root, name, H5P_DEFAULT) : H5I_INVALID_HID;
+        if(id >= 0)
+        {
+            switch(H5Iget_type(id))
+            {
+                case H5I_GROUP:
+                {
+                    // the library visits a group once, however many links lead to it
+                    entry.type = H5O_TYPE_GROUP;
+#if H5_VERSION_GE(1, 12, 0)
+                    const std::string key(reinterpret_cast<const char*>(&info->u.token), sizeof(info->u.token));
+#else
+                    const std::string key(reinterpret_cast<const char*>(&info->u.address), sizeof(info->u.address));
+#endif
+                    const auto [first, inserted] = visit.groups.emplace(key, entry.path);
+                    if(not inserted)
+                    {
+                        visit.aliases.emplace_back(entry.path, first->second);
+                    }
+                    break;
+                }
+                case H5I_DATASET:
+                    DescribeDataSet(id, entry);
+                    break;
+                case H5I_DATATYPE:
+                    entry.type = H5O_TYPE_NAMED_DATATYPE;
+                    break;
+                default:
+                    break;
+            }
+            H5Oclose(id);
+        }
+        visit.catalog->Add(std::move(entry));
+        return 0;
+    }
+
+    // Record of CatalogDataset.
+    struct CatalogRecord
+    {
+        const char *path;
+        const char *typeName;
+        const char *layout;
+        hvl_t dims;
+        int8_t type;
+        int8_t link;
+    };
+
+    H5::CompType CatalogRecordType(void)
+    {
+        const H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+        const H5::VarLenType dims_type(H5::PredType::NATIVE_ULLONG);
+        H5::CompType type(sizeof(CatalogRecord));
+        type.insertMember("path", HOFFSET(CatalogRecord, path), str_type);
+        type.insertMember("type_name", HOFFSET(CatalogRecord, typeName), str_type);
+        type.insertMember("layout", HOFFSET(CatalogRecord, layout), str_type);
+        type.insertMember("dims", HOFFSET(CatalogRecord, dims), dims_type);
+        type.insertMember("type", HOFFSET(CatalogRecord, type), H5::PredType::NATIVE_INT8);
+        type.insertMember("link", HOFFSET(CatalogRecord, link), H5::PredType::NATIVE_INT8);
+        return type;
+    }
+
+    // Sets CatalogCompleteAttribute of the catalog `dataset`, creating it if needed.
+    void SetCatalogComplete(H5::DataSet &dataset, uint8_t complete)
+    {
+        H5::Attribute attribute = dataset.attrExists(HDF5Utils::CatalogCompleteAttribute) ?
+                                  dataset.openAttribute(HDF5Utils::CatalogCompleteAttribute) :
+                                  dataset.createAttribute(HDF5Utils::CatalogCompleteAttribute, H5::PredType::STD_U8LE, H5::DataSpace());
+        attribute.write(H5::PredType::NATIVE_UINT8, &complete);
+    }
+
+    // CatalogDataset resized to `size` records. It is chunked with an unlimited extent, so each Dump() rewrites it in place
+    // instead of leaving the space of a deleted one behind; a catalog stored otherwise is replaced.
+    H5::DataSet CatalogDataSet(H5::H5File &file, const H5::CompType &type, hsize_t size)
+    {
+        if(H5Lexists(file.getId(), HDF5Utils::InternalGroup, H5P_DEFAULT) > 0 and
+           H5Lexists(file.getId(), HDF5Utils::CatalogDataset, H5P_DEFAULT) > 0)
+        {
+            H5::DataSet dataset = file.openDataSet(HDF5Utils::CatalogDataset);
+            if(dataset.getCreatePlist().getLayout() == H5D_CHUNKED)
+            {
+                H5Dset_extent(dataset.getId(), &size);
+                return dataset;
+            }
+            H5Ldelete(file.getId(), HDF5Utils::CatalogDataset, H5P_DEFAULT);
+        }
+        const hsize_t max_dims[] = {H5S_UNLIMITED};
+        const hsize_t chunk[] = {256};
+        H5::DSetCreatPropList plist;
+        plist.setChunk(1, chunk);
+        H5::Group group = HDF5Utils::openGroupPath(file, HDF5Utils::InternalGroup, true);
+        const std::string name = HDF5Utils::splitPathAndName(HDF5Utils::CatalogDataset).second;
+        return group.createDataSet(name, type, H5::DataSpace(1, &size, max_dims), plist);
+    }
+}
 
 namespace HDF5Utils
 {
+    CompoundCopyPlan BuildCompoundCopyPlan(hid_t src, hid_t dst)
+    {
+        CompoundCopyPlan plan;
+        if(H5Tget_class(src) != H5T_COMPOUND or H5Tget_class(dst) != H5T_COMPOUND)
+        {
+            return plan;
+        }
+        plan.srcSize = H5Tget_size(src);
+        plan.dstSize = H5Tget_size(dst);
+        std::vector<CompoundCopyPlan::Segment> segments;
+        if(not AddCompoundSegments(src, dst, 0, 0, segments))
+        {
+            return plan;
+        }
+
+        std::sort(segments.begin(), segments.end(), [](const auto &a, const auto &b){ return a.dst < b.dst; });
+        for(const CompoundCopyPlan::Segment &segment : segments)
+        {
+            if(not plan.segments.empty())
+            {
+                CompoundCopyPlan::Segment &last = plan.segments.back();
+                if(last.src + last.size == segment.src and last.dst + last.size == segment.dst)
+                {
+                    last.size += segment.size;
+                    continue;
+                }
+            }
+            plan.segments.push_back(segment);
+        }
+        plan.valid = true;
+        return plan;
+    }
+
+    void ApplyCompoundCopyPlan(const CompoundCopyPlan &plan, const void *src, void *dst, size_t count)
+    {
+        const char *in = static_cast<const char*>(src);
+        char *out = static_cast<char*>(dst);
+        // one strided pass per member; fixed-size copies compile to plain loads/stores
+        for(const CompoundCopyPlan::Segment &segment : plan.segments)
+        {
+            const char *s = in + segment.src;
+            char *d = out + segment.dst;
+            switch(segment.size)
+            {
+                case 1: CopyMember<1>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 2: CopyMember<2>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 4: CopyMember<4>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 8: CopyMember<8>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 12: CopyMember<12>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 16: CopyMember<16>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 24: CopyMember<24>(s, plan.srcSize, d, plan.dstSize, count); break;
+                case 32: CopyMember<32>(s, plan.srcSize, d, plan.dstSize, count); break;
+                default:
+                    for(size_t r = 0; r < count; ++r)
+                    {
+                        std::memcpy(d + r * plan.dstSize, s + r * plan.srcSize, segment.size);
+                    }
+            }
+        }
+    }
+
+    namespace
+    {
+        thread_local std::pmr::memory_resource *currentResource = nullptr;
+
+        // the block size is kept in front of each block, for the free callback
+        constexpr size_t VlenHeader = alignof(std::max_align_t);
+
+        void *VlenAllocate(size_t size, void *info)
+        {
+            char *block = static_cast<char*>(static_cast<std::pmr::memory_resource*>(info)->allocate(size + VlenHeader, VlenHeader));
+            std::memcpy(block, &size, sizeof(size));
+            return block + VlenHeader;
+        }
+
+        void VlenFree(void *pointer, void *info)
+        {
+            if(pointer == nullptr)
+            {
+                return;
+            }
+            char *block = static_cast<char*>(pointer) - VlenHeader;
+            size_t size;
+            std::memcpy(&size, block, sizeof(size));
+            static_cast<std::pmr::memory_resource*>(info)->deallocate(block, size + VlenHeader, VlenHeader);
+        }
+    }
+
+    std::pmr::memory_resource *CurrentMemoryResource(void)
+    {
+        return currentResource ? currentResource : std::pmr::get_default_resource();
+    }
+
+    ScopedMemoryResource::ScopedMemoryResource(std::pmr::memory_resource *resource)
+        : previous_(currentResource)
+    {
+        if(resource)
+        {
+            currentResource = resource;
+        }
+    }
+
+    ScopedMemoryResource::~ScopedMemoryResource()
+    {
+        currentResource = this->previous_;
+    }
+
+    H5::DSetMemXferPropList VlenTransfer(void)
+    {
+        std::pmr::memory_resource *resource = CurrentMemoryResource();
+        if(resource == std::pmr::new_delete_resource())
+        {
+            return H5::DSetMemXferPropList::DEFAULT;
+        }
+        H5::DSetMemXferPropList xfer;
+        H5Pset_vlen_mem_manager(xfer.getId(), VlenAllocate, resource, VlenFree, resource);
+        return xfer;
+    }
+
+    uint64_t HashBytes(const void *data, size_t size, uint64_t seed)
+    {
+        constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        const auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+        uint64_t h = seed ^ (size * prime1);
+        size_t i = 0;
+        if(size >= 32)
+        {
+            // four independent lanes over 32-byte stripes, so their multiplications overlap
+            uint64_t lanes[4] = {h + prime1 + prime2, h + prime2, h, h - prime1};
+            for(; i + 32 <= size; i += 32)
+            {
+                for(int k = 0; k < 4; ++k)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, bytes + i + 8 * k, 8);
+                    lanes[k] = rotl(lanes[k] + word * prime2, 31) * prime1;
+                }
+            }
+            h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for(int k = 0; k < 4; ++k)
+            {
+                h ^= rotl(lanes[k] * prime2, 31) * prime1;
+                h = h * prime1 + prime2;
+            }
+        }
+        for(; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            word *= prime2;
+            word = (word << 31) | (word >> 33);
+            h ^= word * prime1;
+            h = ((h << 27) | (h >> 37)) * prime1 + prime2;
+        }
+        for(; i < size; ++i)
+        {
+            h ^= bytes[i] * prime1;
+            h = ((h << 11) | (h >> 53)) * prime2;
+        }
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        return h;
+    }
+
+    std::string DescribeType(hid_t type)
+    {
+        const size_t size = H5Tget_size(type);
+        switch(H5Tget_class(type))
+        {
+            case H5T_INTEGER:
+            {
+                const std::string name = (H5Tget_sign(type) == H5T_SGN_2 ? "int" : "uint") + std::to_string(8 * size);
+                const size_t precision = H5Tget_precision(type);
+                return precision == 8 * size ? name : name + "(" + std::to_string(precision) + " bits)";
+            }
+            case H5T_FLOAT:
+            {
+                const std::string name = "float" + std::to_string(8 * size);
+                size_t spos, epos, esize, mpos, msize;
+                H5Tget_fields(type, &spos, &epos, &esize, &mpos, &msize);
+                const bool standard = (size == 4 and msize == 23) or (size == 8 and msize == 52);
+                return standard ? name : name + "(" + std::to_string(msize) + "-bit mantissa)";
+            }
+            case H5T_STRING:
+                return H5Tis_variable_str(type) > 0 ? "string" : "string[" + std::to_string(size) + "]";
+            case H5T_COMPOUND:
+            {
+                std::string name = "{";
+                const int members = H5Tget_nmembers(type);
+                for(int i = 0; i < members; ++i)
+                {
+                    char *member = H5Tget_member_name(type, i);
+                    const hid_t memberType = H5Tget_member_type(type, i);
+                    name += (i > 0 ? ", " : "") + std::string(member) + ": " + DescribeType(memberType);
+                    H5Tclose(memberType);
+                    H5free_memory(member);
+                }
+                return name + "}";
+            }
+            case H5T_VLEN:
+            case H5T_ARRAY:
+            case H5T_ENUM:
+            {
+                const hid_t super = H5Tget_super(type);
+                std::string base = DescribeType(super);
+                H5Tclose(super);
+                if(H5Tget_class(type) == H5T_VLEN)
+                {
+                    return "vlen<" + base + ">";
+                }
+                if(H5Tget_class(type) == H5T_ENUM)
+                {
+                    return "enum<" + base + ">(" + std::to_string(H5Tget_nmembers(type)) + " values)";
+                }
+                std::vector<hsize_t> dims(H5Tget_array_ndims(type));
+                H5Tget_array_dims2(type, dims.data());
+                for(size_t i = 0; i < dims.size(); ++i)
+                {
+                    base += (i == 0 ? "[" : " x ") + std::to_string(dims[i]);
+                }
+                return base + "]";
+            }
+            case H5T_BITFIELD:
+                return "bitfield" + std::to_string(8 * size);
+            case H5T_OPAQUE:
+                return "opaque[" + std::to_string(size) + "]";
+            case H5T_REFERENCE:
+                return "reference";
+            default:
+                return "unknown";
+        }
+    }
+
+    std::string DescribeLayout(H5D_layout_t layout)
+    {
+        switch(layout)
+        {
+            case H5D_COMPACT: return "compact";
+            case H5D_CONTIGUOUS: return "contiguous";
+            case H5D_CHUNKED: return "chunked";
+            case H5D_VIRTUAL: return "virtual";
+            default: return "unknown";
+        }
+    }
+
+    FileLayout ResolveFileLayout(const std::string &filename, FileLayout layout, bool create)
+    {
+        if(not create and layout.driver == FileDriver::Default and not std::filesystem::exists(filename))
+        {
+            if(filename.find('%') != std::string::npos)
+            {
+                layout.driver = FileDriver::Family;
+            }
+            else if(std::filesystem::exists(filename + layout.metaExtension))
+            {
+                layout.driver = FileDriver::Split;
+            }
+        }
+#ifdef HDF5HELPER_STAT
+        if(layout.alignment == 0 and layout.alignToFilesystem)
+        {
+            const std::string directory = filename.find('/') == std::string::npos ? "." : filename.substr(0, filename.find_last_of('/') + 1);
+            struct stat info;
+            if(stat(directory.c_str(), &info) == 0 and info.st_blksize > 0)
+            {
+                layout.alignment = static_cast<hsize_t>(info.st_blksize);
+            }
+        }
+#endif
+        return layout;
+    }
+
+    H5::FileAccPropList FileAccess(const FileLayout &layout, bool create)
+    {
+        H5::FileAccPropList fapl;
+        switch(layout.driver)
+        {
+            case FileDriver::Default:
+                break;
+            case FileDriver::Direct:
+#ifdef H5_HAVE_DIRECT
+                H5Pset_fapl_direct(fapl.getId(), layout.directAlignment, layout.directBlockSize, layout.directCopyBuffer);
+                break;
+#else
+                throw std::runtime_error("HDF5Utils: the HDF5 library was built without the direct file driver");
+#endif
+            case FileDriver::Split:
+                H5Pset_fapl_split(fapl.getId(), layout.metaExtension.c_str(), H5P_DEFAULT, layout.rawExtension.c_str(), H5P_DEFAULT);
+                break;
+            case FileDriver::Family:
+                // 0 takes the member size from the first member of an existing family
+                H5Pset_fapl_family(fapl.getId(), create ? layout.familyMemberBytes : 0, H5P_DEFAULT);
+                break;
+        }
+        if(layout.alignment > 0)
+        {
+            H5Pset_alignment(fapl.getId(), layout.alignmentThreshold, layout.alignment);
+        }
+        if(layout.metadataBlockBytes > 0)
+        {
+            H5Pset_meta_block_size(fapl.getId(), layout.metadataBlockBytes);
+        }
+        return fapl;
+    }
+
+    void WriteFileLayout(H5::H5File &file, const FileLayout &layout)
+    {
+        if(layout.driver == FileDriver::Default and layout.alignment == 0 and layout.metadataBlockBytes == 0)
+        {
+            return;
+        }
+        H5::Group group = openGroupPath(file, InternalGroup, true);
+        WriteAttribute(group, "driver", std::string(DriverName(layout.driver)));
+        WriteAttribute(group, "alignment", layout.alignment);
+        WriteAttribute(group, "alignment_threshold", layout.alignmentThreshold);
+        WriteAttribute(group, "metadata_block_bytes", layout.metadataBlockBytes);
+        if(layout.driver == FileDriver::Family)
+        {
+            WriteAttribute(group, "family_member_bytes", layout.familyMemberBytes);
+        }
+        if(layout.driver == FileDriver::Split)
+        {
+            WriteAttribute(group, "meta_extension", layout.metaExtension);
+            WriteAttribute(group, "raw_extension", layout.rawExtension);
+        }
+    }
+
+    FileLayout ReadFileLayout(const H5::H5File &file, const FileLayout &fallback)
+    {
+        if(H5Lexists(file.getId(), InternalGroup, H5P_DEFAULT) <= 0)
+        {
+            return fallback;
+        }
+        const H5::Group group = file.openGroup(InternalGroup);
+        if(not group.attrExists("driver"))
+        {
+            return fallback;
+        }
+        FileLayout layout = fallback;
+        std::string driver;
+        ReadAttribute(group, "driver", driver);
+        for(FileDriver candidate : {FileDriver::Default, FileDriver::Direct, FileDriver::Split, FileDriver::Family})
+        {
+            if(driver == DriverName(candidate))
+            {
+                layout.driver = candidate;
+            }
+        }
+        ReadAttribute(group, "alignment", layout.alignment);
+        ReadAttribute(group, "alignment_threshold", layout.alignmentThreshold);
+        ReadAttribute(group, "metadata_block_bytes", layout.metadataBlockBytes);
+        ReadAttribute(group, "family_member_bytes", layout.familyMemberBytes);
+        ReadAttribute(group, "meta_extension", layout.metaExtension);
+        ReadAttribute(group, "raw_extension", layout.rawExtension);
+        return layout;
+    }
+
     std::vector<std::string> splitPath(const std::string &path)
     {
         std::vector<std::string> parts;
@@ -107,4 +718,157 @@ namespace HDF5Utils
         return std::make_pair(groupPath, name);
     }
 
+    void Catalog::Add(CatalogEntry entry)
+    {
+        const size_t slash = entry.path.find_last_of('/');
+        std::vector<std::string> &siblings = this->children[slash == 0 ? "/" : entry.path.substr(0, slash)];
+        // found, but never listed
+        if(entry.path != InternalGroup)
+        {
+            siblings.push_back(entry.path.substr(slash + 1));
+        }
+        if(entry.type == H5O_TYPE_GROUP)
+        {
+            this->children.try_emplace(entry.path);
+        }
+        this->index[entry.path] = this->entries.size();
+        this->entries.push_back(std::move(entry));
+    }
+
+    const CatalogEntry *Catalog::Find(const std::string &path) const
+    {
+        const auto found = this->index.find(NormalizePath(path));
+        return found == this->index.end() ? nullptr : &this->entries[found->second];
+    }
+
+    const std::vector<std::string> *Catalog::Children(const std::string &path) const
+    {
+        const auto found = this->children.find(NormalizePath(path));
+        return found == this->children.end() ? nullptr : &found->second;
+    }
+
+    bool Catalog::Covers(const std::string &path) const
+    {
+        const std::string normalized = NormalizePath(path);
+        for(size_t slash = normalized.find('/', 1); ; slash = normalized.find('/', slash + 1))
+        {
+            const auto found = this->index.find(normalized.substr(0, slash));
+            if(found == this->index.end())
+            {
+                return true;
+            }
+            if(this->entries[found->second].link != H5L_TYPE_HARD)
+            {
+                return false;
+            }
+            if(slash == std::string::npos)
+            {
+                return true;
+            }
+        }
+    }
+
+    Catalog BuildCatalog(const H5::H5File &file)
+    {
+        Catalog catalog;
+        catalog.children.try_emplace("/");
+        CatalogVisit visit;
+        visit.catalog = &catalog;
+        if(H5Lvisit(file.getId(), H5_INDEX_NAME, H5_ITER_INC, VisitLink, &visit) < 0)
+        {
+            throw std::runtime_error("HDF5Utils: cannot list the objects of " + file.getFileName());
+        }
+        // the contents of a group reached through several hard links are listed under each of its paths
+        for(const auto &[alias, path] : visit.aliases)
+        {
+            const std::string prefix = path + "/";
+            for(size_t i = 0, count = catalog.entries.size(); i < count; ++i)
+            {
+                if(catalog.entries[i].path.compare(0, prefix.size(), prefix) == 0)
+                {
+                    CatalogEntry entry = catalog.entries[i];
+                    entry.path = alias + entry.path.substr(path.size());
+                    catalog.Add(std::move(entry));
+                }
+            }
+        }
+        return catalog;
+    }
+
+    void WriteCatalog(H5::H5File &file, const Catalog &catalog)
+    {
+        std::vector<CatalogRecord> records(catalog.entries.size());
+        for(size_t i = 0; i < records.size(); ++i)
+        {
+            const CatalogEntry &entry = catalog.entries[i];
+            records[i].path = entry.path.c_str();
+            records[i].typeName = entry.typeName.c_str();
+            records[i].layout = entry.layout.c_str();
+            records[i].dims.len = entry.dims.size();
+            records[i].dims.p = const_cast<hsize_t*>(entry.dims.data());
+            records[i].type = static_cast<int8_t>(entry.type);
+            records[i].link = static_cast<int8_t>(entry.link);
+        }
+        const H5::CompType type = CatalogRecordType();
+        H5::DataSet dataset = CatalogDataSet(file, type, records.size());
+        if(not records.empty())
+        {
+            dataset.write(records.data(), type);
+        }
+        SetCatalogComplete(dataset, 1);
+    }
+
+    bool ReadCatalog(const H5::H5File &file, Catalog &catalog)
+    {
+        if(H5Lexists(file.getId(), InternalGroup, H5P_DEFAULT) <= 0 or H5Lexists(file.getId(), CatalogDataset, H5P_DEFAULT) <= 0)
+        {
+            return false;
+        }
+        const H5::DataSet dataset = file.openDataSet(CatalogDataset);
+        if(dataset.attrExists(CatalogCompleteAttribute))
+        {
+            uint8_t complete = 0;
+            dataset.openAttribute(CatalogCompleteAttribute).read(H5::PredType::NATIVE_UINT8, &complete);
+            if(not complete)
+            {
+                return false;
+            }
+        }
+        const H5::DataSpace space = dataset.getSpace();
+        std::vector<CatalogRecord> records(space.getSimpleExtentNpoints());
+        catalog = Catalog();
+        catalog.children.try_emplace("/");
+        if(records.empty())
+        {
+            return true;
+        }
+        const H5::CompType type = CatalogRecordType();
+        const H5::DSetMemXferPropList xfer = VlenTransfer();
+        dataset.read(records.data(), type, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
+        catalog.entries.reserve(records.size());
+        catalog.index.reserve(records.size());
+        for(const CatalogRecord &record : records)
+        {
+            CatalogEntry entry;
+            entry.path = record.path ? record.path : "";
+            entry.typeName = record.typeName ? record.typeName : "";
+            entry.layout = record.layout ? record.layout : "";
+            const hsize_t *dims = static_cast<const hsize_t*>(record.dims.p);
+            entry.dims.assign(dims, dims + record.dims.len);
+            entry.type = static_cast<H5O_type_t>(record.type);
+            entry.link = static_cast<H5L_type_t>(record.link);
+            catalog.Add(std::move(entry));
+        }
+        H5Dvlen_reclaim(type.getId(), space.getId(), xfer.getId(), records.data());
+        return true;
+    }
+
+    void InvalidateCatalog(H5::H5File &file)
+    {
+        if(H5Lexists(file.getId(), InternalGroup, H5P_DEFAULT) > 0 and H5Lexists(file.getId(), CatalogDataset, H5P_DEFAULT) > 0)
+        {
+            H5::DataSet dataset = file.openDataSet(CatalogDataset);
+            SetCatalogComplete(dataset, 0);
+        }
+    }
 }
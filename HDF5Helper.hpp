@@ -9,13 +9,22 @@
 #include <type_traits>
 #include <stdexcept>
 #include <string>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <unordered_map>
+#include "HDF5Options.hpp"
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define HDF5UTILS_HAS_SPAN 1
+#endif
 
 namespace HDF5Utils
 {
     template<typename T>
     struct IsVector : std::false_type {};
-    template<typename U>
-    struct IsVector<std::vector<U>> : std::true_type {};
+    template<typename U, typename Allocator>
+    struct IsVector<std::vector<U, Allocator>> : std::true_type {};
 
     template<typename T>
     struct IsArray : std::false_type {};
@@ -29,22 +38,22 @@ namespace HDF5Utils
     // Used to determine if a type hierarchy can represent jagged (VLEN) data.
     template<typename T>
     struct ContainsVector : std::false_type {};
-    template<typename U>
-    struct ContainsVector<std::vector<U>> : std::true_type {};
+    template<typename U, typename Allocator>
+    struct ContainsVector<std::vector<U, Allocator>> : std::true_type {};
     template<typename U, size_t N>
     struct ContainsVector<std::array<U, N>> : ContainsVector<U> {};
 
     template<typename T>
     struct InnerType { using type = T; };
-    template<typename U>
-    struct InnerType<std::vector<U>> { using type = typename InnerType<U>::type; };
+    template<typename U, typename Allocator>
+    struct InnerType<std::vector<U, Allocator>> { using type = typename InnerType<U>::type; };
     template<typename U, size_t N>
     struct InnerType<std::array<U, N>> { using type = typename InnerType<U>::type; };
 
     template<typename T>
     struct Rank { static constexpr int value = 1; };
-    template<typename U>
-    struct Rank<std::vector<U>> { static constexpr int value = 1 + Rank<U>::value; };
+    template<typename U, typename Allocator>
+    struct Rank<std::vector<U, Allocator>> { static constexpr int value = 1 + Rank<U>::value; };
     template<typename U, size_t N>
     struct Rank<std::array<U, N>> { static constexpr int value = 1 + Rank<U>::value; };
 
@@ -74,6 +83,396 @@ namespace HDF5Utils
     template<> struct HDF5Type<unsigned long long> { static const H5::PredType& value() { return H5::PredType::NATIVE_ULLONG; } };
     template<> struct HDF5Type<std::string> { static H5::StrType value() { return H5::StrType(H5::PredType::C_S1, H5T_VARIABLE); } };
 
+    /**
+    Read-only view of a row-major array of `dims` elements in memory owned by the caller, written by `HDF5Writer` without
+    copying it into a `std::vector`. `strides` is the distance, in elements, between consecutive indices of each dimension;
+    empty means contiguous. Strides that nest (each one a multiple of the next and covering its extent) become a memory
+    hyperslab; any other layout (e.g. transposed) is gathered into a temporary buffer.
+    */
+    template<typename T>
+    struct StridedView
+    {
+        using value_type = T;
+
+        const T *data = nullptr;
+        std::vector<hsize_t> dims;
+        std::vector<hsize_t> strides;
+
+        StridedView() = default;
+        StridedView(const T *data, std::vector<hsize_t> dims, std::vector<hsize_t> strides = {})
+            : data(data), dims(std::move(dims)), strides(std::move(strides)) {}
+
+        /** Number of elements in the view. */
+        hsize_t Size(void) const
+        {
+            hsize_t size = 1;
+            for(hsize_t d : dims)
+            {
+                size *= d;
+            }
+            return size;
+        }
+
+        /** `strides`, or the row-major strides of `dims` if it is empty. */
+        std::vector<hsize_t> ElementStrides(void) const
+        {
+            if(not strides.empty())
+            {
+                return strides;
+            }
+            std::vector<hsize_t> contiguous(dims.size(), 1);
+            for(size_t i = dims.size(); i-- > 1;)
+            {
+                contiguous[i - 1] = contiguous[i] * dims[i];
+            }
+            return contiguous;
+        }
+
+        /** True if the elements are stored contiguously in row-major order. */
+        bool IsContiguous(void) const
+        {
+            if(strides.empty())
+            {
+                return true;
+            }
+            const std::vector<hsize_t> contiguous = StridedView(data, dims).ElementStrides();
+            for(size_t i = 0; i < dims.size(); ++i)
+            {
+                // the stride of a dimension of extent 1 is never used
+                if(dims[i] > 1 and strides[i] != contiguous[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /** True for the non-owning write sources: `StridedView` and, in C++20, `std::span`. */
+    template<typename T>
+    struct IsView : std::false_type {};
+    template<typename U>
+    struct IsView<StridedView<U>> : std::true_type {};
+
+    template<typename U>
+    StridedView<U> ToView(const StridedView<U> &view)
+    {
+        return view;
+    }
+
+#ifdef HDF5UTILS_HAS_SPAN
+    template<typename U, size_t N>
+    struct IsView<std::span<U, N>> : std::true_type {};
+
+    template<typename U, size_t N>
+    StridedView<std::remove_cv_t<U>> ToView(const std::span<U, N> &span)
+    {
+        return StridedView<std::remove_cv_t<U>>(span.data(), {static_cast<hsize_t>(span.size())});
+    }
+#endif
+
+    /** Size of the staging buffer used when repacking compound records. */
+    inline constexpr size_t CompoundBlockBytes = size_t(1) << 20;
+
+    /**
+    Largest dictionary (distinct strings including terminators) stored as an enum type.
+    HDF5 keeps the type in an object header message, which is limited to 64 KiB.
+    */
+    inline constexpr size_t DictionaryMaxBytes = size_t(32) << 10;
+
+    /**
+    Enum names cannot be empty, so a dictionary holding the empty string gives it an unused name,
+    recorded in this attribute of the dataset.
+    */
+    inline constexpr const char *DictionaryEmptyAttribute = "dictionary_empty";
+
+    /** Attribute of the group holding a columnar compound element, set to `ColumnarLayout`. */
+    inline constexpr const char *LayoutAttribute = "layout";
+    inline constexpr const char *ColumnarLayout = "columnar";
+
+    /** Group holding the library's own bookkeeping in a file. */
+    inline constexpr const char *InternalGroup = "/.easyhdf5";
+
+    /** Index of the deduplicated elements of a file (`WriterOptions::deduplicate`): datasets "keys", "paths" and "bytes". */
+    inline constexpr const char *DedupIndexGroup = "/.easyhdf5/dedup";
+
+    /** Group holding the decimated levels of elements written with `ElementOptions::pyramidLevels`. */
+    inline constexpr const char *PyramidGroup = "/.easyhdf5/pyramid";
+
+    /** Attribute of the group of a pyramid holding its reduction: "mean", "max" or "stride". */
+    inline constexpr const char *ReductionAttribute = "reduction";
+
+    /** Group holding the zone maps of elements written with `ElementOptions::zoneMapRows`. */
+    inline constexpr const char *ZoneMapGroup = "/.easyhdf5/zonemap";
+
+    /**
+    Attribute of a dataset with a zone map: the rows per block. A zone map is only used while this is set,
+    so rewriting the dataset without one invalidates it.
+    */
+    inline constexpr const char *ZoneMapRowsAttribute = "zone_map_rows";
+
+    /** Path of the bookkeeping of the element at `path` below the internal group `group`. */
+    inline std::string InternalPath(const char *group, const std::string &path)
+    {
+        return std::string(group) + (path.empty() or path.front() != '/' ? "/" : "") + path;
+    }
+
+    /** Group holding the levels of the element at `path`: one dataset per level, named "1", "2", ... */
+    inline std::string PyramidPath(const std::string &path)
+    {
+        return InternalPath(PyramidGroup, path);
+    }
+
+    /** Dataset holding the zone map of the element at `path`: the minimum and maximum of each block, blocks x 2. */
+    inline std::string ZoneMapPath(const std::string &path)
+    {
+        return InternalPath(ZoneMapGroup, path);
+    }
+
+    /**
+    Member-wise copy between two layouts of the same compound type, e.g. a struct and its packed file type.
+    Adjacent members are merged into a single segment.
+    */
+    struct CompoundCopyPlan
+    {
+        struct Segment
+        {
+            size_t src;
+            size_t dst;
+            size_t size;
+        };
+        std::vector<Segment> segments;
+        size_t srcSize = 0;
+        size_t dstSize = 0;
+        bool valid = false;
+    };
+
+    /**
+    Builds the copy plan from compound type `src` to compound type `dst`. Every member of `dst` must exist in `src` with an
+    identical atomic type; otherwise the plan is invalid and the caller should let HDF5 convert.
+    */
+    CompoundCopyPlan BuildCompoundCopyPlan(hid_t src, hid_t dst);
+
+    /**
+    Copies `count` records from `src` to `dst` following `plan`.
+    */
+    void ApplyCompoundCopyPlan(const CompoundCopyPlan &plan, const void *src, void *dst, size_t count);
+
+    /**
+    Memory resource of the intermediate buffers of reads and writes on the calling thread: flattened data, `hvl_t` and
+    string pointer arrays, and variable-length data returned by HDF5. Defaults to `std::pmr::get_default_resource()`.
+    */
+    std::pmr::memory_resource *CurrentMemoryResource(void);
+
+    /**
+    Makes `resource` the calling thread's `CurrentMemoryResource()` for the lifetime of the guard; nullptr keeps the current one.
+    */
+    class ScopedMemoryResource
+    {
+    public:
+        explicit ScopedMemoryResource(std::pmr::memory_resource *resource);
+        ~ScopedMemoryResource();
+        ScopedMemoryResource(const ScopedMemoryResource&) = delete;
+        ScopedMemoryResource &operator=(const ScopedMemoryResource&) = delete;
+
+    private:
+        std::pmr::memory_resource *previous_;
+    };
+
+    /** Allocator of intermediate buffers: a polymorphic allocator bound to the `CurrentMemoryResource()` of its construction. */
+    template<typename T>
+    struct ScratchAllocator : std::pmr::polymorphic_allocator<T>
+    {
+        ScratchAllocator() noexcept : std::pmr::polymorphic_allocator<T>(CurrentMemoryResource()) {}
+        ScratchAllocator(std::pmr::memory_resource *resource) noexcept : std::pmr::polymorphic_allocator<T>(resource) {}
+        template<typename U>
+        ScratchAllocator(const ScratchAllocator<U> &other) noexcept : std::pmr::polymorphic_allocator<T>(other.resource()) {}
+        ScratchAllocator select_on_container_copy_construction(void) const { return ScratchAllocator(); }
+    };
+
+    template<typename T>
+    using Buffer = std::vector<T, ScratchAllocator<T>>;
+
+    /**
+    Transfer properties whose variable-length memory manager allocates from `CurrentMemoryResource()`.
+    A read of variable-length data and its `H5Dvlen_reclaim()` must use the same properties.
+    */
+    H5::DSetMemXferPropList VlenTransfer(void);
+
+    /**
+    64-bit non-cryptographic hash of `size` bytes at `data`, chained through `seed`.
+    */
+    uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 0);
+
+    /**
+    Description of an object in a file, as returned by `HDF5Reader::Info()`. Filled without reading any data.
+    */
+    struct ObjectInfo
+    {
+        H5O_type_t type = H5O_TYPE_UNKNOWN;     // H5O_TYPE_UNKNOWN for dangling links
+        H5L_type_t link = H5L_TYPE_HARD;
+        std::string linkTarget;                 // "file:/path" for external links, the target path for soft links
+        int attributes = 0;
+
+        // datasets only
+        std::vector<hsize_t> dims;
+        std::vector<hsize_t> maxDims;
+        H5T_class_t typeClass = H5T_NO_CLASS;
+        std::string typeName;
+        std::string layout;                     // "compact", "contiguous", "chunked" or "virtual"
+        std::vector<hsize_t> chunkDims;
+        std::vector<std::string> filters;
+        hsize_t storageSize = 0;                // bytes allocated in the file
+        hsize_t rawSize = 0;                    // bytes of the uncompressed data; 0 for variable-length types
+    };
+
+    /** Index of all links of a file, written by `Dump()` with `WriterOptions::catalog`. */
+    inline constexpr const char *CatalogDataset = "/.easyhdf5/catalog";
+    /** Attribute of `CatalogDataset`: 1 while it lists the whole file, 0 once the file changed without it being rewritten. */
+    inline constexpr const char *CatalogCompleteAttribute = "complete";
+
+    /** One link of a file, as listed by a `Catalog`. */
+    struct CatalogEntry
+    {
+        std::string path;                       // absolute, e.g. "/group/element"
+        H5O_type_t type = H5O_TYPE_UNKNOWN;     // H5O_TYPE_UNKNOWN for soft and external links
+        H5L_type_t link = H5L_TYPE_HARD;
+
+        // datasets only
+        std::vector<hsize_t> dims;
+        std::string typeName;
+        std::string layout;                     // as in `ObjectInfo`
+    };
+
+    /**
+    All links of a file, listed in one pass over the file (`BuildCatalog()`) or read back from `CatalogDataset`,
+    so existence checks and group listings are hash lookups instead of walks through the file.
+    */
+    struct Catalog
+    {
+        std::vector<CatalogEntry> entries;
+        std::unordered_map<std::string, size_t> index;                          // path -> entry
+        std::unordered_map<std::string, std::vector<std::string>> children;     // group path -> names of its links, in name order
+
+        /** Adds `entry`, and its name to the listing of its group unless it is `InternalGroup`. */
+        void Add(CatalogEntry entry);
+
+        /** Entry at `path`, with or without the leading "/"; nullptr if the catalog has none. */
+        const CatalogEntry *Find(const std::string &path) const;
+
+        /** Names of the links of the group at `path`; nullptr if the catalog has no such group. */
+        const std::vector<std::string> *Children(const std::string &path) const;
+
+        /**
+        False if `path` goes through a soft or external link: the catalog only lists what is reached through hard links,
+        so such paths have to be resolved in the file.
+        */
+        bool Covers(const std::string &path) const;
+    };
+
+    /** Lists the links of `file` in one visit, except `CatalogDataset` itself. */
+    Catalog BuildCatalog(const H5::H5File &file);
+
+    /** Writes `catalog` to `CatalogDataset` as a single dataset of records, rewriting an earlier one in place. */
+    void WriteCatalog(H5::H5File &file, const Catalog &catalog);
+
+    /** Reads `CatalogDataset` into `catalog`; false if the file has none, or one marked incomplete. */
+    bool ReadCatalog(const H5::H5File &file, Catalog &catalog);
+
+    /** Marks `CatalogDataset`, if any, incomplete in place, once the file is about to change without it being rewritten. */
+    void InvalidateCatalog(H5::H5File &file);
+
+    /** What deduplication saved, as returned by `HDF5Writer::DedupStatistics()`. */
+    struct DedupStats
+    {
+        size_t hardLinks = 0;           // elements linked to an identical element of the same file
+        size_t externalLinks = 0;       // elements linked to an identical element of a previous dump
+        uint64_t bytesSaved = 0;        // payload bytes of the linked elements
+    };
+
+    /**
+    Interval of values selected by `HDF5Reader::ReadWhere()`. Each bound is inclusive or exclusive; NaN never matches.
+    */
+    template<typename T>
+    struct ValueRange
+    {
+        static_assert(std::is_arithmetic_v<T>, "ValueRange: values must be numeric");
+
+        T low = Lowest();
+        T high = Highest();
+        bool lowInclusive = true;
+        bool highInclusive = true;
+
+        static ValueRange Above(T value) { return ValueRange{value, Highest(), false, true}; }
+        static ValueRange AtLeast(T value) { return ValueRange{value, Highest(), true, true}; }
+        static ValueRange Below(T value) { return ValueRange{Lowest(), value, true, false}; }
+        static ValueRange AtMost(T value) { return ValueRange{Lowest(), value, true, true}; }
+        static ValueRange Between(T low, T high) { return ValueRange{low, high, true, true}; }
+        static ValueRange Equal(T value) { return ValueRange{value, value, true, true}; }
+
+        bool Contains(T value) const
+        {
+            return (lowInclusive ? low <= value : low < value) and (highInclusive ? value <= high : value < high);
+        }
+
+        /** True if some value in [`min`, `max`] may match; never if `max` < `min` (e.g. a block of NaNs). */
+        bool Overlaps(T min, T max) const
+        {
+            return min <= max and (lowInclusive ? low <= max : low < max) and (highInclusive ? min <= high : min < high);
+        }
+
+    private:
+        static constexpr T Lowest(void)
+        {
+            if constexpr(std::numeric_limits<T>::has_infinity)
+                return -std::numeric_limits<T>::infinity();
+            else
+                return std::numeric_limits<T>::lowest();
+        }
+
+        static constexpr T Highest(void)
+        {
+            if constexpr(std::numeric_limits<T>::has_infinity)
+                return std::numeric_limits<T>::infinity();
+            else
+                return std::numeric_limits<T>::max();
+        }
+    };
+
+    /** Blocks of an element scanned by `HDF5Reader::ReadWhere()`. */
+    struct ScanStats
+    {
+        size_t blocks = 0;              // blocks of the element
+        size_t blocksRead = 0;          // blocks read and filtered; the others were skipped by the zone map
+        bool zoneMap = false;           // whether the element has a zone map
+    };
+
+    /**
+    Short readable name of an HDF5 type, e.g. "int32", "float64", "string", "{x: float64, id: int32}", "vlen<float64>".
+    */
+    std::string DescribeType(hid_t type);
+
+    /** Name of a dataset layout: "compact", "contiguous", "chunked" or "virtual". */
+    std::string DescribeLayout(H5D_layout_t layout);
+
+    /**
+    `layout` completed for `filename`: when opening (not `create`), a `Default` driver becomes the one the existing files
+    were written with, and `alignToFilesystem` becomes the block size of the file's directory.
+    */
+    FileLayout ResolveFileLayout(const std::string &filename, FileLayout layout, bool create);
+
+    /**
+    File access properties of `layout`. When opening (not `create`), a family is opened with the member size of its first file.
+    Throws for the direct driver if the library was built without it.
+    */
+    H5::FileAccPropList FileAccess(const FileLayout &layout, bool create);
+
+    /** Records `layout` in attributes of `InternalGroup`, unless it is all defaults. */
+    void WriteFileLayout(H5::H5File &file, const FileLayout &layout);
+
+    /** Layout recorded in `file` by `WriteFileLayout()`, or `fallback` if none is. */
+    FileLayout ReadFileLayout(const H5::H5File &file, const FileLayout &fallback);
+
     std::vector<std::string> splitPath(const std::string &path);
 
     H5::Group openGroupPath(H5::H5File &file, const std::string &groupPath, bool create = false);
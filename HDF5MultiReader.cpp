@@ -0,0 +1,63 @@
+#include "HDF5MultiReader.hpp"
+
+HDF5MultiReader::HDF5MultiReader(size_t maxOpenFiles, const HDF5Utils::ReaderOptions &options)
+    : maxOpenFiles_(maxOpenFiles), options_(options)
+{
+    if(maxOpenFiles < 1)
+    {
+        throw std::runtime_error("HDF5MultiReader: the pool must hold at least one file");
+    }
+    if(this->options_.elinkFileCacheSize == 0)
+    {
+        this->options_.elinkFileCacheSize = LinkCacheSize;
+    }
+}
+
+HDF5Reader &HDF5MultiReader::File(const std::string &filename)
+{
+    auto it = this->index_.find(filename);
+    if(it != this->index_.end())
+    {
+        this->lru_.splice(this->lru_.begin(), this->lru_, it->second);
+        return it->second->second;
+    }
+
+    // open first, so a failing open leaves the pool untouched
+    HDF5Reader reader(filename, this->options_);
+    if(this->lru_.size() >= this->maxOpenFiles_)
+    {
+        this->index_.erase(this->lru_.back().first);
+        this->lru_.pop_back();
+    }
+    this->lru_.emplace_front(filename, std::move(reader));
+    this->index_[filename] = this->lru_.begin();
+    return this->lru_.front().second;
+}
+
+bool HDF5MultiReader::Exists(const std::string &location)
+{
+    auto [filename, path] = SplitLocation(location);
+    return this->File(filename).Exists(path);
+}
+
+std::vector<std::string> HDF5MultiReader::ReadGroupNames(const std::string &location)
+{
+    auto [filename, path] = SplitLocation(location);
+    return this->File(filename).ReadGroupNames(path);
+}
+
+void HDF5MultiReader::Clear(void)
+{
+    this->index_.clear();
+    this->lru_.clear();
+}
+
+std::pair<std::string, std::string> HDF5MultiReader::SplitLocation(const std::string &location)
+{
+    const size_t separator = location.rfind(":/");
+    if(separator == std::string::npos or separator == 0)
+    {
+        throw std::runtime_error("HDF5MultiReader: expected \"file:/path\", got \"" + location + "\"");
+    }
+    return {location.substr(0, separator), location.substr(separator + 1)};
+}
@@ -0,0 +1,94 @@
+#ifndef HDF5MULTIREADER_HPP
+#define HDF5MULTIREADER_HPP
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include "HDF5Reader.hpp"
+
+/**
+Reads elements across many files, addressed as `"file.h5:/path"`.
+Keeps at most `maxOpenFiles` files open and closes the least recently used one when the pool is full.
+Each pooled file also caches the files reached through its external links, so up to
+`maxOpenFiles * (1 + elinkFileCacheSize)` files are open at once (320 with the defaults).
+*/
+class HDF5MultiReader
+{
+public:
+    /**
+    Files reached through external links that each pooled file keeps open when `ReaderOptions::elinkFileCacheSize` is 0.
+    Small, so a full pool stays well below the usual limit of 1024 open files.
+    */
+    static constexpr unsigned LinkCacheSize = 4;
+
+    /**
+    `options` apply to every file; if `options.elinkFileCacheSize` is 0 the external-link cache of each file holds
+    `LinkCacheSize` files.
+    */
+    HDF5MultiReader(size_t maxOpenFiles = 64, const HDF5Utils::ReaderOptions &options = HDF5Utils::ReaderOptions());
+
+    /**
+    Returns the reader of `filename`, opening it if it is not in the pool.
+    The reference is invalidated when the file is evicted from the pool.
+    */
+    HDF5Reader &File(const std::string &filename);
+
+    /**
+    Reads the element at `location` (`"file.h5:/path"`) into `data`.
+    */
+    template<typename T>
+    void ReadElement(const std::string &location, T &data);
+
+    /**
+    Reads the element at `path` in `filename` into `data`.
+    */
+    template<typename T>
+    void ReadElement(const std::string &filename, const std::string &path, T &data);
+
+    /**
+    Checks if the element at `location` (`"file.h5:/path"`) exists.
+    */
+    bool Exists(const std::string &location);
+
+    /**
+    Reads the names of the groups at `location` (`"file.h5:/path"`).
+    */
+    std::vector<std::string> ReadGroupNames(const std::string &location);
+
+    /**
+    Closes all pooled files.
+    */
+    void Clear(void);
+
+    size_t OpenFiles(void) const { return lru_.size(); }
+
+    /**
+    Splits `"file.h5:/path"` into file name and path, at the last `":/"`.
+    */
+    static std::pair<std::string, std::string> SplitLocation(const std::string &location);
+
+private:
+    size_t maxOpenFiles_;
+    HDF5Utils::ReaderOptions options_;
+    // most recently used first
+    std::list<std::pair<std::string, HDF5Reader>> lru_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, HDF5Reader>>::iterator> index_;
+};
+
+template<typename T>
+void HDF5MultiReader::ReadElement(const std::string &location, T &data)
+{
+    auto [filename, path] = SplitLocation(location);
+    this->File(filename).ReadElement(path, data);
+}
+
+template<typename T>
+void HDF5MultiReader::ReadElement(const std::string &filename, const std::string &path, T &data)
+{
+    this->File(filename).ReadElement(path, data);
+}
+
+#endif // HDF5MULTIREADER_HPP
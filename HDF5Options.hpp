@@ -0,0 +1,269 @@
+#ifndef HDF5OPTIONS_HPP
+#define HDF5OPTIONS_HPP
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+
+namespace HDF5Utils
+{
+    /** On-disk precision of floating-point elements. */
+    enum class StoragePrecision
+    {
+        Native,     // same as the in-memory type
+        Float32     // double (and wider) values are stored as 32-bit floats
+    };
+
+    /** On-disk layout of compound (struct) elements. */
+    enum class CompoundLayout
+    {
+        Packed,     // members stored without padding (H5Tpack); repacked by the library in bounded blocks
+        Native,     // same layout as the in-memory struct, written and read without any conversion
+        Columnar    // a group with one dataset per member (struct of arrays); ignored for appendable elements
+    };
+
+    /** How an incremental `HDF5Writer::Dump()` decides that an element changed since the previous dump. */
+    enum class ChangeTracking
+    {
+        Hash,       // hash the element's contents on every dump
+        DirtyFlag   // rewrite only after `HDF5Writer::MarkDirty()`
+    };
+
+    /** On-disk encoding of string elements. */
+    enum class StringEncoding
+    {
+        VariableLength,     // one variable-length string per entry
+        Dictionary          // an enum type listing the distinct strings, and one small integer code per entry
+    };
+
+    /** How each level of a pyramid reduces blocks of the previous one. */
+    enum class PyramidReduction
+    {
+        Mean,       // average (integer elements get float64 levels)
+        Max,        // maximum, e.g. to keep peaks visible
+        Stride      // first element of each block (plain decimation)
+    };
+
+    /**
+    Per-element storage options, passed to `HDF5Writer::AddElement()` / `WriteElement()`.
+    Filters need a chunked layout, so they only apply to non-empty rectangular elements; VLEN (jagged) elements are stored as-is.
+    The reader converts back to the in-memory type, so no read-side options are needed.
+    */
+    struct ElementOptions
+    {
+        StoragePrecision precision = StoragePrecision::Native;
+
+        /**
+        Scale-offset filter. For floating-point data this is the number of decimal digits kept after the point,
+        for integer data the minimum number of bits per value (0 lets HDF5 compute it). Negative disables the filter.
+        */
+        int scaleOffset = -1;
+
+        /**
+        N-bit filter. For integer data this is the number of significant bits stored per value,
+        for floating-point data the number of mantissa bits kept. 0 disables the filter.
+        */
+        int nbitPrecision = 0;
+
+        CompoundLayout compoundLayout = CompoundLayout::Packed;
+
+        /** Rows (first dimension) per chunk when the element is chunked. 0 picks chunks of about 1 MiB. */
+        hsize_t chunkRows = 0;
+
+        ChangeTracking changeTracking = ChangeTracking::Hash;
+
+        /** Create the dataset chunked with an unlimited first dimension, so `HDF5Writer::AppendElement()` can grow it. */
+        bool appendable = false;
+
+        /**
+        Encoding of rectangular string elements. `Dictionary` suits low-cardinality labels; it falls back to variable-length
+        strings when the distinct strings do not fit in an enum type (`HDF5Utils::DictionaryMaxBytes`) and is ignored
+        for appendable elements.
+        */
+        StringEncoding stringEncoding = StringEncoding::VariableLength;
+
+        /**
+        Number of decimated levels stored with a numeric rectangular element, for previews (`HDF5Reader::ReadLevel()`).
+        Level k halves every dimension of level k - 1 (rounding up) by reducing blocks of 2 x 2 (x 2 ...) elements with
+        `pyramidReduction`; levels stop once every dimension is 1. They are stored under `HDF5Utils::PyramidGroup`, with the
+        element's precision but without its filters. 0 (the default) stores none; ignored for appendable elements.
+        */
+        unsigned pyramidLevels = 0;
+        PyramidReduction pyramidReduction = PyramidReduction::Mean;
+
+        /**
+        Rows (first dimension) per block of the zone map of a numeric rectangular element: the minimum and maximum of every
+        block, stored under `HDF5Utils::ZoneMapGroup` so `HDF5Reader::ReadWhere()` only reads the blocks that may match.
+        Best set to `chunkRows` for filtered elements, so skipped blocks are whole chunks. The ranges are those of the values as
+        stored with Float32 or `nbitPrecision`; a `scaleOffset` that rounds values is rejected. 0 (the default) stores none;
+        ignored for appendable elements.
+        */
+        hsize_t zoneMapRows = 0;
+    };
+
+    /** How `HDF5Writer::WriteBlocks()` and `WriteRange()` produce and write an element. */
+    struct BlockWriteOptions
+    {
+        /**
+        Size of the buffer one block of rows is produced into, rounded to whole rows, and to whole chunks and zone map blocks
+        where the element has them. At least one row (or chunk) is produced at a time.
+        */
+        size_t blockBytes = size_t(64) << 20;
+
+        /**
+        Produce the next block on a worker thread while the current one is written, with two buffers.
+        The producer then runs outside the calling thread, one block at a time and in order.
+        */
+        bool pipelined = false;
+    };
+
+    /** Low-level driver through which a file is created and opened. */
+    enum class FileDriver
+    {
+        Default,    // sec2: a single file through POSIX I/O
+        Direct,     // O_DIRECT, bypassing the page cache; needs an HDF5 library built with the direct driver
+        Split,      // metadata in `<name><metaExtension>`, raw data in `<name><rawExtension>`
+        Family      // member files of `familyMemberBytes`; the name holds a printf "%d" for the member number, e.g. "dump-%d.h5"
+    };
+
+    /**
+    Driver and allocation settings of a file (`WriterOptions::layout`). The writer records them in the file, and `HDF5Reader`
+    detects family and split files by name, so they are reopened without repeating the settings.
+    */
+    struct FileLayout
+    {
+        FileDriver driver = FileDriver::Default;
+
+        /**
+        Objects of at least `alignmentThreshold` bytes start at a multiple of `alignment` bytes (`H5Pset_alignment`),
+        e.g. the stripe size of a parallel filesystem. 0 disables the alignment. Every aligned object may leave up to
+        `alignment` bytes of padding before it, so the threshold keeps small objects (scalars, short vectors, compact
+        metadata) packed; lower it only if small objects are read often enough to be worth a stripe each.
+        */
+        hsize_t alignment = 0;
+        hsize_t alignmentThreshold = hsize_t(1) << 16;
+
+        /** Align to the block size the filesystem reports for the file's directory (the stripe size on Lustre) if `alignment` is 0. */
+        bool alignToFilesystem = false;
+
+        /**
+        Size of the blocks small metadata is aggregated into (`H5Pset_meta_block_size`), so it is not interleaved
+        with raw data in many small pieces. 0 keeps the library default of 2 KiB.
+        */
+        hsize_t metadataBlockBytes = 0;
+
+        /** Family driver: size of each member file. */
+        hsize_t familyMemberBytes = hsize_t(1) << 30;
+
+        /** Split driver: suffixes of the metadata and raw data files. */
+        std::string metaExtension = "-m.h5";
+        std::string rawExtension = "-r.h5";
+
+        /** Direct driver: alignment of memory buffers, file system block size, and size of the copy buffer for unaligned requests. */
+        size_t directAlignment = 4096;
+        size_t directBlockSize = 4096;
+        size_t directCopyBuffer = size_t(16) << 20;
+    };
+
+    /** File-level options of `HDF5Writer`. */
+    struct WriterOptions
+    {
+        bool truncate = true;
+
+        /**
+        Keep the file open after `Dump()` so it can be called again. Later dumps skip elements that did not change
+        and overwrite elements of the same shape and type in place.
+        */
+        bool incremental = false;
+
+        /**
+        Single-writer/multiple-reader mode. The file is created with the latest file format, `Dump()` switches it to SWMR
+        writing and keeps it open, and `AppendElement()` flushes at most every `swmrFlushInterval` seconds.
+        No new objects can be created once SWMR writing started; existing datasets can be appended to or overwritten in place.
+        HDF5 does not support variable-length data (strings, jagged elements) under SWMR.
+        */
+        bool swmr = false;
+        double swmrFlushInterval = 1.0;
+
+        /**
+        Deduplicate elements by content. An element whose type, storage options and contents hash like an element already
+        written to the file becomes a hard link to it, and one matching an element of a `dedupSources` file an external link.
+        The hashes of the written elements are saved at `HDF5Utils::DedupIndexGroup`, so later dumps can link to them.
+        Appendable elements and elements with pyramid levels or zone maps are always written; ignored in SWMR mode.
+        */
+        bool deduplicate = false;
+
+        /**
+        Files of previous dumps written with `deduplicate`, searched for elements to link to. Relative names are resolved
+        against the directory of the file being written, as HDF5 resolves the external links.
+        */
+        std::vector<std::string> dedupSources;
+
+        /** Elements with fewer payload bytes are always written: a link costs about as much as a small dataset. */
+        size_t dedupMinBytes = 1024;
+
+        /** File driver and alignment. SWMR needs the default or direct driver. */
+        FileLayout layout;
+
+        /**
+        Write a catalog of all objects of the file (`HDF5Utils::CatalogDataset`) at every `Dump()`, so readers load it in one
+        read instead of walking the file. Ignored in SWMR mode. Writing outside `Dump()`, or reopening the file without
+        truncation, marks the catalog incomplete in place, so readers walk the file until `Dump()` or `Close()` rewrites it.
+        */
+        bool catalog = false;
+    };
+
+    /** How `HDF5ShardedWriter` runs its per-shard writers. */
+    enum class ShardWorkers
+    {
+        Processes,  // one forked process per shard (POSIX), so shards are written in parallel; needs no HDF5 object open in the caller
+        Threads     // one thread per shard; the HDF5 library runs one call at a time, so only what happens outside it overlaps
+                    // (gathering the rows of partitioned nested vectors); write bandwidth scales with Processes only
+    };
+
+    /** When `HDF5Reader` lists the objects of a file in a `HDF5Utils::Catalog`. */
+    enum class CatalogMode
+    {
+        Off,        // `Exists()` and `ReadGroupNames()` query the file each time
+        Lazy,       // on the first `Exists()` or `ReadGroupNames()`, which then answer from the catalog
+        Eager       // in `Load()`
+    };
+
+    /** Options of `HDF5Reader`. */
+    struct ReaderOptions
+    {
+        /** Open with `H5F_ACC_SWMR_READ` to follow a file written in SWMR mode; dataset extents are refreshed on every read. */
+        bool swmr = false;
+
+        /**
+        Serve `ReadElement()` from several threads. Contiguous and unfiltered chunked numeric datasets are located once
+        under a lock and then read with `pread` and converted outside the HDF5 library; all other reads take the lock.
+        Needs the default (sec2) file driver and is ignored together with `swmr`.
+        */
+        bool concurrent = false;
+
+        /** Threads used to fetch a single large dataset in concurrent mode. */
+        unsigned readThreads = 1;
+
+        /**
+        Number of files reached through external links that stay open (`H5Pset_elink_file_cache_size`),
+        so following a link does not reopen its target file every time. 0 disables the cache.
+        */
+        unsigned elinkFileCacheSize = 0;
+
+        /**
+        Driver to open the file with. With `FileDriver::Default`, a name that is not an existing file is opened as a family
+        if it holds a "%", or as a split file if `<name><metaExtension>` exists; other settings (alignment, sizes) are not needed to read.
+        */
+        FileLayout layout;
+
+        /**
+        Answer `Exists()` and `ReadGroupNames()` from a catalog of the file, read from `HDF5Utils::CatalogDataset` if the writer
+        stored one, else built in one pass over the file. Paths through soft and external links are still resolved in the file.
+        Ignored together with `swmr`, as the file keeps changing.
+        */
+        CatalogMode catalog = CatalogMode::Off;
+    };
+}
+
+#endif // HDF5OPTIONS_HPP
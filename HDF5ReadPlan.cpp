@@ -0,0 +1,282 @@
+#include "HDF5ReadPlan.hpp"
+
+namespace
+{
+    std::string FormatDims(const std::vector<hsize_t> &dims)
+    {
+        std::string text = "[";
+        for(size_t i = 0; i < dims.size(); ++i)
+        {
+            text += (i > 0 ? " x " : "") + std::to_string(dims[i]);
+        }
+        return text + "]";
+    }
+
+    // Opens the dataset or group at `path` without printing the error stack if it does not exist.
+    hid_t OpenObject(const H5::H5File &file, const std::string &path)
+    {
+        hid_t id = H5I_INVALID_HID;
+        H5E_BEGIN_TRY
+        {
+            id = H5Oopen(file.getId(), path.c_str(), H5P_DEFAULT);
+        }
+        H5E_END_TRY;
+        return id;
+    }
+}
+
+HDF5ReadPlan::GroupSchema HDF5ReadPlan::ReadGroupSchema(const H5::Group &group)
+{
+    GroupSchema schema;
+    if(group.attrExists(HDF5Utils::LayoutAttribute))
+    {
+        const H5::Attribute attribute = group.openAttribute(HDF5Utils::LayoutAttribute);
+        attribute.read(attribute.getStrType(), schema.layout);
+    }
+    if(group.attrExists(HDF5Utils::ShapeAttribute))
+    {
+        const H5::Attribute attribute = group.openAttribute(HDF5Utils::ShapeAttribute);
+        schema.shape.resize(attribute.getSpace().getSimpleExtentNpoints());
+        attribute.read(HDF5Utils::HDF5Type<hsize_t>::value(), schema.shape.data());
+    }
+    for(hsize_t n = 0; n < group.getNumObjs(); ++n)
+    {
+        Member member;
+        member.name = group.getObjnameByIdx(n);
+        if(group.childObjType(member.name) == H5O_TYPE_DATASET)
+        {
+            const H5::DataSet dataset = group.openDataSet(member.name);
+            const H5::DataSpace space = dataset.getSpace();
+            member.dims.resize(space.getSimpleExtentNdims());
+            space.getSimpleExtentDims(member.dims.data());
+            member.fileType = dataset.getDataType();
+            member.dataset = true;
+        }
+        schema.members.push_back(std::move(member));
+    }
+    return schema;
+}
+
+HDF5ReadPlan::~HDF5ReadPlan()
+{
+    this->Release();
+}
+
+void HDF5ReadPlan::Compile(const HDF5Reader &reader)
+{
+    if(not reader.loaded_)
+    {
+        throw std::runtime_error("HDF5ReadPlan: Load() must be called on the reader before Compile()");
+    }
+    std::unique_lock<std::mutex> lock;
+    if(reader.concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(reader.concurrent_->mutex);
+    }
+
+    this->Release();
+    this->compiled_ = false;
+    for(Entry &entry : this->entries_)
+    {
+        const hid_t id = OpenObject(reader.file_, entry.path);
+        if(id < 0)
+        {
+            throw std::runtime_error("HDF5ReadPlan: element does not exist: " + entry.path);
+        }
+        entry.objectType = H5Iget_type(id);
+        entry.dims.clear();
+        entry.fileType = H5::DataType();
+        entry.schema = GroupSchema();
+        entry.direct = false;
+        if(entry.objectType == H5I_DATASET)
+        {
+            const H5::DataSet dataset(id);
+            H5Oclose(id);
+            const H5::DataSpace space = dataset.getSpace();
+            entry.dims.resize(space.getSimpleExtentNdims());
+            space.getSimpleExtentDims(entry.dims.data());
+            entry.current = entry.dims;
+            entry.fileType = dataset.getDataType();
+            entry.direct = entry.target->Prepare(dataset, entry.dims);
+        }
+        else if(entry.objectType == H5I_GROUP)
+        {
+            const H5::Group group(id);
+            H5Oclose(id);
+            entry.schema = ReadGroupSchema(group);
+        }
+        else
+        {
+            H5Oclose(id);
+        }
+    }
+    this->compiled_ = true;
+}
+
+void HDF5ReadPlan::Open(const HDF5Reader &reader, Entry &entry)
+{
+    const hid_t id = OpenObject(reader.file_, entry.path);
+    if(id < 0)
+    {
+        throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " does not exist");
+    }
+    if(H5Iget_type(id) != entry.objectType)
+    {
+        H5Oclose(id);
+        throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " changed its object type");
+    }
+    if(entry.objectType != H5I_DATASET)
+    {
+        H5Oclose(id);
+        return;
+    }
+    entry.dataset = H5::DataSet(id);
+    H5Oclose(id);
+
+    const hid_t type_id = H5Dget_type(entry.dataset.getId());
+    const bool same_type = H5Tequal(type_id, entry.fileType.getId()) > 0;
+    H5Tclose(type_id);
+    if(not same_type)
+    {
+        throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " is no longer of type " +
+                                 HDF5Utils::DescribeType(entry.fileType.getId()));
+    }
+}
+
+void HDF5ReadPlan::CheckShape(const HDF5Reader &reader, Entry &entry)
+{
+    if(entry.objectType == H5I_GROUP)
+    {
+        // the members of a columnar or sparse element are read by ReadElement() after the direct reads, so check them now
+        const hid_t id = OpenObject(reader.file_, entry.path);
+        if(id < 0)
+        {
+            throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " does not exist");
+        }
+        const H5::Group group(id);
+        H5Oclose(id);
+        const GroupSchema schema = ReadGroupSchema(group);
+        if(schema.layout != entry.schema.layout)
+        {
+            throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " is no longer a " +
+                                     (entry.schema.layout.empty() ? std::string("plain") : entry.schema.layout) + " group");
+        }
+        if(schema.shape != entry.schema.shape)
+        {
+            throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " has a different shape than " + FormatDims(entry.schema.shape));
+        }
+        if(schema.members.size() != entry.schema.members.size())
+        {
+            throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " has different members");
+        }
+        const bool columnar = entry.schema.layout == HDF5Utils::ColumnarLayout;
+        for(size_t m = 0; m < schema.members.size(); ++m)
+        {
+            const Member &expected = entry.schema.members[m];
+            const Member &found = schema.members[m];
+            const std::string path = entry.path + "/" + expected.name;
+            if(found.name != expected.name or found.dataset != expected.dataset)
+            {
+                throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " has different members");
+            }
+            if(expected.dataset and H5Tequal(found.fileType.getId(), expected.fileType.getId()) <= 0)
+            {
+                throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + path + " is no longer of type " +
+                                         HDF5Utils::DescribeType(expected.fileType.getId()));
+            }
+            // the members of a sparse element grow with the number of nonzeros
+            if(columnar and found.dims != expected.dims)
+            {
+                throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + path + " has a different shape than " + FormatDims(expected.dims));
+            }
+        }
+        return;
+    }
+    if(entry.objectType != H5I_DATASET)
+    {
+        return;
+    }
+    if(reader.options_.swmr)
+    {
+        H5Drefresh(entry.dataset.getId());
+    }
+    const hid_t space_id = H5Dget_space(entry.dataset.getId());
+    const int ndims = H5Sget_simple_extent_ndims(space_id);
+    const bool same_rank = ndims == static_cast<int>(entry.dims.size());
+    if(same_rank)
+    {
+        H5Sget_simple_extent_dims(space_id, entry.current.data(), nullptr);
+    }
+    H5Sclose(space_id);
+    if(not same_rank or entry.current != entry.dims)
+    {
+        throw std::runtime_error("HDF5ReadPlan: schema mismatch: " + entry.path + " has a different shape than " + FormatDims(entry.dims));
+    }
+}
+
+void HDF5ReadPlan::Release(void)
+{
+    for(Entry &entry : this->entries_)
+    {
+        entry.dataset = H5::DataSet();
+    }
+    this->fileId_ = H5I_INVALID_HID;
+}
+
+void HDF5ReadPlan::Run(const HDF5Reader &reader)
+{
+    if(not reader.loaded_)
+    {
+        throw std::runtime_error("HDF5ReadPlan: Load() must be called on the reader before Run()");
+    }
+    if(not this->compiled_)
+    {
+        this->Compile(reader);
+    }
+    const HDF5Utils::ScopedMemoryResource scope(reader.memoryResource_);
+    {
+        std::unique_lock<std::mutex> lock;
+        if(reader.concurrent_)
+        {
+            lock = std::unique_lock<std::mutex>(reader.concurrent_->mutex);
+        }
+        try
+        {
+            // the whole schema is checked before anything is read
+            const hid_t file_id = reader.file_.getId();
+            if(file_id != this->fileId_)
+            {
+                this->Release();
+                for(Entry &entry : this->entries_)
+                {
+                    this->Open(reader, entry);
+                }
+                this->fileId_ = file_id;
+            }
+            for(Entry &entry : this->entries_)
+            {
+                this->CheckShape(reader, entry);
+            }
+            for(Entry &entry : this->entries_)
+            {
+                if(entry.direct)
+                {
+                    entry.target->Read(entry.dataset);
+                }
+            }
+        }
+        catch(...)
+        {
+            this->Release();
+            throw;
+        }
+    }
+    // ReadElement() takes the reader's lock itself; the schema of these elements was checked above
+    for(Entry &entry : this->entries_)
+    {
+        if(not entry.direct)
+        {
+            entry.target->ReadElement(reader, entry.path);
+        }
+    }
+}
@@ -0,0 +1,251 @@
+#ifndef HDF5READPLAN_HPP
+#define HDF5READPLAN_HPP
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "HDF5Reader.hpp"
+
+/**
+Reads the same elements, into the same destinations, from many files with an identical schema (e.g. one file per time step).
+The plan is compiled once against a first file: it caches the memory and file types and the shapes, and sizes the destinations.
+Each `Run()` then checks the schema of the file and reads numeric and compound rectangular elements straight into
+the destinations, without walking groups or allocating; other elements (strings, jagged, columnar, sparse) go through
+`HDF5Reader::ReadElement()` after them. The schema check covers these too, including the layout, shape and members
+of columnar and sparse groups, so a mismatching file is rejected before any destination is written; only an I/O error
+while reading one of them can leave the directly read destinations already updated. The datasets stay open until a run on
+another file, so repeated runs on the same file (e.g. one followed in SWMR mode) only check the extents before reading.
+*/
+class HDF5ReadPlan
+{
+public:
+    HDF5ReadPlan() = default;
+
+    ~HDF5ReadPlan();
+
+    HDF5ReadPlan(const HDF5ReadPlan&) = delete;
+    HDF5ReadPlan &operator=(const HDF5ReadPlan&) = delete;
+
+    /**
+    Adds the element at `path`, read into `data` by every `Run()`. `data` MUST stay accessible while the plan is used.
+    */
+    template<typename T>
+    void Add(const std::string &path, T &data);
+
+    /**
+    Compiles the plan against the file of `reader`: every element must exist there. Called by the first `Run()`.
+    */
+    void Compile(const HDF5Reader &reader);
+
+    /**
+    Reads all elements from the file of `reader`. Throws before reading anything if an element is missing or differs
+    in shape or type from the file the plan was compiled against; for a columnar or sparse element, if its layout,
+    logical shape or the names and types of its member datasets differ (and the shapes of the columns).
+    */
+    void Run(const HDF5Reader &reader);
+
+    /**
+    Closes the datasets kept open since the last `Run()`. HDF5 keeps a file open while any of its objects is,
+    so call this before reopening that file for writing.
+    */
+    void Release(void);
+
+    bool Compiled(void) const { return compiled_; }
+
+    size_t Size(void) const { return entries_.size(); }
+
+private:
+    // Destination of one element, typed by Add().
+    struct Target
+    {
+        virtual ~Target() = default;
+        // Sizes the destination for `dataset` and returns true if it can be read directly by Read().
+        virtual bool Prepare(const H5::DataSet &dataset, const std::vector<hsize_t> &dims) = 0;
+        virtual void Read(const H5::DataSet &dataset) = 0;
+        virtual void ReadElement(const HDF5Reader &reader, const std::string &path) = 0;
+    };
+
+    template<typename T>
+    struct TypedTarget;
+
+    // Dataset in the group of a columnar or sparse element.
+    struct Member
+    {
+        std::string name;
+        H5::DataType fileType;
+        std::vector<hsize_t> dims;
+        bool dataset = false;                  // false for a subgroup
+    };
+
+    // Schema of the group of a columnar or sparse element.
+    struct GroupSchema
+    {
+        std::string layout;                    // value of LayoutAttribute
+        std::vector<hsize_t> shape;            // value of ShapeAttribute, if any
+        std::vector<Member> members;           // in name order
+    };
+
+    struct Entry
+    {
+        std::string path;
+        std::unique_ptr<Target> target;
+        H5I_type_t objectType = H5I_BADID;     // dataset or group (columnar or sparse element)
+        std::vector<hsize_t> dims;
+        std::vector<hsize_t> current;          // dimensions in the file being read
+        H5::DataType fileType;
+        GroupSchema schema;
+        bool direct = false;
+        H5::DataSet dataset;                   // open in the file of the last Run()
+    };
+
+    static GroupSchema ReadGroupSchema(const H5::Group &group);
+
+    // Opens the object of `entry` in the file of `reader` and checks its type against the compiled schema.
+    void Open(const HDF5Reader &reader, Entry &entry);
+
+    // Checks the current extent of the open dataset, or the schema of the open group, of `entry` against the compiled schema.
+    void CheckShape(const HDF5Reader &reader, Entry &entry);
+
+    std::vector<Entry> entries_;
+    hid_t fileId_ = H5I_INVALID_HID;           // file of the open datasets
+    bool compiled_ = false;
+};
+
+template<typename T>
+struct HDF5ReadPlan::TypedTarget : HDF5ReadPlan::Target
+{
+    using Scalar = typename HDF5Utils::InnerType<T>::type;
+    static constexpr int levels = HDF5Utils::IsContainer<T>::value ? HDF5Utils::Rank<T>::value - 1 : 0;
+    static constexpr bool compound = HDF5Utils::HasCompType<Scalar>::value;
+    static constexpr bool numeric = std::is_arithmetic_v<Scalar> and not std::is_same_v<Scalar, bool>;
+
+    explicit TypedTarget(T &data) : data(data) {}
+
+    bool Prepare(const H5::DataSet &dataset, const std::vector<hsize_t> &dims) override
+    {
+        if constexpr(not compound and not numeric)
+        {
+            return false;
+        }
+        else
+        {
+            const H5T_class_t type_class = dataset.getTypeClass();
+            if(compound ? type_class != H5T_COMPOUND : (type_class != H5T_INTEGER and type_class != H5T_FLOAT))
+            {
+                return false;
+            }
+            if((levels == 0) != dims.empty() or (levels > 1 and dims.size() != static_cast<size_t>(levels)))
+            {
+                return false;
+            }
+
+            if constexpr(compound)
+                this->memType = H5::DataType(HDF5Utils::CompTypeCreator<Scalar>::get());
+            else
+                this->memType = H5::DataType(HDF5Utils::HDF5Type<Scalar>::value());
+            this->dims = dims;
+            this->total = 1;
+            for(hsize_t d : dims)
+            {
+                this->total *= d;
+            }
+            if constexpr(compound)
+            {
+                this->fileType = dataset.getDataType();
+                this->copyPlan = HDF5Utils::CompoundCopyPlan();
+                if(H5Tequal(this->fileType.getId(), this->memType.getId()) <= 0)
+                {
+                    this->copyPlan = HDF5Utils::BuildCompoundCopyPlan(this->fileType.getId(), this->memType.getId());
+                    this->staging.resize(HDF5Reader_detail::CompoundStagingBytes(dims, this->copyPlan.srcSize));
+                }
+            }
+            if constexpr(levels == 1)
+            {
+                HDF5Utils::ContainerResize(this->data, this->total);
+            }
+            else if constexpr(levels > 1)
+            {
+                this->flat.assign(this->total, Scalar());
+                HDF5Reader_detail::FillRectangularRecords(this->data, dims, [](Scalar*, size_t) {});
+            }
+            return true;
+        }
+    }
+
+    void Read(const H5::DataSet &dataset) override
+    {
+        if constexpr(compound or numeric)
+        {
+            Scalar *out;
+            if constexpr(levels == 0)
+            {
+                out = &this->data;
+            }
+            else if constexpr(levels == 1)
+            {
+                HDF5Utils::ContainerResize(this->data, this->total);
+                out = this->data.data();
+            }
+            else
+            {
+                out = this->flat.data();
+            }
+            if(this->total == 0)
+            {
+                return;
+            }
+            if constexpr(compound)
+            {
+                if(this->copyPlan.valid and not this->staging.empty())
+                {
+                    HDF5Reader_detail::ReadCompoundBlocks(dataset, out, this->fileType, this->copyPlan, this->staging.data(), this->staging.size());
+                }
+                else
+                {
+                    dataset.read(out, this->memType);
+                }
+            }
+            else
+            {
+                dataset.read(out, this->memType);
+            }
+            if constexpr(levels > 1)
+            {
+                HDF5Utils::ContainerResize(this->data, this->dims[0]);
+                const size_t stride = this->total / this->dims[0];
+                for(hsize_t i = 0; i < this->dims[0]; ++i)
+                {
+                    HDF5Reader_detail::ReadRectangularDataUnflatten<Scalar>(this->flat.data() + i * stride, this->dims.data() + 1, levels - 1, this->data[i]);
+                }
+            }
+        }
+    }
+
+    void ReadElement(const HDF5Reader &reader, const std::string &path) override
+    {
+        reader.ReadElement(path, this->data);
+    }
+
+    T &data;
+    H5::DataType memType;
+    H5::DataType fileType;
+    HDF5Utils::CompoundCopyPlan copyPlan;
+    std::vector<hsize_t> dims;
+    size_t total = 0;
+    std::vector<Scalar> flat;       // nested destinations are read flat, then copied row by row
+    std::vector<char> staging;      // packed compound records
+};
+
+template<typename T>
+void HDF5ReadPlan::Add(const std::string &path, T &data)
+{
+    Entry entry;
+    entry.path = path;
+    entry.target = std::make_unique<TypedTarget<T>>(data);
+    this->Release();
+    this->entries_.push_back(std::move(entry));
+    this->compiled_ = false;
+}
+
+#endif // HDF5READPLAN_HPP
@@ -1,4 +1,307 @@
 #include "HDF5Reader.hpp"
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define HDF5READER_PREAD 1
+#endif
+
+namespace HDF5Reader_detail
+{
+    ConcurrentState::~ConcurrentState()
+    {
+#ifdef HDF5READER_PREAD
+        if(this->fd >= 0)
+        {
+            close(this->fd);
+        }
+#endif
+    }
+
+    RawLayout ResolveRawLayout(const H5::DataSet &dataset, haddr_t base)
+    {
+        RawLayout layout;
+        const H5::DataSpace space = dataset.getSpace();
+        if(space.getSimpleExtentType() != H5S_SIMPLE)
+        {
+            return layout;
+        }
+        layout.dims.resize(space.getSimpleExtentNdims());
+        space.getSimpleExtentDims(layout.dims.data());
+
+        // plain IEEE floats and full-width integers only
+        const H5::DataType type = dataset.getDataType();
+        const hid_t tid = type.getId();
+        layout.typeClass = H5Tget_class(tid);
+        layout.typeSize = H5Tget_size(tid);
+        if(layout.typeClass == H5T_INTEGER)
+        {
+            if(H5Tget_precision(tid) != 8 * layout.typeSize or H5Tget_offset(tid) != 0 or
+               (layout.typeSize != 1 and layout.typeSize != 2 and layout.typeSize != 4 and layout.typeSize != 8))
+            {
+                return layout;
+            }
+            layout.isSigned = H5Tget_sign(tid) == H5T_SGN_2;
+        }
+        else if(layout.typeClass == H5T_FLOAT)
+        {
+            if(not (H5Tequal(tid, H5T_IEEE_F32LE) > 0 or H5Tequal(tid, H5T_IEEE_F32BE) > 0 or
+                    H5Tequal(tid, H5T_IEEE_F64LE) > 0 or H5Tequal(tid, H5T_IEEE_F64BE) > 0))
+            {
+                return layout;
+            }
+        }
+        else
+        {
+            return layout;
+        }
+        layout.swap = layout.typeSize > 1 and H5Tget_order(tid) != H5Tget_order(H5T_NATIVE_INT);
+
+        const H5::DSetCreatPropList plist = dataset.getCreatePlist();
+        if(plist.getNfilters() != 0 or plist.getExternalCount() != 0)
+        {
+            return layout;
+        }
+        layout.fill.assign(layout.typeSize, 0);
+        H5D_fill_value_t fillStatus;
+        H5Pfill_value_defined(plist.getId(), &fillStatus);
+        if(fillStatus == H5D_FILL_VALUE_USER_DEFINED)
+        {
+            H5Pget_fill_value(plist.getId(), tid, layout.fill.data());
+        }
+
+        const H5D_layout_t storage = plist.getLayout();
+        if(storage == H5D_CONTIGUOUS)
+        {
+            layout.address = H5Dget_offset(dataset.getId());
+        }
+        else if(storage == H5D_CHUNKED)
+        {
+            const int ndims = static_cast<int>(layout.dims.size());
+            layout.chunkDims.resize(ndims);
+            plist.getChunk(ndims, layout.chunkDims.data());
+            size_t chunkBytes = layout.typeSize;
+            size_t nchunks = 1;
+            std::vector<hsize_t> grid(ndims);
+            for(int i = 0; i < ndims; ++i)
+            {
+                chunkBytes *= layout.chunkDims[i];
+                grid[i] = (layout.dims[i] + layout.chunkDims[i] - 1) / layout.chunkDims[i];
+                nchunks *= grid[i];
+            }
+            // chunk lookups are linear in the chunk count, so finely chunked datasets stay on the library path
+            constexpr size_t maxChunks = 4096;
+            if(nchunks > maxChunks)
+            {
+                return layout;
+            }
+            layout.addresses.assign(nchunks, HADDR_UNDEF);
+            std::vector<hsize_t> coord(ndims, 0);
+            std::vector<hsize_t> offset(ndims);
+            for(size_t c = 0; c < nchunks; ++c)
+            {
+                for(int i = 0; i < ndims; ++i)
+                {
+                    offset[i] = coord[i] * layout.chunkDims[i];
+                }
+                unsigned filterMask = 0;
+                haddr_t address = HADDR_UNDEF;
+                hsize_t size = 0;
+                if(H5Dget_chunk_info_by_coord(dataset.getId(), offset.data(), &filterMask, &address, &size) >= 0 and
+                   address != HADDR_UNDEF)
+                {
+                    if(size != chunkBytes)
+                    {
+                        return layout;
+                    }
+                    layout.addresses[c] = address + base;
+                }
+                for(int i = ndims - 1; i >= 0; --i)
+                {
+                    if(++coord[i] < grid[i])
+                    {
+                        break;
+                    }
+                    coord[i] = 0;
+                }
+            }
+        }
+        else
+        {
+            return layout;
+        }
+        layout.supported = true;
+        return layout;
+    }
+
+    namespace
+    {
+        bool ReadFully(int fd, char *out, size_t size, haddr_t address)
+        {
+#ifdef HDF5READER_PREAD
+            while(size > 0)
+            {
+                const ssize_t n = pread(fd, out, size, static_cast<off_t>(address));
+                if(n <= 0)
+                {
+                    return false;
+                }
+                out += n;
+                size -= static_cast<size_t>(n);
+                address += static_cast<haddr_t>(n);
+            }
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Calls `row(datasetOffset, chunkOffset, count)` for every innermost row of the chunk starting at `start`,
+        // clipped to the dataset; offsets are in elements.
+        template<typename Row>
+        void ForEachChunkRow(const RawLayout &layout, const hsize_t *start, Row row)
+        {
+            const int ndims = static_cast<int>(layout.dims.size());
+            std::vector<hsize_t> extent(ndims);
+            for(int i = 0; i < ndims; ++i)
+            {
+                extent[i] = std::min(layout.chunkDims[i], layout.dims[i] - start[i]);
+            }
+            std::vector<hsize_t> index(ndims, 0);
+            while(true)
+            {
+                size_t src = 0;
+                size_t dst = 0;
+                for(int i = 0; i < ndims; ++i)
+                {
+                    src = src * layout.chunkDims[i] + index[i];
+                    dst = dst * layout.dims[i] + start[i] + index[i];
+                }
+                row(dst, src, extent[ndims - 1]);
+                int d = ndims - 2;
+                for(; d >= 0; --d)
+                {
+                    if(++index[d] < extent[d])
+                    {
+                        break;
+                    }
+                    index[d] = 0;
+                }
+                if(d < 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        bool ReadChunks(int fd, const RawLayout &layout, char *out, size_t first, size_t last)
+        {
+            const int ndims = static_cast<int>(layout.dims.size());
+            const size_t es = layout.typeSize;
+            size_t chunkElements = 1;
+            std::vector<hsize_t> grid(ndims);
+            for(int i = 0; i < ndims; ++i)
+            {
+                chunkElements *= layout.chunkDims[i];
+                grid[i] = (layout.dims[i] + layout.chunkDims[i] - 1) / layout.chunkDims[i];
+            }
+            std::vector<char> chunk(chunkElements * es);
+            std::vector<hsize_t> start(ndims);
+            for(size_t c = first; c < last; ++c)
+            {
+                size_t rest = c;
+                for(int i = ndims - 1; i >= 0; --i)
+                {
+                    start[i] = (rest % grid[i]) * layout.chunkDims[i];
+                    rest /= grid[i];
+                }
+                if(layout.addresses[c] == HADDR_UNDEF)
+                {
+                    ForEachChunkRow(layout, start.data(), [&](size_t dst, size_t, size_t count)
+                    {
+                        for(size_t k = 0; k < count; ++k)
+                        {
+                            std::memcpy(out + (dst + k) * es, layout.fill.data(), es);
+                        }
+                    });
+                    continue;
+                }
+                if(not ReadFully(fd, chunk.data(), chunk.size(), layout.addresses[c]))
+                {
+                    return false;
+                }
+                ForEachChunkRow(layout, start.data(), [&](size_t dst, size_t src, size_t count)
+                {
+                    std::memcpy(out + dst * es, chunk.data() + src * es, count * es);
+                });
+            }
+            return true;
+        }
+    }
+
+    bool ReadRawBytes(int fd, const RawLayout &layout, char *out, unsigned threads)
+    {
+        size_t total = layout.typeSize;
+        for(hsize_t d : layout.dims)
+        {
+            total *= d;
+        }
+        if(total == 0)
+        {
+            return true;
+        }
+        // split only reads large enough to amortize the threads
+        constexpr size_t minBytesPerThread = size_t(4) << 20;
+        const size_t parts = std::max<size_t>(1, std::min<size_t>(threads, total / minBytesPerThread));
+
+        std::vector<char> ok(parts, 1);
+        auto run = [&](auto &&part)
+        {
+            if(parts == 1)
+            {
+                part(0);
+                return;
+            }
+            std::vector<std::thread> workers;
+            for(size_t p = 0; p < parts; ++p)
+            {
+                workers.emplace_back(part, p);
+            }
+            for(std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        };
+
+        if(layout.chunkDims.empty())
+        {
+            if(layout.address == HADDR_UNDEF)
+            {
+                for(size_t i = 0; i < total; i += layout.typeSize)
+                {
+                    std::memcpy(out + i, layout.fill.data(), layout.typeSize);
+                }
+                return true;
+            }
+            const size_t elements = total / layout.typeSize;
+            run([&](size_t p)
+            {
+                const size_t begin = elements * p / parts * layout.typeSize;
+                const size_t end = elements * (p + 1) / parts * layout.typeSize;
+                ok[p] = ReadFully(fd, out + begin, end - begin, layout.address + begin);
+            });
+        }
+        else
+        {
+            const size_t nchunks = layout.addresses.size();
+            run([&](size_t p)
+            {
+                ok[p] = ReadChunks(fd, layout, out, nchunks * p / parts, nchunks * (p + 1) / parts);
+            });
+        }
+        return std::find(ok.begin(), ok.end(), 0) == ok.end();
+    }
+}
 
 HDF5Reader::HDF5Reader()
 {}
@@ -8,10 +311,111 @@ HDF5Reader::HDF5Reader(const std::string &filename)
     this->Load(filename);
 }
 
+HDF5Reader::HDF5Reader(const std::string &filename, const HDF5Utils::ReaderOptions &options)
+{
+    this->Load(filename, options);
+}
+
 void HDF5Reader::Load(const std::string &filename)
 {
-    file_ = H5::H5File(filename, H5F_ACC_RDONLY);
+    this->Load(filename, HDF5Utils::ReaderOptions());
+}
+
+void HDF5Reader::Load(const std::string &filename, const HDF5Utils::ReaderOptions &options)
+{
+    this->options_ = options;
+    const HDF5Utils::FileLayout layout = HDF5Utils::ResolveFileLayout(filename, options.layout, false);
+    H5::FileAccPropList access = HDF5Utils::FileAccess(layout, false);
+    if(options.elinkFileCacheSize > 0)
+    {
+        H5Pset_elink_file_cache_size(access.getId(), options.elinkFileCacheSize);
+    }
+    file_ = H5::H5File(filename, options.swmr ? H5F_ACC_RDONLY | H5F_ACC_SWMR_READ : H5F_ACC_RDONLY,
+                       H5::FileCreatPropList::DEFAULT, access);
+    this->layout_ = HDF5Utils::ReadFileLayout(this->file_, layout);
+    this->concurrent_.reset();
+#ifdef HDF5READER_PREAD
+    if(options.concurrent and not options.swmr and this->file_.getAccessPlist().getDriver() == H5FD_SEC2)
+    {
+        auto state = std::make_shared<HDF5Reader_detail::ConcurrentState>();
+        state->fd = open(filename.c_str(), O_RDONLY);
+        state->base = this->file_.getCreatePlist().getUserblock();
+        state->threads = std::max(1u, options.readThreads);
+        if(state->fd >= 0)
+        {
+            this->concurrent_ = state;
+        }
+    }
+#endif
+    this->catalog_.reset();
     this->loaded_ = true;
+    if(options.catalog == HDF5Utils::CatalogMode::Eager and not options.swmr)
+    {
+        this->Catalog();
+    }
+}
+
+const HDF5Utils::Catalog &HDF5Reader::Catalog(void) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before Catalog()");
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+    if(not this->catalog_)
+    {
+        auto catalog = std::make_shared<HDF5Utils::Catalog>();
+        if(not HDF5Utils::ReadCatalog(this->file_, *catalog))
+        {
+            *catalog = HDF5Utils::BuildCatalog(this->file_);
+        }
+        this->catalog_ = catalog;
+    }
+    return *this->catalog_;
+}
+
+std::shared_ptr<const HDF5Reader_detail::RawLayout> HDF5Reader::RawLayoutOf(const std::string &path) const
+{
+    std::lock_guard<std::mutex> lock(this->concurrent_->mutex);
+    auto it = this->concurrent_->layouts.find(path);
+    if(it != this->concurrent_->layouts.end())
+    {
+        return it->second;
+    }
+    auto layout = std::make_shared<HDF5Reader_detail::RawLayout>();
+    if(H5Lexists(this->file_.getId(), path.c_str(), H5P_DEFAULT) > 0 and
+       this->file_.childObjType(path) == H5O_TYPE_DATASET)
+    {
+        *layout = HDF5Reader_detail::ResolveRawLayout(this->file_.openDataSet(path), this->concurrent_->base);
+    }
+    this->concurrent_->layouts[path] = layout;
+    return layout;
+}
+
+std::vector<hsize_t> HDF5Reader::Refresh(const std::string &path) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before Refresh()");
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+    H5::DataSet dataset = this->file_.openDataSet(path);
+    if(this->options_.swmr)
+    {
+        H5Drefresh(dataset.getId());
+    }
+    const H5::DataSpace space = dataset.getSpace();
+    std::vector<hsize_t> dims(space.getSimpleExtentNdims());
+    space.getSimpleExtentDims(dims.data());
+    return dims;
 }
 
 std::vector<std::string> HDF5Reader::ReadGroupNames(const std::string &path) const
@@ -20,11 +424,34 @@ std::vector<std::string> HDF5Reader::ReadGroupNames(const std::string &path) con
     {
         throw std::runtime_error("HDF5Reader: Load() must be called before ReadGroupNames()");
     }
+    // Catalog() takes the lock itself, and the catalog is then read without the library
+    if(this->options_.catalog != HDF5Utils::CatalogMode::Off and not this->options_.swmr)
+    {
+        const HDF5Utils::Catalog &catalog = this->Catalog();
+        if(const std::vector<std::string> *names = catalog.Children(path))
+        {
+            return *names;
+        }
+        if(catalog.Covers(path))
+        {
+            throw std::runtime_error("HDF5Reader: group does not exist: " + path);
+        }
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
     H5::Group group = HDF5Utils::openGroupPath(this->file_, path);
+    const bool root = group.getObjName() == "/";
     std::vector<std::string> names;
     for(hsize_t n = 0; n < group.getNumObjs(); ++n)
     {
         const H5std_string name = group.getObjnameByIdx(n);
+        if(root and name == HDF5Utils::InternalGroup + 1)
+        {
+            continue;
+        }
         names.push_back(name);
     }
     group.close();
@@ -37,6 +464,182 @@ bool HDF5Reader::Exists(const std::string &path) const
     {
         throw std::runtime_error("HDF5Reader: Load() must be called before Exists()");
     }
+    if(this->options_.catalog != HDF5Utils::CatalogMode::Off and not this->options_.swmr)
+    {
+        const HDF5Utils::Catalog &catalog = this->Catalog();
+        if(catalog.Find(path) or catalog.Children(path))
+        {
+            return true;
+        }
+        if(catalog.Covers(path))
+        {
+            return false;
+        }
+    }
 
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
     return H5Lexists(this->file_.getId(), path.c_str(), H5P_DEFAULT) > 0;
-}
\ No newline at end of file
+}
+
+unsigned HDF5Reader::PyramidLevels(const std::string &path) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before PyramidLevels()");
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    const std::string pyramid = HDF5Utils::PyramidPath(path);
+    if(H5Lexists(this->file_.getId(), HDF5Utils::PyramidGroup, H5P_DEFAULT) <= 0 or
+       H5Lexists(this->file_.getId(), pyramid.c_str(), H5P_DEFAULT) <= 0)
+    {
+        return 0;
+    }
+    const H5::Group group = this->file_.openGroup(pyramid);
+    unsigned levels = 0;
+    while(group.exists(std::to_string(levels + 1)))
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+unsigned HDF5Reader::BestLevel(const std::string &path, const std::vector<hsize_t> &targetDims) const
+{
+    const unsigned levels = this->PyramidLevels(path);
+    std::vector<hsize_t> dims = this->Refresh(path);
+    if(targetDims.size() != dims.size())
+    {
+        throw std::runtime_error("HDF5Reader: target has " + std::to_string(targetDims.size()) + " dimensions, " + path +
+                                 " has " + std::to_string(dims.size()));
+    }
+    unsigned best = 0;
+    for(unsigned level = 1; level <= levels; ++level)
+    {
+        bool large = true;
+        for(size_t i = 0; i < dims.size(); ++i)
+        {
+            dims[i] = (dims[i] + 1) / 2;
+            large = large and dims[i] >= targetDims[i];
+        }
+        if(not large)
+        {
+            break;
+        }
+        best = level;
+    }
+    return best;
+}
+
+HDF5Utils::ObjectInfo HDF5Reader::Info(const std::string &path) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before Info()");
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    HDF5Utils::ObjectInfo info;
+    const hid_t fid = this->file_.getId();
+    const bool root = path.empty() or path == "/";
+    if(not root)
+    {
+        if(H5Lexists(fid, path.c_str(), H5P_DEFAULT) <= 0)
+        {
+            throw std::runtime_error("HDF5Reader: object does not exist: " + path);
+        }
+        H5L_info_t link;
+        H5Lget_info(fid, path.c_str(), &link, H5P_DEFAULT);
+        info.link = link.type;
+        if(link.type == H5L_TYPE_SOFT or link.type == H5L_TYPE_EXTERNAL)
+        {
+            std::vector<char> value(link.u.val_size);
+            H5Lget_val(fid, path.c_str(), value.data(), value.size(), H5P_DEFAULT);
+            if(link.type == H5L_TYPE_SOFT)
+            {
+                info.linkTarget = value.data();
+            }
+            else
+            {
+                const char *file = nullptr;
+                const char *object = nullptr;
+                H5Lunpack_elink_val(value.data(), value.size(), nullptr, &file, &object);
+                info.linkTarget = std::string(file) + ":" + object;
+            }
+        }
+        // dangling soft or external links are reported with an unknown type
+        htri_t exists = -1;
+        H5E_BEGIN_TRY
+        {
+            exists = H5Oexists_by_name(fid, path.c_str(), H5P_DEFAULT);
+        }
+        H5E_END_TRY;
+        if(exists <= 0)
+        {
+            return info;
+        }
+    }
+
+    info.type = root ? H5O_TYPE_GROUP : this->file_.childObjType(path);
+    if(info.type == H5O_TYPE_GROUP)
+    {
+        info.attributes = this->file_.openGroup(root ? "/" : path).getNumAttrs();
+        return info;
+    }
+    if(info.type != H5O_TYPE_DATASET)
+    {
+        return info;
+    }
+
+    const H5::DataSet dataset = this->file_.openDataSet(path);
+    if(this->options_.swmr)
+    {
+        H5Drefresh(dataset.getId());
+    }
+    info.attributes = dataset.getNumAttrs();
+
+    const H5::DataSpace space = dataset.getSpace();
+    const int ndims = space.getSimpleExtentNdims();
+    info.dims.resize(ndims);
+    info.maxDims.resize(ndims);
+    space.getSimpleExtentDims(info.dims.data(), info.maxDims.data());
+
+    const H5::DataType type = dataset.getDataType();
+    info.typeClass = type.getClass();
+    info.typeName = HDF5Utils::DescribeType(type.getId());
+    if(H5Tdetect_class(type.getId(), H5T_VLEN) <= 0 and H5Tis_variable_str(type.getId()) <= 0)
+    {
+        info.rawSize = static_cast<hsize_t>(space.getSimpleExtentNpoints()) * type.getSize();
+    }
+    info.storageSize = dataset.getStorageSize();
+
+    const H5::DSetCreatPropList plist = dataset.getCreatePlist();
+    info.layout = HDF5Utils::DescribeLayout(plist.getLayout());
+    if(plist.getLayout() == H5D_CHUNKED)
+    {
+        info.chunkDims.resize(ndims);
+        plist.getChunk(ndims, info.chunkDims.data());
+    }
+    for(int i = 0; i < plist.getNfilters(); ++i)
+    {
+        unsigned flags = 0;
+        size_t nelements = 0;
+        char name[64] = "";
+        unsigned config = 0;
+        H5Pget_filter2(plist.getId(), i, &flags, &nelements, nullptr, sizeof(name), name, &config);
+        info.filters.push_back(name);
+    }
+    return info;
+}
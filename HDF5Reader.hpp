@@ -17,13 +17,35 @@ public:
 
     HDF5Reader(const std::string &filename);
 
+    HDF5Reader(const std::string &filename, const HDF5Utils::ReaderOptions &options);
+
     /**
     Loads the file `filename` and prepares it for reading.
     */
     void Load(const std::string &filename);
 
     /**
-        Reads the names of the groups at `path`.
+    Loads the file `filename` with `options` (e.g. SWMR reading) and prepares it for reading.
+    */
+    void Load(const std::string &filename, const HDF5Utils::ReaderOptions &options);
+
+    /**
+    Driver and allocation settings of the loaded file, as recorded by `HDF5Writer`, or the driver it was opened with.
+    */
+    const HDF5Utils::FileLayout &Layout(void) const { return this->layout_; }
+
+    /**
+    Catalog of all objects of the file (see `ReaderOptions::catalog`), read or built on the first call.
+    */
+    const HDF5Utils::Catalog &Catalog(void) const;
+
+    /**
+    Refreshes the dataset at `path` (SWMR mode) and returns its current dimensions.
+    */
+    std::vector<hsize_t> Refresh(const std::string &path) const;
+
+    /**
+        Reads the names of the groups at `path`. The library's own `HDF5Utils::InternalGroup` is not listed.
     */
     std::vector<std::string> ReadGroupNames(const std::string &path) const;
 
@@ -38,8 +60,96 @@ public:
     template<typename T>
     void ReadElement(const std::string &path, T &data) const;
 
+    /**
+    Reads only the members `fields` of the compound records at `path` into `data`, from either the row or the columnar layout.
+    Members not listed keep their values; records added to `data` are value-initialized.
+    */
+    template<typename T>
+    void ReadFields(const std::string &path, const std::vector<std::string> &fields, T &data) const;
+
+    /**
+    Describes the object at `path` (link, type, shape, layout, filters, sizes) without reading its data.
+    */
+    HDF5Utils::ObjectInfo Info(const std::string &path) const;
+
+    /**
+    Reads `rows` rows (first dimension) of the numeric or string dataset at `path`, starting at `firstRow`
+    and taking every `rowStride`-th row, flattened into `data`.
+    */
+    template<typename T, typename Allocator>
+    void ReadRows(const std::string &path, hsize_t firstRow, hsize_t rows, std::vector<T, Allocator> &data, hsize_t rowStride = 1) const;
+
+    /**
+    Reads rows [`firstRow`, `firstRow` + `rows`) of the sparse element at `path` into `data`, in the stored format, with the row
+    indices rebased to `firstRow`. CSR elements and COO elements sorted by row read only those rows; CSC elements are read whole.
+    */
+    template<typename T>
+    void ReadSparseRows(const std::string &path, hsize_t firstRow, hsize_t rows, HDF5Utils::SparseArray<T> &data) const;
+
+    /**
+    Densifies the block of `count` elements from `offset` of the sparse element at `path` into `data`, in row-major order.
+    Only the rows (CSR, sorted COO) or columns (CSC) of the block are read; duplicate coordinates are summed.
+    */
+    template<typename T, typename Allocator>
+    void ReadDenseBlock(const std::string &path, const std::vector<hsize_t> &offset, const std::vector<hsize_t> &count,
+                        std::vector<T, Allocator> &data) const;
+
+    /**
+    Reads the values of the numeric element at `path` that lie in `range` into `values`, and their row-major element indices
+    into `indices`. The element is scanned in blocks of rows: with a zone map (`ElementOptions::zoneMapRows`) blocks whose
+    minimum and maximum exclude `range` are not read at all; without one every block is read and filtered.
+    */
+    template<typename T, typename Allocator>
+    HDF5Utils::ScanStats ReadWhere(const std::string &path, const HDF5Utils::ValueRange<T> &range, std::vector<T, Allocator> &values,
+                                   std::vector<hsize_t> &indices) const;
+
+    /**
+    Number of decimated levels stored with the element at `path` (`ElementOptions::pyramidLevels`), 0 if none.
+    */
+    unsigned PyramidLevels(const std::string &path) const;
+
+    /**
+    Coarsest level of the element at `path` whose every dimension is at least `targetDims`, so it can be displayed at that size
+    without upsampling; 0 (the element itself) if no level is large enough.
+    */
+    unsigned BestLevel(const std::string &path, const std::vector<hsize_t> &targetDims) const;
+
+    /**
+    Reads level `level` of the element at `path` into `data`, like `ReadElement()`: level 0 is the element itself,
+    level k has every dimension halved k times (rounding up). Means of integer elements are read from float64 levels.
+    */
+    template<typename T>
+    void ReadLevel(const std::string &path, unsigned level, T &data) const
+    {
+        if(level == 0)
+        {
+            this->ReadElement(path, data);
+        }
+        else
+        {
+            this->ReadElement(HDF5Utils::PyramidPath(path) + "/" + std::to_string(level), data);
+        }
+    }
+
+    /**
+    Sets the memory resource of the temporary buffers of the reads (flattened values, variable-length data, conversion blocks).
+    `nullptr` (the default) keeps the resource current at the time of the read, or `std::pmr::get_default_resource()` outside any
+    `HDF5Utils::ScopedMemoryResource`.
+    The resource must outlive the reads; it is not used for `data` itself, which keeps its own allocator.
+    */
+    void SetMemoryResource(std::pmr::memory_resource *resource) { this->memoryResource_ = resource; }
+
 private:
+    friend class HDF5ReadPlan;
+
+    std::shared_ptr<const HDF5Reader_detail::RawLayout> RawLayoutOf(const std::string &path) const;
+
     H5::H5File file_;
+    HDF5Utils::ReaderOptions options_;
+    HDF5Utils::FileLayout layout_;
+    std::shared_ptr<HDF5Reader_detail::ConcurrentState> concurrent_;
+    mutable std::shared_ptr<const HDF5Utils::Catalog> catalog_;
+    std::pmr::memory_resource *memoryResource_ = nullptr;
     bool loaded_ = false;
 };
 
@@ -50,6 +160,20 @@ void HDF5Reader::ReadElement(const std::string &path, T &data) const
     {
         throw std::runtime_error("HDF5Reader: Load() must be called before ReadElement()");
     }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+
+    if constexpr(HDF5Reader_detail::IsRawReadable<T>::value)
+    {
+        if(this->concurrent_ and HDF5Reader_detail::ReadRawData(*this->concurrent_, *this->RawLayoutOf(path), data))
+        {
+            return;
+        }
+    }
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
 
     auto [groupPath, name] = HDF5Utils::splitPathAndName(path);
 
@@ -58,16 +182,164 @@ void HDF5Reader::ReadElement(const std::string &path, T &data) const
     {
         throw std::runtime_error("HDF5Reader: dataset does not exist: " + path + " in group " + groupPath);
     }
+    if constexpr(HDF5Utils::IsSparse<T>::value)
+    {
+        HDF5Reader_detail::ReadSparseData(group.openGroup(name), path, data);
+    }
+    else
+    {
+        if constexpr(HDF5Utils::IsContainer<T>::value and HDF5Utils::HasCompType<typename HDF5Utils::InnerType<T>::type>::value)
+        {
+            if(group.childObjType(name) == H5O_TYPE_GROUP)
+            {
+                HDF5Reader_detail::ReadColumnarData(group.openGroup(name), data, nullptr);
+                return;
+            }
+        }
+        const H5::DataSet dataset = group.openDataSet(name);
+        if(this->options_.swmr)
+        {
+            H5Drefresh(dataset.getId());
+        }
+
+        if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            HDF5Reader_detail::ReadContainerData(dataset, data);
+        }
+        else
+        {
+            HDF5Reader_detail::ReadScalarData(dataset, data);
+        }
+    }
+}
+
+template<typename T>
+void HDF5Reader::ReadFields(const std::string &path, const std::vector<std::string> &fields, T &data) const
+{
+    using Scalar = typename HDF5Utils::InnerType<T>::type;
+    static_assert(HDF5Utils::IsContainer<T>::value and HDF5Utils::HasCompType<Scalar>::value,
+                  "HDF5Reader::ReadFields: data must be a container of compound records");
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before ReadFields()");
+    }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    auto [groupPath, name] = HDF5Utils::splitPathAndName(path);
+    const H5::Group group = HDF5Utils::openGroupPath(file_, groupPath);
+    if(not group.exists(name))
+    {
+        throw std::runtime_error("HDF5Reader: dataset does not exist: " + path + " in group " + groupPath);
+    }
+    if(group.childObjType(name) == H5O_TYPE_GROUP)
+    {
+        HDF5Reader_detail::ReadColumnarData(group.openGroup(name), data, &fields);
+        return;
+    }
+
     const H5::DataSet dataset = group.openDataSet(name);
+    if(this->options_.swmr)
+    {
+        H5Drefresh(dataset.getId());
+    }
+    const H5::DataSpace space = dataset.getSpace();
+    std::vector<hsize_t> dims(space.getSimpleExtentNdims());
+    space.getSimpleExtentDims(dims.data());
+    const H5::DataType mem_type = HDF5Utils::CompTypeCreator<Scalar>::get();
+    HDF5Reader_detail::FillRectangularRecords(data, dims, [&](Scalar *out, size_t count)
+    {
+        if(count > 0)
+        {
+            HDF5Reader_detail::ReadCompoundFields(dataset, out, mem_type, fields);
+        }
+    });
+}
 
-    if constexpr(HDF5Utils::IsContainer<T>::value)
+template<typename T, typename Allocator>
+void HDF5Reader::ReadRows(const std::string &path, hsize_t firstRow, hsize_t rows, std::vector<T, Allocator> &data, hsize_t rowStride) const
+{
+    if(not loaded_)
     {
-        HDF5Reader_detail::ReadContainerData(dataset, data);
+        throw std::runtime_error("HDF5Reader: Load() must be called before ReadRows()");
     }
-    else
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    const H5::DataSet dataset = this->file_.openDataSet(path);
+    if(this->options_.swmr)
+    {
+        H5Drefresh(dataset.getId());
+    }
+    HDF5Reader_detail::ReadRowsData(dataset, firstRow, rows, rowStride, data);
+}
+
+template<typename T>
+void HDF5Reader::ReadSparseRows(const std::string &path, hsize_t firstRow, hsize_t rows, HDF5Utils::SparseArray<T> &data) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before ReadSparseRows()");
+    }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    const H5::Group group = this->file_.openGroup(path);
+    HDF5Reader_detail::ReadSparseRowsData(group, path, firstRow, rows, data);
+}
+
+template<typename T, typename Allocator>
+void HDF5Reader::ReadDenseBlock(const std::string &path, const std::vector<hsize_t> &offset, const std::vector<hsize_t> &count,
+                                std::vector<T, Allocator> &data) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before ReadDenseBlock()");
+    }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    const H5::Group group = this->file_.openGroup(path);
+    HDF5Reader_detail::ReadDenseBlockData(group, path, offset, count, data);
+}
+
+template<typename T, typename Allocator>
+HDF5Utils::ScanStats HDF5Reader::ReadWhere(const std::string &path, const HDF5Utils::ValueRange<T> &range, std::vector<T, Allocator> &values,
+                                           std::vector<hsize_t> &indices) const
+{
+    if(not loaded_)
+    {
+        throw std::runtime_error("HDF5Reader: Load() must be called before ReadWhere()");
+    }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    std::unique_lock<std::mutex> lock;
+    if(this->concurrent_)
+    {
+        lock = std::unique_lock<std::mutex>(this->concurrent_->mutex);
+    }
+
+    H5::DataSet dataset = this->file_.openDataSet(path);
+    if(this->options_.swmr)
     {
-        HDF5Reader_detail::ReadScalarData(dataset, data);
+        H5Drefresh(dataset.getId());
     }
+    return HDF5Reader_detail::ReadWhereData(this->file_, dataset, path, range, values, indices);
 }
 
 #endif // HDF5READER_HPP
@@ -6,10 +6,232 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cstring>
+#include <cstdint>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
 #include "HDF5Helper.hpp"
+#include "HDF5Sparse.hpp"
 
 namespace HDF5Reader_detail
 {
+    // Location of a dataset's raw bytes in the file, for reads outside the HDF5 library (concurrent mode).
+    struct RawLayout
+    {
+        bool supported = false;
+        H5T_class_t typeClass = H5T_NO_CLASS;
+        size_t typeSize = 0;
+        bool isSigned = false;
+        bool swap = false;                  // stored in the opposite byte order
+        std::vector<hsize_t> dims;
+        std::vector<hsize_t> chunkDims;     // empty for contiguous datasets
+        std::vector<haddr_t> addresses;     // one per chunk in row-major grid order, HADDR_UNDEF if not allocated
+        haddr_t address = HADDR_UNDEF;      // contiguous data
+        std::vector<char> fill;             // fill value in the file type
+    };
+
+    // `base` is the userblock size, which chunk addresses do not include.
+    RawLayout ResolveRawLayout(const H5::DataSet &dataset, haddr_t base);
+
+    // Reads every element of `layout` in the file type into `out`, splitting large reads over `threads`.
+    bool ReadRawBytes(int fd, const RawLayout &layout, char *out, unsigned threads);
+
+    struct ConcurrentState
+    {
+        int fd = -1;
+        haddr_t base = 0;
+        unsigned threads = 1;
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<const RawLayout>> layouts;
+
+        ~ConcurrentState();
+    };
+
+    template<typename T>
+    struct IsRawReadable : std::bool_constant<HDF5Utils::IsContainer<T>::value and
+                                              std::is_arithmetic_v<typename HDF5Utils::InnerType<T>::type> and
+                                              not std::is_same_v<typename HDF5Utils::InnerType<T>::type, bool>> {};
+
+    template<typename Source, typename Scalar>
+    void ConvertRawValues(const char *raw, size_t count, bool swap, Scalar *out)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            char bytes[sizeof(Source)];
+            std::memcpy(bytes, raw + i * sizeof(Source), sizeof(Source));
+            if(swap)
+            {
+                std::reverse(bytes, bytes + sizeof(Source));
+            }
+            Source value;
+            std::memcpy(&value, bytes, sizeof(Source));
+            out[i] = static_cast<Scalar>(value);
+        }
+    }
+
+    // True if file values of `layout` convert to Scalar without loss, the way HDF5 would convert them.
+    template<typename Scalar>
+    bool RawConvertible(const RawLayout &layout)
+    {
+        if constexpr(std::is_floating_point_v<Scalar>)
+        {
+            return layout.typeClass == H5T_FLOAT and layout.typeSize <= sizeof(Scalar);
+        }
+        else
+        {
+            if(layout.typeClass != H5T_INTEGER)
+            {
+                return false;
+            }
+            if(layout.isSigned and not std::is_signed_v<Scalar>)
+            {
+                return false;
+            }
+            return layout.typeSize < sizeof(Scalar) or (layout.typeSize == sizeof(Scalar) and layout.isSigned == std::is_signed_v<Scalar>);
+        }
+    }
+
+    template<typename Scalar>
+    void ConvertRaw(const RawLayout &layout, const char *raw, size_t count, Scalar *out)
+    {
+        if(layout.typeClass == H5T_FLOAT)
+        {
+            if(layout.typeSize == sizeof(float))
+                ConvertRawValues<float>(raw, count, layout.swap, out);
+            else
+                ConvertRawValues<double>(raw, count, layout.swap, out);
+            return;
+        }
+        switch(layout.typeSize)
+        {
+            case 1: layout.isSigned ? ConvertRawValues<int8_t>(raw, count, layout.swap, out) : ConvertRawValues<uint8_t>(raw, count, layout.swap, out); break;
+            case 2: layout.isSigned ? ConvertRawValues<int16_t>(raw, count, layout.swap, out) : ConvertRawValues<uint16_t>(raw, count, layout.swap, out); break;
+            case 4: layout.isSigned ? ConvertRawValues<int32_t>(raw, count, layout.swap, out) : ConvertRawValues<uint32_t>(raw, count, layout.swap, out); break;
+            default: layout.isSigned ? ConvertRawValues<int64_t>(raw, count, layout.swap, out) : ConvertRawValues<uint64_t>(raw, count, layout.swap, out); break;
+        }
+    }
+
+    // Decodes the selected entries of a dictionary-encoded (enum) string dataset into `out`.
+    inline void ReadDictionaryStrings(const H5::DataSet &dataset, const H5::DataSpace &memSpace, const H5::DataSpace &fileSpace,
+                                      std::string *out, size_t count)
+    {
+        // memory enum with the same names, numbered in dictionary order; HDF5 maps the codes by name
+        const H5::DataType fileType = dataset.getDataType();
+        const int members = std::max(0, H5Tget_nmembers(fileType.getId()));
+        std::vector<std::string> dictionary(members);
+        hid_t mem_id = H5Tenum_create(H5T_NATIVE_UINT32);
+        for(int i = 0; i < members; ++i)
+        {
+            char *member = H5Tget_member_name(fileType.getId(), i);
+            dictionary[i] = member;
+            const uint32_t value = static_cast<uint32_t>(i);
+            H5Tenum_insert(mem_id, member, &value);
+            H5free_memory(member);
+        }
+        H5::DataType mem_type(mem_id);
+        H5Tclose(mem_id);
+        if(dataset.attrExists(HDF5Utils::DictionaryEmptyAttribute))
+        {
+            std::string empty_name;
+            const H5::Attribute attribute = dataset.openAttribute(HDF5Utils::DictionaryEmptyAttribute);
+            attribute.read(attribute.getStrType(), empty_name);
+            std::replace(dictionary.begin(), dictionary.end(), empty_name, std::string());
+        }
+
+        HDF5Utils::Buffer<uint32_t> codes(count);
+        dataset.read(codes.data(), mem_type, memSpace, fileSpace);
+        for(size_t i = 0; i < count; ++i)
+        {
+            // a stored value naming no member converts to an out-of-range code
+            if(codes[i] >= dictionary.size())
+            {
+                throw std::runtime_error("HDF5Reader: dictionary code out of range in " + dataset.getObjName());
+            }
+            out[i] = dictionary[codes[i]];
+        }
+    }
+
+    // Reads `rows` rows of `dataset` from `firstRow` on, every `rowStride`-th row, flattened into `data`.
+    // A scalar dataset is a single row.
+    template<typename T, typename Allocator>
+    void ReadRowsData(const H5::DataSet &dataset, hsize_t firstRow, hsize_t rows, hsize_t rowStride, std::vector<T, Allocator> &data)
+    {
+        H5::DataSpace fileSpace = dataset.getSpace();
+        const int ndims = fileSpace.getSimpleExtentNdims();
+        std::vector<hsize_t> dims(ndims);
+        fileSpace.getSimpleExtentDims(dims.data());
+        const hsize_t available = ndims == 0 ? 1 : dims[0];
+        if(rowStride == 0 or (rows > 0 and firstRow + (rows - 1) * rowStride >= available))
+        {
+            throw std::runtime_error("HDF5Reader: rows out of range");
+        }
+
+        size_t total = rows;
+        H5::DataSpace memSpace;
+        if(ndims > 0)
+        {
+            std::vector<hsize_t> start(ndims, 0);
+            std::vector<hsize_t> stride(ndims, 1);
+            start[0] = firstRow;
+            stride[0] = rowStride;
+            dims[0] = rows;
+            for(int i = 1; i < ndims; ++i)
+            {
+                total *= dims[i];
+            }
+            if(total > 0)
+            {
+                fileSpace.selectHyperslab(H5S_SELECT_SET, dims.data(), start.data(), stride.data());
+                memSpace = H5::DataSpace(ndims, dims.data());
+            }
+        }
+        data.resize(total);
+        if(total == 0)
+        {
+            return;
+        }
+
+        const H5::DataType fileType = dataset.getDataType();
+        if constexpr(std::is_same_v<T, std::string>)
+        {
+            if(fileType.getClass() == H5T_ENUM)
+            {
+                ReadDictionaryStrings(dataset, memSpace, fileSpace, data.data(), total);
+            }
+            else if(fileType.getClass() != H5T_STRING)
+            {
+                throw std::runtime_error("HDF5Reader: not a string dataset");
+            }
+            else if(H5Tis_variable_str(fileType.getId()) > 0)
+            {
+                H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
+                const H5::DSetMemXferPropList xfer = HDF5Utils::VlenTransfer();
+                HDF5Utils::Buffer<char*> rdata(total);
+                dataset.read(rdata.data(), strType, memSpace, fileSpace, xfer);
+                for(size_t i = 0; i < total; i++)
+                    data[i] = rdata[i] ? std::string(rdata[i]) : std::string();
+                H5Dvlen_reclaim(strType.getId(), memSpace.getId(), xfer.getId(), rdata.data());
+            }
+            else
+            {
+                const size_t size = fileType.getSize();
+                H5::StrType strType(H5::PredType::C_S1, size);
+                HDF5Utils::Buffer<char> rdata(total * size);
+                dataset.read(rdata.data(), strType, memSpace, fileSpace);
+                for(size_t i = 0; i < total; i++)
+                    data[i] = std::string(rdata.data() + i * size, strnlen(rdata.data() + i * size, size));
+            }
+        }
+        else
+        {
+            if(fileType.getClass() != H5T_INTEGER and fileType.getClass() != H5T_FLOAT)
+            {
+                throw std::runtime_error("HDF5Reader: not a numeric dataset");
+            }
+            dataset.read(data.data(), HDF5Utils::HDF5Type<T>::value(), memSpace, fileSpace);
+        }
+    }
+
     template<typename T>
     void ReadScalarData(const H5::DataSet &dataset, T &data)
     {
@@ -33,6 +255,87 @@ namespace HDF5Reader_detail
         }
     }
 
+    // Size of the staging buffer that ReadCompoundBlocks() needs for records of `recordBytes` in a dataset of `dims`.
+    inline size_t CompoundStagingBytes(const std::vector<hsize_t> &dims, size_t recordBytes)
+    {
+        size_t row_records = 1;
+        for(size_t i = 1; i < dims.size(); ++i)
+        {
+            row_records *= dims[i];
+        }
+        if(dims.empty() or dims[0] == 0 or row_records == 0)
+        {
+            return 0;
+        }
+        const hsize_t block_rows = std::max<hsize_t>(1, HDF5Utils::CompoundBlockBytes / (row_records * recordBytes));
+        return std::min(block_rows, dims[0]) * row_records * recordBytes;
+    }
+
+    // Reads the records of `dataset`, stored as `file_type`, in blocks of rows staged in `buffer` (`bufferBytes`, at least
+    // one row) and copies them member-wise into `out` following `plan`.
+    template<typename T>
+    void ReadCompoundBlocks(const H5::DataSet &dataset, T *out, const H5::DataType &file_type, const HDF5Utils::CompoundCopyPlan &plan,
+                            char *buffer, size_t bufferBytes)
+    {
+        H5::DataSpace filespace = dataset.getSpace();
+        const int ndims = filespace.getSimpleExtentNdims();
+        std::vector<hsize_t> dims(ndims);
+        filespace.getSimpleExtentDims(dims.data());
+        size_t row_records = 1;
+        for(int i = 1; i < ndims; ++i)
+        {
+            row_records *= dims[i];
+        }
+        if(ndims == 0 or dims[0] == 0 or row_records == 0)
+        {
+            return;
+        }
+        const hsize_t block_rows = std::max<hsize_t>(1, bufferBytes / (row_records * plan.srcSize));
+
+        std::vector<hsize_t> start(ndims, 0);
+        std::vector<hsize_t> count(dims);
+        for(hsize_t row = 0; row < dims[0]; row += block_rows)
+        {
+            start[0] = row;
+            count[0] = std::min(block_rows, dims[0] - row);
+            H5::DataSpace memspace(ndims, count.data());
+            filespace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+            dataset.read(buffer, file_type, memspace, filespace);
+            HDF5Utils::ApplyCompoundCopyPlan(plan, buffer, out + row * row_records, count[0] * row_records);
+        }
+    }
+
+    // Reads the whole compound dataset into `out`. When the file layout differs from T's (e.g. packed), records are
+    // read in bounded blocks of rows in the file layout and copied member-wise, instead of through HDF5's generic converter.
+    // A `mem_type` with only some of T's members reads just those; the copy leaves the other bytes of `out` untouched,
+    // as does the library with a preserving `xfer`.
+    template<typename T>
+    void ReadCompoundData(const H5::DataSet &dataset, T *out, const H5::DataType &mem_type,
+                          const H5::DSetMemXferPropList &xfer = H5::DSetMemXferPropList::DEFAULT)
+    {
+        const H5::DataType file_type = dataset.getDataType();
+        if(H5Tequal(file_type.getId(), mem_type.getId()) > 0)
+        {
+            dataset.read(out, mem_type, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
+            return;
+        }
+        const HDF5Utils::CompoundCopyPlan plan = HDF5Utils::BuildCompoundCopyPlan(file_type.getId(), mem_type.getId());
+        if(not plan.valid)
+        {
+            dataset.read(out, mem_type, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
+            return;
+        }
+
+        const H5::DataSpace filespace = dataset.getSpace();
+        std::vector<hsize_t> dims(filespace.getSimpleExtentNdims());
+        filespace.getSimpleExtentDims(dims.data());
+        HDF5Utils::Buffer<char> buffer(CompoundStagingBytes(dims, plan.srcSize));
+        if(not buffer.empty())
+        {
+            ReadCompoundBlocks(dataset, out, file_type, plan, buffer.data(), buffer.size());
+        }
+    }
+
     template<typename Scalar, typename Vec>
     void ReadRectangularDataUnflatten(Scalar *flat, const hsize_t *dims, int ndims, Vec &out)
     {
@@ -57,6 +360,232 @@ namespace HDF5Reader_detail
         }
     }
 
+    // Sizes `data` to `dims` and fills its records through `fill(records, count)`, flattening nested containers.
+    template<typename Container, typename Fill>
+    void FillRectangularRecords(Container &data, const std::vector<hsize_t> &dims, Fill fill)
+    {
+        using Scalar = typename HDF5Utils::InnerType<Container>::type;
+        constexpr int levels = HDF5Utils::Rank<Container>::value - 1;
+        size_t total = 1;
+        for(hsize_t d : dims)
+        {
+            total *= d;
+        }
+        if constexpr(levels == 1)
+        {
+            HDF5Utils::ContainerResize(data, total);
+            fill(data.data(), total);
+        }
+        else
+        {
+            if(dims.size() != static_cast<size_t>(levels))
+            {
+                throw std::runtime_error("HDF5Reader: container rank does not match the dataset rank");
+            }
+            HDF5Utils::Buffer<Scalar> flat(total);
+            fill(flat.data(), total);
+            HDF5Utils::ContainerResize(data, dims[0]);
+            const size_t stride = dims[0] == 0 ? 0 : total / dims[0];
+            for(hsize_t i = 0; i < dims[0]; ++i)
+            {
+                ReadRectangularDataUnflatten<Scalar>(flat.data() + i * stride, dims.data() + 1, levels - 1, data[i]);
+            }
+        }
+    }
+
+    // Partial compound read: only the members `fields` of `mem_type` are read, the other members of `out` keep their values.
+    template<typename T>
+    void ReadCompoundFields(const H5::DataSet &dataset, T *out, const H5::DataType &mem_type, const std::vector<std::string> &fields)
+    {
+        const H5::DataType file_type = dataset.getDataType();
+        const hid_t partial_id = H5Tcreate(H5T_COMPOUND, mem_type.getSize());
+        H5::DataType partial(partial_id);
+        H5Tclose(partial_id);
+        for(const std::string &field : fields)
+        {
+            const int index = H5Tget_member_index(mem_type.getId(), field.c_str());
+            if(index < 0 or H5Tget_member_index(file_type.getId(), field.c_str()) < 0)
+            {
+                throw std::runtime_error("HDF5Reader: no field " + field + " in both the dataset and the record type");
+            }
+            const hid_t member_id = H5Tget_member_type(mem_type.getId(), index);
+            H5Tinsert(partial.getId(), field.c_str(), H5Tget_member_offset(mem_type.getId(), index), member_id);
+            H5Tclose(member_id);
+        }
+        H5::DSetMemXferPropList xfer;
+        xfer.setPreserve(true);
+        ReadCompoundData(dataset, out, partial, xfer);
+    }
+
+    // Reads a columnar compound element (see `HDF5Utils::CompoundLayout::Columnar`) into `data`.
+    // With `fields`, only those members are read and the others keep their values.
+    template<typename Container>
+    void ReadColumnarData(const H5::Group &columns, Container &data, const std::vector<std::string> *fields)
+    {
+        // any other group, e.g. a sparse element, is not read as columns
+        std::string layout;
+        if(columns.attrExists(HDF5Utils::LayoutAttribute))
+        {
+            const H5::Attribute attribute = columns.openAttribute(HDF5Utils::LayoutAttribute);
+            attribute.read(attribute.getStrType(), layout);
+        }
+        if(layout != HDF5Utils::ColumnarLayout)
+        {
+            throw std::runtime_error("HDF5Reader: not a columnar element: " + columns.getObjName());
+        }
+        using Scalar = typename HDF5Utils::InnerType<Container>::type;
+        const H5::DataType mem_type = HDF5Utils::CompTypeCreator<Scalar>::get();
+        const hid_t mem_id = mem_type.getId();
+
+        std::vector<int> members;
+        if(fields)
+        {
+            for(const std::string &field : *fields)
+            {
+                const int index = H5Tget_member_index(mem_id, field.c_str());
+                if(index < 0)
+                {
+                    throw std::runtime_error("HDF5Reader: no field " + field + " in the record type");
+                }
+                members.push_back(index);
+            }
+        }
+        else
+        {
+            for(int m = 0; m < H5Tget_nmembers(mem_id); ++m)
+            {
+                members.push_back(m);
+            }
+        }
+
+        std::vector<H5::DataSet> datasets;
+        std::vector<hsize_t> dims;
+        for(int m : members)
+        {
+            char *member_name = H5Tget_member_name(mem_id, m);
+            const std::string column(member_name);
+            H5free_memory(member_name);
+            if(not columns.exists(column))
+            {
+                throw std::runtime_error("HDF5Reader: columnar element has no member " + column);
+            }
+            datasets.push_back(columns.openDataSet(column));
+            const H5::DataSpace space = datasets.back().getSpace();
+            std::vector<hsize_t> column_dims(space.getSimpleExtentNdims());
+            space.getSimpleExtentDims(column_dims.data());
+            if(datasets.size() > 1 and column_dims != dims)
+            {
+                throw std::runtime_error("HDF5Reader: columns of a columnar element differ in shape");
+            }
+            dims = column_dims;
+        }
+        if(members.empty())
+        {
+            return;
+        }
+
+        FillRectangularRecords(data, dims, [&](Scalar *out, size_t)
+        {
+            const int ndims = static_cast<int>(dims.size());
+            size_t row_records = 1;
+            for(int i = 1; i < ndims; ++i)
+            {
+                row_records *= dims[i];
+            }
+            if(ndims == 0 or dims[0] == 0 or row_records == 0)
+            {
+                return;
+            }
+            for(size_t c = 0; c < members.size(); ++c)
+            {
+                const hid_t member_id = H5Tget_member_type(mem_id, members[c]);
+                H5::DataType column_type(member_id);
+                H5Tclose(member_id);
+                const size_t size = column_type.getSize();
+                HDF5Utils::CompoundCopyPlan scatter;
+                scatter.segments.push_back({0, H5Tget_member_offset(mem_id, members[c]), size});
+                scatter.srcSize = size;
+                scatter.dstSize = sizeof(Scalar);
+                scatter.valid = true;
+                const hsize_t block_rows = std::max<hsize_t>(1, HDF5Utils::CompoundBlockBytes / (row_records * size));
+                HDF5Utils::Buffer<char> buffer(std::min(block_rows, dims[0]) * row_records * size);
+                H5::DataSpace filespace = datasets[c].getSpace();
+                std::vector<hsize_t> start(ndims, 0);
+                std::vector<hsize_t> count(dims);
+                for(hsize_t row = 0; row < dims[0]; row += block_rows)
+                {
+                    start[0] = row;
+                    count[0] = std::min(block_rows, dims[0] - row);
+                    H5::DataSpace memspace(ndims, count.data());
+                    filespace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+                    datasets[c].read(buffer.data(), column_type, memspace, filespace);
+                    HDF5Utils::ApplyCompoundCopyPlan(scatter, buffer.data(), out + row * row_records, count[0] * row_records);
+                }
+            }
+        });
+    }
+
+    // Concurrent-mode read of a numeric rectangular dataset with `pread`, outside the HDF5 library.
+    // Returns false if the dataset cannot be read this way.
+    template<typename Container>
+    bool ReadRawData(const ConcurrentState &state, const RawLayout &layout, Container &data)
+    {
+        using Scalar = typename HDF5Utils::InnerType<Container>::type;
+        constexpr int levels = HDF5Utils::Rank<Container>::value - 1;
+        const int ndims = static_cast<int>(layout.dims.size());
+        if(not layout.supported or not RawConvertible<Scalar>(layout) or (levels > 1 and ndims != levels))
+        {
+            return false;
+        }
+        size_t total = 1;
+        for(int i = 0; i < ndims; ++i)
+        {
+            total *= layout.dims[i];
+        }
+
+        HDF5Utils::Buffer<Scalar> flat;
+        Scalar *values;
+        if constexpr(levels == 1)
+        {
+            HDF5Utils::ContainerResize(data, total);
+            values = data.data();
+        }
+        else
+        {
+            flat.resize(total);
+            values = flat.data();
+        }
+
+        if(layout.typeSize == sizeof(Scalar) and not layout.swap)
+        {
+            if(not ReadRawBytes(state.fd, layout, reinterpret_cast<char*>(values), state.threads))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            HDF5Utils::Buffer<char> raw(total * layout.typeSize);
+            if(not ReadRawBytes(state.fd, layout, raw.data(), state.threads))
+            {
+                return false;
+            }
+            ConvertRaw(layout, raw.data(), total, values);
+        }
+
+        if constexpr(levels > 1)
+        {
+            HDF5Utils::ContainerResize(data, layout.dims[0]);
+            size_t stride = 1;
+            for(int i = 1; i < ndims; ++i) stride *= layout.dims[i];
+            for(hsize_t i = 0; i < layout.dims[0]; ++i)
+            {
+                ReadRectangularDataUnflatten<Scalar>(flat.data() + i * stride, layout.dims.data() + 1, ndims - 1, data[i]);
+            }
+        }
+        return true;
+    }
+
     template<typename Container>
     void ReadRectangularData(const H5::DataSet &dataset, Container &data, const hsize_t *dims, int ndims)
     {
@@ -72,16 +601,21 @@ namespace HDF5Reader_detail
 
             if constexpr(std::is_same_v<Scalar, std::string>)
             {
-                std::vector<std::string> flat(total);
-                if(total > 0)
+                HDF5Utils::Buffer<std::string> flat(total);
+                if(total > 0 and dataset.getTypeClass() == H5T_ENUM)
+                {
+                    ReadDictionaryStrings(dataset, H5::DataSpace::ALL, H5::DataSpace::ALL, flat.data(), total);
+                }
+                else if(total > 0)
                 {
                     H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
-                    std::vector<char*> rdata(total);
-                    dataset.read(rdata.data(), strType);
+                    const H5::DSetMemXferPropList xfer = HDF5Utils::VlenTransfer();
+                    HDF5Utils::Buffer<char*> rdata(total);
+                    dataset.read(rdata.data(), strType, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
                     for(size_t i = 0; i < total; i++)
                         flat[i] = std::string(rdata[i]);
                     H5::DataSpace space = dataset.getSpace();
-                    H5Dvlen_reclaim(strType.getId(), space.getId(), H5P_DEFAULT, rdata.data());
+                    H5Dvlen_reclaim(strType.getId(), space.getId(), xfer.getId(), rdata.data());
                 }
 
                 HDF5Utils::ContainerResize(data, dims[0]);
@@ -94,13 +628,16 @@ namespace HDF5Reader_detail
             }
             else
             {
-                std::vector<Scalar> flat(total);
+                HDF5Utils::Buffer<Scalar> flat(total);
                 H5::DataType mem_type;
                 if constexpr(HDF5Utils::HasCompType<Scalar>::value)
                     mem_type = H5::DataType(HDF5Utils::CompTypeCreator<Scalar>::get());
                 else
                     mem_type = H5::DataType(HDF5Utils::HDF5Type<Scalar>::value());
-                dataset.read(flat.data(), mem_type);
+                if constexpr(HDF5Utils::HasCompType<Scalar>::value)
+                    ReadCompoundData(dataset, flat.data(), mem_type);
+                else
+                    dataset.read(flat.data(), mem_type);
 
                 HDF5Utils::ContainerResize(data, dims[0]);
                 size_t stride = 1;
@@ -119,15 +656,20 @@ namespace HDF5Reader_detail
                 total *= dims[i];
             }
             HDF5Utils::ContainerResize(data, total);
-            if(total > 0)
+            if(total > 0 and dataset.getTypeClass() == H5T_ENUM)
+            {
+                ReadDictionaryStrings(dataset, H5::DataSpace::ALL, H5::DataSpace::ALL, data.data(), total);
+            }
+            else if(total > 0)
             {
                 H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
-                std::vector<char*> rdata(total);
-                dataset.read(rdata.data(), strType);
+                const H5::DSetMemXferPropList xfer = HDF5Utils::VlenTransfer();
+                HDF5Utils::Buffer<char*> rdata(total);
+                dataset.read(rdata.data(), strType, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
                 for(size_t i = 0; i < total; i++)
                     data[i] = std::string(rdata[i]);
                 H5::DataSpace space = dataset.getSpace();
-                H5Dvlen_reclaim(strType.getId(), space.getId(), H5P_DEFAULT, rdata.data());
+                H5Dvlen_reclaim(strType.getId(), space.getId(), xfer.getId(), rdata.data());
             }
         }
         else
@@ -145,7 +687,10 @@ namespace HDF5Reader_detail
                 mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
             if(not data.empty())
             {
-                dataset.read(data.data(), mem_type);
+                if constexpr(HDF5Utils::HasCompType<T>::value)
+                    ReadCompoundData(dataset, data.data(), mem_type);
+                else
+                    dataset.read(data.data(), mem_type);
             }
         }
     }
@@ -225,8 +770,9 @@ namespace HDF5Reader_detail
         const H5::DataSpace filespace = dataset.getSpace();
         filespace.getSimpleExtentDims(dims);
 
-        std::vector<hvl_t> vhl(dims[0]);
-        H5Dread(dataset.getId(), vlen_tid, H5S_ALL, H5S_ALL, H5P_DEFAULT, vhl.data());
+        const H5::DSetMemXferPropList xfer = HDF5Utils::VlenTransfer();
+        HDF5Utils::Buffer<hvl_t> vhl(dims[0]);
+        H5Dread(dataset.getId(), vlen_tid, H5S_ALL, H5S_ALL, xfer.getId(), vhl.data());
 
         HDF5Utils::ContainerResize(data, dims[0]);
         for(hsize_t i = 0; i < dims[0]; i++)
@@ -235,7 +781,7 @@ namespace HDF5Reader_detail
             ReadJaggedDataNestedVLENImpl(vhl[i].p, vhl[i].len, data[i], inner_tid);
         }
 
-        H5Dvlen_reclaim(vlen_tid, filespace.getId(), H5P_DEFAULT, vhl.data());
+        H5Dvlen_reclaim(vlen_tid, filespace.getId(), xfer.getId(), vhl.data());
         for(size_t i = 1; i < type_chain.size(); i++)
         {
             H5Tclose(type_chain[i]);
@@ -260,9 +806,10 @@ namespace HDF5Reader_detail
         const H5::DataSpace filespace = dataset.getSpace();
         filespace.getSimpleExtentDims(dims);
 
-        std::vector<hvl_t> vhl(dims[0]);
+        const H5::DSetMemXferPropList xfer = HDF5Utils::VlenTransfer();
+        HDF5Utils::Buffer<hvl_t> vhl(dims[0]);
         H5::VarLenType vlen_type(&base_type);
-        dataset.read(vhl.data(), vlen_type);
+        dataset.read(vhl.data(), vlen_type, H5::DataSpace::ALL, H5::DataSpace::ALL, xfer);
 
         HDF5Utils::ContainerResize(data, dims[0]);
         for(hsize_t i = 0; i < dims[0]; i++)
@@ -272,7 +819,7 @@ namespace HDF5Reader_detail
                 memcpy(data[i].data(), vhl[i].p, vhl[i].len * sizeof(T));
         }
 
-        H5Dvlen_reclaim(vlen_tid, filespace.getId(), H5P_DEFAULT, vhl.data());
+        H5Dvlen_reclaim(vlen_tid, filespace.getId(), xfer.getId(), vhl.data());
     }
 
     template<typename Container>
@@ -319,6 +866,274 @@ namespace HDF5Reader_detail
         }
     }
 
+    // Format and dense shape of a sparse element, from the attributes of its group.
+    struct SparseHeader
+    {
+        HDF5Utils::SparseFormat format = HDF5Utils::SparseFormat::CSR;
+        std::vector<hsize_t> shape;
+        bool sorted = false;        // COO values sorted by row
+    };
+
+    inline SparseHeader ReadSparseHeader(const H5::Group &group, const std::string &path)
+    {
+        if(not group.attrExists(HDF5Utils::LayoutAttribute) or not group.attrExists(HDF5Utils::ShapeAttribute))
+        {
+            throw std::runtime_error("HDF5Reader: not a sparse element: " + path);
+        }
+        std::string layout;
+        const H5::Attribute layout_attribute = group.openAttribute(HDF5Utils::LayoutAttribute);
+        layout_attribute.read(layout_attribute.getStrType(), layout);
+
+        SparseHeader header;
+        if(layout == HDF5Utils::CsrLayout)
+            header.format = HDF5Utils::SparseFormat::CSR;
+        else if(layout == HDF5Utils::CscLayout)
+            header.format = HDF5Utils::SparseFormat::CSC;
+        else if(layout == HDF5Utils::CooLayout)
+            header.format = HDF5Utils::SparseFormat::COO;
+        else
+            throw std::runtime_error("HDF5Reader: not a sparse element: " + path);
+
+        const H5::Attribute shape_attribute = group.openAttribute(HDF5Utils::ShapeAttribute);
+        header.shape.resize(shape_attribute.getSpace().getSimpleExtentNpoints());
+        shape_attribute.read(HDF5Utils::HDF5Type<hsize_t>::value(), header.shape.data());
+        if((header.format == HDF5Utils::SparseFormat::COO) ? header.shape.empty() : header.shape.size() != 2)
+        {
+            throw std::runtime_error("HDF5Reader: sparse element has an invalid shape: " + path);
+        }
+        header.sorted = group.attrExists(HDF5Utils::SortedAttribute);
+        return header;
+    }
+
+    inline hsize_t FirstExtent(const H5::DataSet &dataset)
+    {
+        const H5::DataSpace space = dataset.getSpace();
+        if(space.getSimpleExtentNdims() == 0)
+        {
+            return 1;
+        }
+        std::vector<hsize_t> dims(space.getSimpleExtentNdims());
+        space.getSimpleExtentDims(dims.data());
+        return dims[0];
+    }
+
+    // Index of the first value in [low, high) of a sorted COO element whose row is at least `row`, or `high`.
+    // Bisects over the first coordinates, reading one at a time.
+    inline hsize_t LowerBoundRow(const H5::DataSet &indices, hsize_t low, hsize_t high, hsize_t row)
+    {
+        H5::DataSpace fileSpace = indices.getSpace();
+        const H5::DataSpace memSpace;
+        const hsize_t one[] = {1, 1};
+        while(low < high)
+        {
+            const hsize_t middle = low + (high - low) / 2;
+            const hsize_t start[] = {middle, 0};
+            fileSpace.selectHyperslab(H5S_SELECT_SET, one, start);
+            hsize_t value = 0;
+            indices.read(&value, HDF5Utils::HDF5Type<hsize_t>::value(), memSpace, fileSpace);
+            if(value < row)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    // Reads the rows (CSR) or columns (CSC) [first, first + count) of the sparse element in `group`, `indptr` rebased to 0.
+    template<typename T>
+    void ReadCompressedSlice(const H5::Group &group, hsize_t first, hsize_t count, HDF5Utils::SparseArray<T> &data)
+    {
+        ReadRowsData(group.openDataSet("indptr"), first, count + 1, 1, data.indptr);
+        const hsize_t begin = data.indptr.front();
+        const hsize_t end = data.indptr.back();
+        if(end < begin)
+        {
+            throw std::runtime_error("HDF5Reader: sparse element has a decreasing indptr");
+        }
+        for(hsize_t &offset : data.indptr)
+        {
+            offset -= begin;
+        }
+        ReadRowsData(group.openDataSet("indices"), begin, end - begin, 1, data.indices);
+        ReadRowsData(group.openDataSet("values"), begin, end - begin, 1, data.values);
+    }
+
+    // Reads the values of the COO element in `group` whose row is in [first, first + count), rows rebased to `first`.
+    // Sorted elements read only that range; others are scanned whole.
+    template<typename T>
+    void ReadCooRows(const H5::Group &group, const SparseHeader &header, hsize_t first, hsize_t count, HDF5Utils::SparseArray<T> &data)
+    {
+        const H5::DataSet indices = group.openDataSet("indices");
+        const H5::DataSet values = group.openDataSet("values");
+        const size_t rank = header.shape.size();
+        const hsize_t nnz = FirstExtent(values);
+        data.indptr.clear();
+        if(header.sorted)
+        {
+            const hsize_t begin = LowerBoundRow(indices, 0, nnz, first);
+            const hsize_t end = LowerBoundRow(indices, begin, nnz, first + count);
+            ReadRowsData(indices, begin, end - begin, 1, data.indices);
+            ReadRowsData(values, begin, end - begin, 1, data.values);
+        }
+        else
+        {
+            ReadRowsData(indices, 0, nnz, 1, data.indices);
+            ReadRowsData(values, 0, nnz, 1, data.values);
+            size_t kept = 0;
+            for(size_t i = 0; i < data.values.size(); ++i)
+            {
+                const hsize_t row = data.indices[i * rank];
+                if(row >= first and row - first < count)
+                {
+                    std::copy_n(data.indices.begin() + i * rank, rank, data.indices.begin() + kept * rank);
+                    data.values[kept++] = data.values[i];
+                }
+            }
+            data.indices.resize(kept * rank);
+            data.values.resize(kept);
+        }
+        for(size_t i = 0; i < data.indices.size(); i += rank)
+        {
+            data.indices[i] -= first;
+        }
+    }
+
+    template<typename T>
+    void ReadSparseData(const H5::Group &group, const std::string &path, HDF5Utils::SparseArray<T> &data)
+    {
+        const SparseHeader header = ReadSparseHeader(group, path);
+        data.format = header.format;
+        data.shape = header.shape;
+        const H5::DataSet values = group.openDataSet("values");
+        const hsize_t nnz = FirstExtent(values);
+        if(header.format == HDF5Utils::SparseFormat::COO)
+        {
+            data.indptr.clear();
+        }
+        else
+        {
+            const H5::DataSet indptr = group.openDataSet("indptr");
+            ReadRowsData(indptr, 0, FirstExtent(indptr), 1, data.indptr);
+        }
+        ReadRowsData(group.openDataSet("indices"), 0, nnz, 1, data.indices);
+        ReadRowsData(values, 0, nnz, 1, data.values);
+    }
+
+    // Reads rows [first, first + rows) of a sparse element as a sparse element of `rows` rows, in the same format.
+    template<typename T>
+    void ReadSparseRowsData(const H5::Group &group, const std::string &path, hsize_t first, hsize_t rows, HDF5Utils::SparseArray<T> &data)
+    {
+        const SparseHeader header = ReadSparseHeader(group, path);
+        if(first > header.shape[0] or rows > header.shape[0] - first)
+        {
+            throw std::runtime_error("HDF5Reader: rows out of range");
+        }
+        data.format = header.format;
+        data.shape = header.shape;
+        data.shape[0] = rows;
+        if(header.format == HDF5Utils::SparseFormat::CSR)
+        {
+            ReadCompressedSlice(group, first, rows, data);
+        }
+        else if(header.format == HDF5Utils::SparseFormat::COO)
+        {
+            ReadCooRows(group, header, first, rows, data);
+        }
+        else
+        {
+            // the rows are spread over all columns: read everything and keep the values within the rows
+            ReadSparseData(group, path, data);
+            data.shape[0] = rows;
+            size_t kept = 0;
+            hsize_t begin = data.indptr[0];
+            for(size_t column = 0; column + 1 < data.indptr.size(); ++column)
+            {
+                const hsize_t end = data.indptr[column + 1];
+                data.indptr[column] = kept;
+                for(hsize_t i = begin; i < end; ++i)
+                {
+                    if(data.indices[i] >= first and data.indices[i] - first < rows)
+                    {
+                        data.indices[kept] = data.indices[i] - first;
+                        data.values[kept++] = data.values[i];
+                    }
+                }
+                begin = end;
+            }
+            data.indptr.back() = kept;
+            data.indices.resize(kept);
+            data.values.resize(kept);
+        }
+    }
+
+    // Densifies the block of `count` elements from `offset` of a sparse element into `data`, in row-major order.
+    // Only the rows (CSR, COO) or columns (CSC) of the block are read. Duplicate coordinates are summed.
+    template<typename T, typename Allocator>
+    void ReadDenseBlockData(const H5::Group &group, const std::string &path, const std::vector<hsize_t> &offset,
+                            const std::vector<hsize_t> &count, std::vector<T, Allocator> &data)
+    {
+        const SparseHeader header = ReadSparseHeader(group, path);
+        const size_t rank = header.shape.size();
+        if(offset.size() != rank or count.size() != rank)
+        {
+            throw std::runtime_error("HDF5Reader: block rank does not match the sparse element " + path);
+        }
+        size_t total = 1;
+        for(size_t d = 0; d < rank; ++d)
+        {
+            if(offset[d] > header.shape[d] or count[d] > header.shape[d] - offset[d])
+            {
+                throw std::runtime_error("HDF5Reader: block out of range");
+            }
+            total *= count[d];
+        }
+        data.assign(total, T());
+        if(total == 0)
+        {
+            return;
+        }
+
+        HDF5Utils::SparseArray<T> slice;
+        if(header.format == HDF5Utils::SparseFormat::COO)
+        {
+            ReadCooRows(group, header, offset[0], count[0], slice);
+            for(size_t i = 0; i < slice.values.size(); ++i)
+            {
+                const hsize_t *coordinates = slice.indices.data() + i * rank;
+                size_t position = coordinates[0];
+                bool inside = true;
+                for(size_t d = 1; d < rank and inside; ++d)
+                {
+                    inside = coordinates[d] >= offset[d] and coordinates[d] - offset[d] < count[d];
+                    position = position * count[d] + (coordinates[d] - offset[d]);
+                }
+                if(inside)
+                {
+                    data[position] += slice.values[i];
+                }
+            }
+            return;
+        }
+
+        const bool csr = header.format == HDF5Utils::SparseFormat::CSR;
+        const size_t major = csr ? 0 : 1;
+        const size_t minor = 1 - major;
+        ReadCompressedSlice(group, offset[major], count[major], slice);
+        for(hsize_t m = 0; m < count[major]; ++m)
+        {
+            for(hsize_t i = slice.indptr[m]; i < slice.indptr[m + 1]; ++i)
+            {
+                const hsize_t k = slice.indices[i];
+                if(k < offset[minor] or k - offset[minor] >= count[minor])
+                {
+                    continue;
+                }
+                const hsize_t local = k - offset[minor];
+                data[csr ? m * count[1] + local : local * count[1] + m] += slice.values[i];
+            }
+        }
+    }
+
     template<typename Container>
     void ReadContainerData(const H5::DataSet &dataset, Container &data)
     {
@@ -357,6 +1172,109 @@ namespace HDF5Reader_detail
         // else, data is rectangular
         ReadRectangularData(dataset, data, dims.data(), ndims);
     }
+
+    // Reads the values of the numeric dataset at `path` within `range`, and their row-major indices, block by block.
+    // Blocks follow the zone map if the dataset has a valid one, which skips blocks that cannot match; otherwise
+    // they are chunks, or about 1 MiB of rows of a contiguous dataset.
+    template<typename T, typename Allocator>
+    HDF5Utils::ScanStats ReadWhereData(const H5::H5File &file, const H5::DataSet &dataset, const std::string &path,
+                                       const HDF5Utils::ValueRange<T> &range, std::vector<T, Allocator> &values,
+                                       std::vector<hsize_t> &indices)
+    {
+        const H5T_class_t type_class = dataset.getTypeClass();
+        if(type_class != H5T_INTEGER and type_class != H5T_FLOAT)
+        {
+            throw std::runtime_error("HDF5Reader: ReadWhere() needs a numeric dataset: " + path);
+        }
+        const H5::DataSpace space = dataset.getSpace();
+        const int ndims = space.getSimpleExtentNdims();
+        std::vector<hsize_t> dims(ndims);
+        space.getSimpleExtentDims(dims.data());
+        const hsize_t rows = ndims == 0 ? 1 : dims[0];
+        size_t row = 1;
+        for(int i = 1; i < ndims; ++i)
+        {
+            row *= dims[i];
+        }
+
+        HDF5Utils::ScanStats stats;
+        hsize_t block_rows = 0;
+        std::vector<T> ranges;
+        if(ndims > 0 and dataset.attrExists(HDF5Utils::ZoneMapRowsAttribute))
+        {
+            dataset.openAttribute(HDF5Utils::ZoneMapRowsAttribute).read(HDF5Utils::HDF5Type<hsize_t>::value(), &block_rows);
+            const std::string map_path = HDF5Utils::ZoneMapPath(path);
+            hid_t map_id = H5I_INVALID_HID;
+            if(block_rows > 0)
+            {
+                H5E_BEGIN_TRY
+                {
+                    map_id = H5Dopen2(file.getId(), map_path.c_str(), H5P_DEFAULT);
+                }
+                H5E_END_TRY;
+            }
+            if(map_id >= 0)
+            {
+                const H5::DataSet map(map_id);
+                H5Dclose(map_id);
+                const H5::DataSpace map_space = map.getSpace();
+                hsize_t map_dims[2] = {0, 0};
+                if(map_space.getSimpleExtentNdims() == 2)
+                {
+                    map_space.getSimpleExtentDims(map_dims);
+                }
+                // a zone map of another shape belongs to an earlier version of the element
+                if(map_dims[0] == (rows + block_rows - 1) / block_rows and map_dims[1] == 2)
+                {
+                    ranges.resize(2 * map_dims[0]);
+                    if(not ranges.empty())
+                    {
+                        map.read(ranges.data(), HDF5Utils::HDF5Type<T>::value());
+                    }
+                    stats.zoneMap = true;
+                }
+            }
+        }
+        if(not stats.zoneMap)
+        {
+            const H5::DSetCreatPropList plist = dataset.getCreatePlist();
+            if(ndims > 0 and plist.getLayout() == H5D_CHUNKED)
+            {
+                std::vector<hsize_t> chunk(ndims);
+                plist.getChunk(ndims, chunk.data());
+                block_rows = chunk[0];
+            }
+            else
+            {
+                block_rows = std::max<hsize_t>(1, (1 << 20) / std::max<size_t>(1, row * sizeof(T)));
+            }
+        }
+
+        values.clear();
+        indices.clear();
+        stats.blocks = row == 0 ? 0 : (rows + block_rows - 1) / block_rows;
+        std::vector<T> buffer;
+        for(size_t b = 0; b < stats.blocks; ++b)
+        {
+            if(stats.zoneMap and not range.Overlaps(ranges[2 * b], ranges[2 * b + 1]))
+            {
+                continue;
+            }
+            const hsize_t first = b * block_rows;
+            ReadRowsData(dataset, first, std::min(block_rows, rows - first), 1, buffer);
+            ++stats.blocksRead;
+            const hsize_t base = first * row;
+            for(size_t i = 0; i < buffer.size(); ++i)
+            {
+                if(range.Contains(buffer[i]))
+                {
+                    values.push_back(buffer[i]);
+                    indices.push_back(base + i);
+                }
+            }
+        }
+        return stats;
+    }
 }
 
 #endif // HDF5READER_DETAIL_HPP
\ No newline at end of file
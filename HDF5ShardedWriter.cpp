@@ -0,0 +1,192 @@
+#include "HDF5ShardedWriter.hpp"
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/wait.h>
+#define HDF5SHARDEDWRITER_FORK 1
+#endif
+
+HDF5ShardedWriter::HDF5ShardedWriter(const std::string &filename, int shards, HDF5Utils::ShardWorkers workers)
+    : filename_(filename), workers_(workers), used_(workers)
+{
+    if(shards < 1)
+    {
+        throw std::runtime_error("HDF5ShardedWriter: number of shards must be positive");
+    }
+    // <stem>.shard<k><extension>, next to the master file
+    const size_t slash = filename.find_last_of('/');
+    const size_t dot = filename.find_last_of('.');
+    const bool hasExtension = dot != std::string::npos and (slash == std::string::npos or dot > slash);
+    const std::string stem = hasExtension ? filename.substr(0, dot) : filename;
+    const std::string extension = hasExtension ? filename.substr(dot) : "";
+    for(int k = 0; k < shards; ++k)
+    {
+        this->shardFiles_.push_back(stem + ".shard" + std::to_string(k) + extension);
+    }
+}
+
+void HDF5ShardedWriter::WriteShard(int shard, std::mutex *mutex) const
+{
+    const size_t shards = this->shardFiles_.size();
+    std::optional<HDF5Writer> writer;
+    try
+    {
+        {
+            const std::unique_lock<std::mutex> lock = Lock(mutex);
+            writer.emplace(this->shardFiles_[shard]);
+        }
+        for(const Element &element : this->elements_)
+        {
+            if(element.partitioned)
+            {
+                const size_t rows = element.rows();
+                element.write(*writer, rows * shard / shards, rows * (shard + 1) / shards, mutex);
+            }
+            else if(element.shard == shard)
+            {
+                element.write(*writer, 0, 0, mutex);
+            }
+        }
+    }
+    catch(...)
+    {
+        const std::unique_lock<std::mutex> lock = Lock(mutex);
+        writer.reset();
+        throw;
+    }
+    const std::unique_lock<std::mutex> lock = Lock(mutex);
+    writer->Close();
+    writer.reset();
+}
+
+void HDF5ShardedWriter::Dump(void)
+{
+    const int shards = static_cast<int>(this->shardFiles_.size());
+
+    // largest elements first, each to the least loaded shard
+    std::vector<size_t> order(this->elements_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b){ return this->elements_[a].bytes > this->elements_[b].bytes; });
+    std::vector<size_t> load(shards, 0);
+    for(size_t i : order)
+    {
+        Element &element = this->elements_[i];
+        if(element.partitioned)
+        {
+            for(size_t &l : load)
+            {
+                l += element.bytes / shards;
+            }
+            continue;
+        }
+        element.shard = static_cast<int>(std::min_element(load.begin(), load.end()) - load.begin());
+        load[element.shard] += element.bytes;
+    }
+
+    bool failed = false;
+    this->used_ = HDF5Utils::ShardWorkers::Threads;
+#ifdef HDF5SHARDEDWRITER_FORK
+    if(this->workers_ == HDF5Utils::ShardWorkers::Processes)
+    {
+        // a child must not inherit open HDF5 files or objects, which both processes would then use
+        const unsigned open_types = H5F_OBJ_FILE | H5F_OBJ_DATASET | H5F_OBJ_GROUP | H5F_OBJ_ATTR;
+        if(H5Fget_obj_count(H5F_OBJ_ALL, open_types) != 0)
+        {
+            throw std::runtime_error("HDF5ShardedWriter: cannot fork the shard writers of " + this->filename_ +
+                                     " while HDF5 objects are open; close them or use ShardWorkers::Threads");
+        }
+        this->used_ = HDF5Utils::ShardWorkers::Processes;
+        bool forked = true;
+        std::vector<pid_t> children;
+        for(int k = 0; k < shards; ++k)
+        {
+            const pid_t pid = fork();
+            if(pid == 0)
+            {
+                int status = 0;
+                try
+                {
+                    this->WriteShard(k, nullptr);
+                }
+                catch(...)
+                {
+                    status = 1;
+                }
+                // skip atexit handlers: the HDF5 library state inherited from the parent must not be torn down here
+                _exit(status);
+            }
+            if(pid < 0)
+            {
+                forked = false;
+                break;
+            }
+            children.push_back(pid);
+        }
+        for(pid_t pid : children)
+        {
+            int status = 0;
+            if(waitpid(pid, &status, 0) < 0 or not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+            {
+                failed = true;
+            }
+        }
+        if(not forked)
+        {
+            throw std::runtime_error("HDF5ShardedWriter: cannot fork the shard writers of " + this->filename_);
+        }
+    }
+    else
+#endif
+    {
+        // the H5:: wrappers are not thread safe, even over a threadsafe library
+        std::mutex mutex;
+        std::vector<std::thread> threads;
+        std::vector<char> errors(shards, 0);
+        for(int k = 0; k < shards; ++k)
+        {
+            threads.emplace_back([this, k, &errors, &mutex]()
+            {
+                try
+                {
+                    this->WriteShard(k, &mutex);
+                }
+                catch(...)
+                {
+                    errors[k] = 1;
+                }
+            });
+        }
+        for(std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        failed = std::find(errors.begin(), errors.end(), 1) != errors.end();
+    }
+    if(failed)
+    {
+        throw std::runtime_error("HDF5ShardedWriter: writing a shard of " + this->filename_ + " failed");
+    }
+
+    std::vector<std::string> sources;
+    for(const std::string &shardFile : this->shardFiles_)
+    {
+        const size_t slash = shardFile.find_last_of('/');
+        sources.push_back(slash == std::string::npos ? shardFile : shardFile.substr(slash + 1));
+    }
+    HDF5Writer master(this->filename_);
+    for(const Element &element : this->elements_)
+    {
+        if(element.partitioned)
+        {
+            master.AddVirtualDataset(sources, element.path, element.path);
+        }
+        else
+        {
+            master.AddExternalLink(sources[element.shard], element.path, element.path);
+        }
+    }
+    master.Close();
+}
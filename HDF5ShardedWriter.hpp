@@ -0,0 +1,158 @@
+#ifndef HDF5SHARDEDWRITER_HPP
+#define HDF5SHARDEDWRITER_HPP
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include "HDF5Writer.hpp"
+
+/**
+Spreads elements over `shards` files written in parallel, and writes a master file that exposes them:
+whole elements through external links, partitioned elements through virtual datasets (VDS).
+`HDF5Reader` reads the master file as a regular file.
+*/
+class HDF5ShardedWriter
+{
+public:
+    HDF5ShardedWriter(const std::string &filename, int shards, HDF5Utils::ShardWorkers workers = HDF5Utils::ShardWorkers::Processes);
+
+    /**
+    Adds an element written whole to one of the shards. `data` (or the memory a view refers to) MUST be accessible in `Dump()`.
+    */
+    template<typename T>
+    void AddElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions());
+
+    /**
+    Adds a rectangular element whose rows are split evenly over all shards. `data` MUST be accessible in `Dump()`.
+    Each shard writes its rows straight from `data`; rows of nested vectors, which are separate allocations, are
+    first gathered into one block per shard.
+    */
+    template<typename T>
+    void AddPartitionedElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions());
+
+    /**
+    Writes the shards in parallel, then the master file.
+    In `Processes` mode the children are forked before anything is opened, and they inherit the HDF5 library state of the caller,
+    so this throws if the caller has any HDF5 file or object open at that point; use `Threads` then. Where fork() is not
+    available, the shards are written by threads (see `Workers()`).
+    */
+    void Dump(void);
+
+    /**
+    Returns how the shards of the last `Dump()` were written.
+    */
+    HDF5Utils::ShardWorkers Workers(void) const { return used_; }
+
+    /**
+    Returns the names of the shard files.
+    */
+    const std::vector<std::string> &ShardFiles(void) const { return shardFiles_; }
+
+private:
+    struct Element
+    {
+        std::string path;
+        bool partitioned = false;
+        size_t bytes = 0;
+        int shard = 0;
+        // writes rows [begin, end) of the element, or the whole element if it is not partitioned, holding `mutex` (if any)
+        // around the HDF5 calls
+        std::function<void(HDF5Writer&, size_t, size_t, std::mutex*)> write;
+        std::function<size_t(void)> rows;
+    };
+
+    // Locks `mutex`, or nothing if it is null.
+    static std::unique_lock<std::mutex> Lock(std::mutex *mutex)
+    {
+        return mutex ? std::unique_lock<std::mutex>(*mutex) : std::unique_lock<std::mutex>();
+    }
+
+    void WriteShard(int shard, std::mutex *mutex) const;
+
+    std::string filename_;
+    std::vector<std::string> shardFiles_;
+    HDF5Utils::ShardWorkers workers_;
+    HDF5Utils::ShardWorkers used_;
+    std::vector<Element> elements_;
+};
+
+template<typename T>
+void HDF5ShardedWriter::AddElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options)
+{
+    Element element;
+    element.path = path;
+    element.bytes = HDF5Writer_detail::PayloadBytes(data);
+    if constexpr(HDF5Utils::IsView<T>::value)
+    {
+        element.write = [path, view = data, options](HDF5Writer &writer, size_t, size_t, std::mutex *mutex)
+        {
+            const std::unique_lock<std::mutex> lock = Lock(mutex);
+            writer.WriteElement(path, view, options);
+        };
+    }
+    else
+    {
+        element.write = [path, ptr = &data, options](HDF5Writer &writer, size_t, size_t, std::mutex *mutex)
+        {
+            const std::unique_lock<std::mutex> lock = Lock(mutex);
+            writer.WriteElement(path, *ptr, options);
+        };
+    }
+    this->elements_.push_back(element);
+}
+
+template<typename T>
+void HDF5ShardedWriter::AddPartitionedElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options)
+{
+    static_assert(HDF5Utils::IsVector<T>::value, "HDF5ShardedWriter: partitioned elements must be std::vector");
+    Element element;
+    element.path = path;
+    element.partitioned = true;
+    element.bytes = HDF5Writer_detail::PayloadBytes(data);
+    element.rows = [ptr = &data]()
+    {
+        return ptr->size();
+    };
+    element.write = [path, ptr = &data, options](HDF5Writer &writer, size_t begin, size_t end, std::mutex *mutex)
+    {
+        using Row = typename T::value_type;
+        if constexpr(HDF5Utils::IsContainer<Row>::value)
+        {
+            // gathered before taking the lock, so other shards write meanwhile
+            using Scalar = typename HDF5Utils::InnerType<T>::type;
+            std::vector<hsize_t> dims(HDF5Utils::Rank<Row>::value, 0);
+            if(begin < end and not HDF5Writer_detail::isRectangular((*ptr)[begin], dims))
+            {
+                throw std::runtime_error("HDF5ShardedWriter: partitioned element must be rectangular: " + path);
+            }
+            if(begin < end)
+            {
+                dims.insert(dims.begin(), end - begin);
+            }
+            HDF5Utils::StridedView<Scalar> view(nullptr, dims);
+            HDF5Utils::Buffer<Scalar> block(view.Size());
+            Scalar *out = block.data();
+            for(size_t i = begin; i < end; ++i)
+            {
+                if(not HDF5Writer_detail::flattenRectangularInto((*ptr)[i], dims.data() + 1, out))
+                {
+                    throw std::runtime_error("HDF5ShardedWriter: partitioned element must be rectangular: " + path);
+                }
+            }
+            view.data = block.data();
+            const std::unique_lock<std::mutex> lock = Lock(mutex);
+            writer.WriteElement(path, view, options);
+        }
+        else
+        {
+            // the rows of this shard, in place
+            const std::unique_lock<std::mutex> lock = Lock(mutex);
+            writer.WriteElement(path, HDF5Utils::StridedView<Row>(ptr->data() + begin, {static_cast<hsize_t>(end - begin)}), options);
+        }
+    };
+    this->elements_.push_back(element);
+}
+
+#endif // HDF5SHARDEDWRITER_HPP
@@ -0,0 +1,68 @@
+#ifndef HDF5SPARSE_HPP
+#define HDF5SPARSE_HPP
+
+#include <H5Cpp.h>
+#include <vector>
+#include <string>
+#include <type_traits>
+#include "HDF5Helper.hpp"
+
+namespace HDF5Utils
+{
+    /** Storage format of a `SparseArray`. */
+    enum class SparseFormat
+    {
+        CSR,    // compressed sparse rows: `indptr` has one offset per row (plus one), `indices` holds columns
+        CSC,    // compressed sparse columns: `indptr` has one offset per column (plus one), `indices` holds rows
+        COO     // coordinates: `indices` holds the coordinates of every value, one row of `shape.size()` indices per value
+    };
+
+    /**
+    Sparse matrix (CSR, CSC) or array of any rank (COO), written by `HDF5Writer` as a group with one dataset each for `indptr`,
+    `indices` and `values` and its format and shape as attributes, so the file scales with the number of values instead of
+    the dense shape. Indices are stored in the narrowest unsigned integer type that holds them.
+    `HDF5Reader` reads the whole element, a range of rows (`ReadSparseRows()`) or a densified block (`ReadDenseBlock()`).
+    */
+    template<typename T>
+    struct SparseArray
+    {
+        using value_type = T;
+
+        SparseFormat format = SparseFormat::CSR;
+        std::vector<hsize_t> shape;         // {rows, columns} for CSR and CSC
+        std::vector<hsize_t> indptr;        // CSR and CSC only: values of row (column) i are [indptr[i], indptr[i + 1])
+        std::vector<hsize_t> indices;
+        std::vector<T> values;
+
+        /** Number of stored values. */
+        size_t NonZeros(void) const { return values.size(); }
+    };
+
+    template<typename T>
+    struct IsSparse : std::false_type {};
+    template<typename U>
+    struct IsSparse<SparseArray<U>> : std::true_type {};
+
+    /** Values of `LayoutAttribute` on the group of a sparse element. */
+    inline constexpr const char *CsrLayout = "csr";
+    inline constexpr const char *CscLayout = "csc";
+    inline constexpr const char *CooLayout = "coo";
+
+    /** Attribute of the group of a sparse element holding its dense shape. */
+    inline constexpr const char *ShapeAttribute = "shape";
+
+    /** Attribute set on a COO element whose values are sorted by row (first coordinate), so row ranges are found by bisection. */
+    inline constexpr const char *SortedAttribute = "sorted";
+
+    inline const char *SparseLayoutName(SparseFormat format)
+    {
+        switch(format)
+        {
+            case SparseFormat::CSR: return CsrLayout;
+            case SparseFormat::CSC: return CscLayout;
+            default: return CooLayout;
+        }
+    }
+}
+
+#endif // HDF5SPARSE_HPP
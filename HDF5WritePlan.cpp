@@ -0,0 +1,112 @@
+#include "HDF5WritePlan.hpp"
+
+size_t HDF5WritePlan::GroupIndex(const std::string &groupPath)
+{
+    size_t index = 0;
+    for(const std::string &name : HDF5Utils::splitPath(groupPath))
+    {
+        size_t child = 0;
+        for(size_t g = 1; g < this->groups_.size(); ++g)
+        {
+            if(this->groups_[g].parent == index and this->groups_[g].name == name)
+            {
+                child = g;
+                break;
+            }
+        }
+        if(child == 0)
+        {
+            // parents are registered before their children, so WriteStep() creates them in order
+            child = this->groups_.size();
+            this->groups_.push_back(Group{name, index});
+        }
+        index = child;
+    }
+    return index;
+}
+
+void HDF5WritePlan::AddEntry(Entry entry)
+{
+    // a repeated Add() rebinds the path; the entry is replaced, not assigned, as the H5:: objects have no usable assignment
+    for(auto it = this->entries_.begin(); it != this->entries_.end(); ++it)
+    {
+        if(it->group == entry.group and it->name == entry.name)
+        {
+            this->entries_.insert(it, std::move(entry));
+            this->entries_.erase(it);
+            return;
+        }
+    }
+    this->entries_.push_back(std::move(entry));
+}
+
+void HDF5WritePlan::Write(const std::string &filename)
+{
+    H5::H5File file(filename, H5F_ACC_TRUNC);
+    H5::Group root = file.openGroup("/");
+    this->WriteStep(root, true);
+}
+
+void HDF5WritePlan::Write(HDF5Writer &writer, const std::string &groupPath)
+{
+    const HDF5Utils::ScopedMemoryResource scope(writer.memoryResource_);
+    writer.CatalogChanged();
+    H5::Group root = HDF5Utils::openGroupPath(writer.file_, groupPath, true);
+    this->WriteStep(root, root.getNumObjs() == 0);
+}
+
+void HDF5WritePlan::WriteStep(H5::Group &root, bool fresh)
+{
+    // reserved, so the parents referred to stay in place
+    std::vector<H5::Group> groups;
+    groups.reserve(this->groups_.size());
+    groups.push_back(root);
+    for(size_t g = 1; g < this->groups_.size(); ++g)
+    {
+        H5::Group &parent = groups[this->groups_[g].parent];
+        const std::string &name = this->groups_[g].name;
+        groups.push_back(not fresh and parent.exists(name) ? parent.openGroup(name) : parent.createGroup(name));
+    }
+
+    for(Entry &entry : this->entries_)
+    {
+        H5::Group &group = groups[entry.group];
+        if(not entry.direct)
+        {
+            entry.source->WriteElement(group, entry);
+            continue;
+        }
+
+        const void *values = entry.source->Values(entry);
+        const hid_t dset_id = fresh ?
+            H5Dcreate2(group.getId(), entry.name.c_str(), entry.fileType.getId(), entry.space.getId(), H5P_DEFAULT, entry.plist.getId(), H5P_DEFAULT) :
+            HDF5Writer_detail::CreateOrOpenDataSet(group.getId(), entry.name, entry.fileType.getId(), entry.space.getId(), entry.plist.getId());
+        if(dset_id < 0)
+        {
+            throw std::runtime_error("HDF5WritePlan: cannot create dataset " + entry.path);
+        }
+        H5::DataSet dataset(dset_id);
+        H5Dclose(dset_id);
+        if(not fresh)
+        {
+            HDF5Writer_detail::RemovePyramid(group, entry.name);
+        }
+        if(entry.total == 0)
+        {
+            continue;
+        }
+        if(entry.copyPlan.valid and not entry.staging.empty())
+        {
+            HDF5Writer_detail::WriteCompoundBlocks(dataset, values, entry.fileType, entry.copyPlan, entry.staging.data(), entry.staging.size(),
+                                                   entry.dims.data(), static_cast<int>(entry.dims.size()));
+        }
+        else if(entry.strided)
+        {
+            dataset.write(values, entry.memType, entry.memSpace, H5::DataSpace::ALL);
+        }
+        else
+        {
+            dataset.write(values, entry.memType);
+        }
+    }
+}
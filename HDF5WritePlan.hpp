@@ -0,0 +1,283 @@
+#ifndef HDF5WRITEPLAN_HPP
+#define HDF5WRITEPLAN_HPP
+
+#include <H5Cpp.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include "HDF5Writer.hpp"
+
+/**
+Writes the same elements, with the same shapes and types, once per step (e.g. one file or one group per time step).
+`Add()` records the schema once: paths, memory and file types, creation properties and dataspaces. Each `Write()` then
+creates the groups and datasets of a step from the prebuilt objects and writes the bound data in place.
+Numeric and compound rectangular elements are written directly; other elements (strings, jagged, columnar, sparse,
+with pyramid levels or zone maps) go through the same code as `HDF5Writer::WriteElement()`.
+*/
+class HDF5WritePlan
+{
+public:
+    HDF5WritePlan() = default;
+
+    HDF5WritePlan(const HDF5WritePlan&) = delete;
+    HDF5WritePlan &operator=(const HDF5WritePlan&) = delete;
+
+    /**
+    Adds the element at `path`, relative to the step, bound to `data`. The shape and type are recorded now;
+    every `Write()` writes the current values of `data`, which MUST stay accessible and keep its shape.
+    Views (`HDF5Utils::StridedView`, `std::span`) are copied; only the memory they refer to must stay accessible.
+    */
+    template<typename T>
+    void Add(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions());
+
+    /**
+    Adds the row-major array of `dims` elements at `data` at `path`, relative to the step.
+    */
+    template<typename T>
+    void Add(const std::string &path, const T *data, const std::vector<hsize_t> &dims,
+             const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions())
+    {
+        this->Add(path, HDF5Utils::StridedView<T>(data, dims), options);
+    }
+
+    /**
+    Writes one step to the new file `filename`, truncating it if it exists.
+    */
+    void Write(const std::string &filename);
+
+    /**
+    Writes one step into the group `groupPath` of the file of `writer`, created if needed.
+    Elements already in the group are overwritten.
+    */
+    void Write(HDF5Writer &writer, const std::string &groupPath);
+
+    size_t Size(void) const { return entries_.size(); }
+
+private:
+    struct Entry;
+
+    // Data bound to one element, typed by Add().
+    struct Source
+    {
+        virtual ~Source() = default;
+        // Contiguous values in the memory type of the element; throws if the shape changed since Add().
+        virtual const void *Values(Entry &entry) = 0;
+        virtual void WriteElement(H5::Group &group, const Entry &entry) const = 0;
+    };
+
+    template<typename T>
+    struct TypedSource;
+
+    struct Entry
+    {
+        std::string path;
+        std::string name;
+        size_t group = 0;                       // index in groups_
+        HDF5Utils::ElementOptions options;
+        std::unique_ptr<Source> source;
+
+        // prebuilt for elements written directly
+        bool direct = false;
+        std::vector<hsize_t> dims;
+        size_t total = 0;
+        H5::DataType memType;
+        H5::DataType fileType;
+        H5::DSetCreatPropList plist;
+        H5::DataSpace space;
+        H5::DataSpace memSpace;                 // strided views only
+        bool strided = false;
+        HDF5Utils::CompoundCopyPlan copyPlan;   // packed compounds
+        std::vector<char> staging;
+    };
+
+    struct Group
+    {
+        std::string name;
+        size_t parent = 0;
+    };
+
+    // Index in groups_ of `groupPath`, registering it and its parents.
+    size_t GroupIndex(const std::string &groupPath);
+
+    void AddEntry(Entry entry);
+
+    // Writes all elements below `root`. In a `fresh` (empty) root nothing has to be looked up before it is created.
+    void WriteStep(H5::Group &root, bool fresh);
+
+    std::vector<Group> groups_{Group()};       // groups_[0] is the step root
+    std::list<Entry> entries_;
+};
+
+template<typename T>
+struct HDF5WritePlan::TypedSource : HDF5WritePlan::Source
+{
+    using Bound = std::conditional_t<HDF5Utils::IsView<T>::value, T, const T*>;
+    using Scalar = typename HDF5Utils::InnerType<T>::type;
+    static constexpr bool compound = HDF5Utils::HasCompType<Scalar>::value;
+    static constexpr bool numeric = std::is_arithmetic_v<Scalar> and not std::is_same_v<Scalar, bool>;
+
+    explicit TypedSource(const T &data)
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+            this->data = data;
+        else
+            this->data = &data;
+    }
+
+    const T &Data(void) const
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+            return this->data;
+        else
+            return *this->data;
+    }
+
+    // Records the shape and builds the types, properties and dataspaces of `entry`, if it can be written directly.
+    void Describe(Entry &entry)
+    {
+        if constexpr(compound or numeric)
+        {
+            const HDF5Utils::ElementOptions &options = entry.options;
+            if((options.pyramidLevels > 0 or options.zoneMapRows > 0) and not options.appendable)
+            {
+                return;
+            }
+            if constexpr(compound)
+            {
+                if(options.compoundLayout == HDF5Utils::CompoundLayout::Columnar and not options.appendable)
+                {
+                    return;
+                }
+            }
+            if constexpr(HDF5Utils::IsView<T>::value)
+            {
+                const HDF5Utils::StridedView<Scalar> view = HDF5Utils::ToView(this->data);
+                if(view.dims.empty() or (not view.strides.empty() and view.strides.size() != view.dims.size()))
+                {
+                    throw std::runtime_error("HDF5WritePlan: view strides do not match its dimensions: " + entry.path);
+                }
+                entry.dims = view.dims;
+                if(view.Size() > 0 and not view.IsContiguous())
+                {
+                    if(not HDF5Writer_detail::StridedMemorySpace(view.dims, view.ElementStrides(), entry.memSpace))
+                    {
+                        return;
+                    }
+                    entry.strided = true;
+                }
+            }
+            else if constexpr(HDF5Utils::IsContainer<T>::value)
+            {
+                if(not HDF5Writer_detail::isRectangular(*this->data, entry.dims))
+                {
+                    return;
+                }
+            }
+            const int ndims = static_cast<int>(entry.dims.size());
+            entry.total = 1;
+            for(hsize_t d : entry.dims)
+            {
+                entry.total *= d;
+            }
+
+            if constexpr(compound)
+                entry.memType = H5::DataType(HDF5Utils::CompTypeCreator<Scalar>::get());
+            else
+                entry.memType = H5::DataType(HDF5Utils::HDF5Type<Scalar>::value());
+            if(ndims == 0)
+            {
+                // scalar compounds are stored in the memory layout, as by WriteScalarData()
+                entry.fileType = compound ? entry.memType : HDF5Writer_detail::CreateFileType<Scalar>(entry.memType, options);
+                entry.space = H5::DataSpace();
+            }
+            else
+            {
+                entry.fileType = HDF5Writer_detail::CreateFileType<Scalar>(entry.memType, options);
+                // copied in place: DSetCreatPropList has no usable assignment
+                entry.plist.copy(HDF5Writer_detail::CreateDataSetProps<Scalar>(entry.fileType, entry.dims.data(), ndims, options));
+                entry.space = HDF5Writer_detail::CreateDataSpace(entry.dims.data(), ndims, entry.plist, options);
+            }
+            if constexpr(compound)
+            {
+                if(ndims > 0 and not entry.strided and options.compoundLayout == HDF5Utils::CompoundLayout::Packed)
+                {
+                    entry.copyPlan = HDF5Utils::BuildCompoundCopyPlan(entry.memType.getId(), entry.fileType.getId());
+                    if(entry.copyPlan.valid)
+                    {
+                        entry.staging.resize(HDF5Writer_detail::CompoundStagingBytes(entry.dims.data(), ndims, entry.copyPlan.dstSize));
+                    }
+                }
+            }
+            if constexpr(HDF5Utils::IsContainer<T>::value and HDF5Utils::Rank<T>::value > 2)
+            {
+                this->flat.resize(entry.total);
+            }
+            entry.direct = true;
+        }
+    }
+
+    const void *Values(Entry &entry) override
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            return HDF5Utils::ToView(this->data).data;
+        }
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            if constexpr(HDF5Utils::Rank<T>::value == 2)
+            {
+                if(this->data->size() != entry.total)
+                {
+                    throw std::runtime_error("HDF5WritePlan: element changed its shape: " + entry.path);
+                }
+                return this->data->data();
+            }
+            else
+            {
+                Scalar *out = this->flat.data();
+                if(not HDF5Writer_detail::flattenRectangularInto(*this->data, entry.dims.data(), out))
+                {
+                    throw std::runtime_error("HDF5WritePlan: element changed its shape: " + entry.path);
+                }
+                return this->flat.data();
+            }
+        }
+        else
+        {
+            return this->data;
+        }
+    }
+
+    void WriteElement(H5::Group &group, const Entry &entry) const override
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+            HDF5Writer_detail::WriteViewData(group, entry.name, HDF5Utils::ToView(this->data), entry.options);
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+            HDF5Writer_detail::WriteSparseData(group, entry.name, *this->data, entry.options);
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+            HDF5Writer_detail::WriteContainerData(group, entry.name, *this->data, entry.options);
+        else
+            HDF5Writer_detail::WriteScalarData(group, entry.name, *this->data, entry.options);
+    }
+
+    Bound data;
+    std::vector<Scalar> flat;       // nested containers are flattened here on every write
+};
+
+template<typename T>
+void HDF5WritePlan::Add(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options)
+{
+    Entry entry;
+    entry.path = path;
+    std::string groupPath;
+    std::tie(groupPath, entry.name) = HDF5Utils::splitPathAndName(path);
+    entry.group = this->GroupIndex(groupPath);
+    entry.options = options;
+    auto source = std::make_unique<TypedSource<T>>(data);
+    source->Describe(entry);
+    entry.source = std::move(source);
+    this->AddEntry(std::move(entry));
+}
+
+#endif // HDF5WRITEPLAN_HPP
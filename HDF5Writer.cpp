@@ -1,20 +1,412 @@
 #include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
 
 HDF5Writer::HDF5Writer(const std::string &filename, bool truncate)
 {
+    this->options_.truncate = truncate;
     this->file_ = H5::H5File(filename, truncate ? H5F_ACC_TRUNC : H5F_ACC_RDWR);
+    if(not truncate)
+    {
+        HDF5Utils::InvalidateCatalog(this->file_);
+    }
+}
+
+HDF5Writer::HDF5Writer(const std::string &filename, const HDF5Utils::WriterOptions &options)
+    : options_(options)
+{
+    const HDF5Utils::FileLayout layout = HDF5Utils::ResolveFileLayout(filename, options.layout, options.truncate);
+    if(options.swmr and (layout.driver == HDF5Utils::FileDriver::Split or layout.driver == HDF5Utils::FileDriver::Family))
+    {
+        throw std::runtime_error("HDF5Writer: SWMR needs the default or direct file driver");
+    }
+    H5::FileAccPropList fapl = HDF5Utils::FileAccess(layout, options.truncate);
+    if(options.swmr)
+    {
+        // SWMR needs the latest file format
+        fapl.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+    }
+    this->file_ = H5::H5File(filename, options.truncate ? H5F_ACC_TRUNC : H5F_ACC_RDWR, H5::FileCreatPropList::DEFAULT, fapl);
+    if(options.truncate)
+    {
+        HDF5Utils::WriteFileLayout(this->file_, layout);
+    }
+    else
+    {
+        HDF5Utils::InvalidateCatalog(this->file_);
+    }
+    if(options.deduplicate and not options.swmr)
+    {
+        this->LoadDedupSources();
+    }
+}
+
+std::string HDF5Writer::DedupSourcePath(const std::string &source) const
+{
+    const std::string filename = this->file_.getFileName();
+    const std::string directory = filename.find('/') == std::string::npos ? "" : filename.substr(0, filename.find_last_of('/') + 1);
+    return source.front() == '/' ? source : directory + source;
+}
+
+bool HDF5Writer::HoldsPayload(const DedupTarget &target, const Element &element) const
+{
+    hid_t file_id = this->file_.getId();
+    hid_t object_id = H5I_INVALID_HID;
+    H5E_BEGIN_TRY
+    {
+        if(not target.file.empty())
+        {
+            file_id = H5Fopen(this->DedupSourcePath(target.file).c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        }
+        object_id = file_id < 0 ? H5I_INVALID_HID : H5Oopen(file_id, target.path.c_str(), H5P_DEFAULT);
+    }
+    H5E_END_TRY
+    bool holds = false;
+    if(object_id >= 0)
+    {
+        try
+        {
+            holds = element.stored(object_id);
+        }
+        catch(const H5::Exception &)
+        {
+            // an object that cannot be read as the element does not hold it
+        }
+        H5Oclose(object_id);
+    }
+    if(not target.file.empty() and file_id >= 0)
+    {
+        H5Fclose(file_id);
+    }
+    return holds;
+}
+
+void HDF5Writer::LoadDedupSources(void)
+{
+    const std::string group = HDF5Utils::DedupIndexGroup;
+    for(const std::string &source : this->options_.dedupSources)
+    {
+        const HDF5Reader reader(this->DedupSourcePath(source));
+        if(not reader.Exists(group))
+        {
+            continue;
+        }
+        std::vector<unsigned long long> keys;
+        std::vector<unsigned long long> bytes;
+        std::vector<std::string> paths;
+        reader.ReadElement(group + "/keys", keys);
+        reader.ReadElement(group + "/bytes", bytes);
+        reader.ReadElement(group + "/paths", paths);
+        if(keys.size() != paths.size() or keys.size() != bytes.size())
+        {
+            throw std::runtime_error("HDF5Writer: corrupt deduplication index in " + source);
+        }
+        for(size_t i = 0; i < keys.size(); ++i)
+        {
+            // the first source listing an element wins
+            this->dedupIndex_.emplace(keys[i], DedupTarget{source, paths[i], bytes[i]});
+        }
+    }
+}
+
+void HDF5Writer::WriteDedupIndex(void)
+{
+    std::vector<unsigned long long> keys;
+    std::vector<unsigned long long> bytes;
+    std::vector<std::string> paths;
+    for(const auto &[key, target] : this->dedupIndex_)
+    {
+        const auto it = this->dedupKeys_.find(target.path);
+        if(target.file.empty() and it != this->dedupKeys_.end() and it->second == key)
+        {
+            keys.push_back(key);
+            bytes.push_back(target.bytes);
+            paths.push_back(target.path);
+        }
+    }
+    H5::Group group = HDF5Utils::openGroupPath(this->file_, HDF5Utils::DedupIndexGroup, true);
+    HDF5Writer_detail::WriteContainerData(group, "keys", keys, HDF5Utils::ElementOptions());
+    HDF5Writer_detail::WriteContainerData(group, "bytes", bytes, HDF5Utils::ElementOptions());
+    HDF5Writer_detail::WriteContainerData(group, "paths", paths, HDF5Utils::ElementOptions());
+}
+
+void HDF5Writer::WriteStored(const Element &element, H5::Group &group, const uint64_t *hash)
+{
+    if(not this->options_.deduplicate or this->options_.swmr or not element.bytes)
+    {
+        element.write(group);
+        return;
+    }
+
+    const size_t bytes = element.bytes();
+    const bool linkable = bytes >= this->options_.dedupMinBytes;
+    const uint64_t key = linkable ? HDF5Utils::HashBytes(&element.signature, sizeof(element.signature), hash ? *hash : element.hash()) : 0;
+    const DedupTarget *target = nullptr;
+    if(linkable)
+    {
+        const auto it = this->dedupIndex_.find(key);
+        if(it != this->dedupIndex_.end())
+        {
+            const auto held = this->dedupKeys_.find(it->second.path);
+            if(not it->second.file.empty())
+            {
+                target = &it->second;
+            }
+            else if(held != this->dedupKeys_.end() and held->second == key)
+            {
+                target = &it->second;
+            }
+        }
+    }
+    // equal keys may still be a collision, so the target's payload is compared before linking to it
+    if(target and not this->HoldsPayload(*target, element))
+    {
+        target = nullptr;
+    }
+    else if(target and target->path == element.fullpath and target->file.empty())
+    {
+        // already holds these contents
+        return;
+    }
+
+    // a link left by an earlier dump is replaced rather than written through: it may lead to another file,
+    // or to an object other elements share
+    const char *name = element.name.c_str();
+    HDF5Writer_detail::CheckReplaceable(group.getId(), element.name);
+    if(H5Lexists(group.getId(), name, H5P_DEFAULT) > 0)
+    {
+        H5L_info_t link;
+#if H5_VERSION_GE(1, 12, 0)
+        H5O_info2_t object;
+        const bool shared = H5Lget_info(group.getId(), name, &link, H5P_DEFAULT) < 0 or link.type != H5L_TYPE_HARD or
+                            H5Oget_info_by_name3(group.getId(), name, &object, H5O_INFO_BASIC, H5P_DEFAULT) < 0 or object.rc > 1;
+#else
+        H5O_info_t object;
+        const bool shared = H5Lget_info(group.getId(), name, &link, H5P_DEFAULT) < 0 or link.type != H5L_TYPE_HARD or
+                            H5Oget_info_by_name(group.getId(), name, &object, H5P_DEFAULT) < 0 or object.rc > 1;
+#endif
+        if(target or shared)
+        {
+            H5Ldelete(group.getId(), name, H5P_DEFAULT);
+        }
+    }
+
+    if(target)
+    {
+        HDF5Writer_detail::RemovePyramid(group, element.name);
+        if(target->file.empty())
+        {
+            H5Lcreate_hard(this->file_.getId(), target->path.c_str(), group.getId(), name, H5P_DEFAULT, H5P_DEFAULT);
+            ++this->dedupStats_.hardLinks;
+        }
+        else
+        {
+            H5Lcreate_external(target->file.c_str(), target->path.c_str(), group.getId(), name, H5P_DEFAULT, H5P_DEFAULT);
+            ++this->dedupStats_.externalLinks;
+        }
+        this->dedupStats_.bytesSaved += bytes;
+        this->dedupKeys_[element.fullpath] = key;
+        return;
+    }
+
+    element.write(group);
+    if(not linkable)
+    {
+        this->dedupKeys_.erase(element.fullpath);
+        return;
+    }
+    this->dedupKeys_[element.fullpath] = key;
+    this->dedupIndex_[key] = DedupTarget{std::string(), element.fullpath, bytes};
+}
+
+bool HDF5Writer::NeedsWrite(const Element &element, DumpState &state)
+{
+    auto it = this->dumped_.find(element.fullpath);
+    const bool same_storage = it != this->dumped_.end() and not it->second.dirty and it->second.storage == element.storage;
+    if(element.changeTracking == HDF5Utils::ChangeTracking::DirtyFlag)
+    {
+        state = DumpState{0, element.storage, false};
+        return not same_storage;
+    }
+
+    state = DumpState{element.hash(), element.storage, false};
+    return not (same_storage and it->second.hash == state.hash);
+}
+
+void HDF5Writer::CatalogChanged(void)
+{
+    if(this->catalogCurrent_)
+    {
+        HDF5Utils::InvalidateCatalog(this->file_);
+        this->catalogCurrent_ = false;
+    }
 }
 
 void HDF5Writer::Dump(void)
 {
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    this->CatalogChanged();
     for(const Element &element : data)
     {
+        DumpState state;
+        if(this->options_.incremental and not this->NeedsWrite(element, state))
+        {
+            continue;
+        }
         H5::Group group = HDF5Utils::openGroupPath(this->file_, element.groupPath, true);
-        element.write(group);
+        const bool hashed = this->options_.incremental and element.changeTracking == HDF5Utils::ChangeTracking::Hash;
+        this->WriteStored(element, group, hashed ? &state.hash : nullptr);
         group.close();
+        // recorded only once written, so an element whose write threw is written again by the next Dump()
+        if(this->options_.incremental)
+        {
+            this->dumped_[element.fullpath] = state;
+        }
+    }
+    if(this->options_.deduplicate and not this->options_.swmr)
+    {
+        this->WriteDedupIndex();
+    }
+    if(this->options_.catalog and not this->options_.swmr)
+    {
+        HDF5Utils::WriteCatalog(this->file_, HDF5Utils::BuildCatalog(this->file_));
+        this->catalogCurrent_ = true;
+    }
+
+    if(this->options_.swmr)
+    {
+        this->StartSWMR();
+        this->Flush();
+    }
+    else if(this->options_.incremental)
+    {
+        this->file_.flush(H5F_SCOPE_GLOBAL);
+    }
+    else
+    {
+        this->file_.close();
+    }
+}
+
+H5::DataSet HDF5Writer::WriteProducedBlocks(const std::string &path, const std::vector<hsize_t> &dims, const H5::DataType &memType,
+                                            const H5::DataType &fileType, const H5::DSetCreatPropList &plist,
+                                            const HDF5Utils::ElementOptions &options, hsize_t blockRows, void *const buffers[2],
+                                            const std::function<void(hsize_t, hsize_t, void*)> &produce,
+                                            const std::function<void(hsize_t, hsize_t, const void*)> &written, bool pipelined)
+{
+    auto [groupPath, name] = HDF5Utils::splitPathAndName(path);
+    this->CatalogChanged();
+    H5::Group group = HDF5Utils::openGroupPath(this->file_, groupPath, true);
+    const int ndims = static_cast<int>(dims.size());
+    const H5::DataSpace dataspace = HDF5Writer_detail::CreateDataSpace(dims.data(), ndims, plist, options);
+    H5::DataSet dataset = HDF5Writer_detail::CreateOrOpenDataSet(group, name, fileType, dataspace, plist);
+    HDF5Writer_detail::RemovePyramid(group, name);
+
+    size_t row = 1;
+    for(int i = 1; i < ndims; ++i)
+    {
+        row *= dims[i];
+    }
+    const hsize_t blocks = row == 0 ? 0 : (dims[0] + blockRows - 1) / blockRows;
+    std::vector<hsize_t> start(ndims, 0);
+    std::vector<hsize_t> count(dims);
+    const auto write = [&](hsize_t block, const void *values)
+    {
+        start[0] = block * blockRows;
+        count[0] = std::min(blockRows, dims[0] - start[0]);
+        H5::DataSpace fileSpace = dataset.getSpace();
+        fileSpace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+        const H5::DataSpace memSpace(ndims, count.data());
+        dataset.write(values, memType, memSpace, fileSpace);
+        if(written)
+        {
+            written(start[0], count[0], values);
+        }
+    };
+    const auto rows = [&](hsize_t block)
+    {
+        return std::min(blockRows, dims[0] - block * blockRows);
+    };
+
+    if(not pipelined)
+    {
+        for(hsize_t block = 0; block < blocks; ++block)
+        {
+            produce(block * blockRows, rows(block), buffers[0]);
+            write(block, buffers[0]);
+        }
+        return dataset;
+    }
+
+    // block + 1 is produced on a worker thread while block is written
+    if(blocks > 0)
+    {
+        produce(0, rows(0), buffers[0]);
+    }
+    for(hsize_t block = 0; block < blocks; ++block)
+    {
+        std::exception_ptr error;
+        std::thread worker;
+        if(block + 1 < blocks)
+        {
+            worker = std::thread([&, next = block + 1]()
+            {
+                try
+                {
+                    produce(next * blockRows, rows(next), buffers[next % 2]);
+                }
+                catch(...)
+                {
+                    error = std::current_exception();
+                }
+            });
+        }
+        try
+        {
+            write(block, buffers[block % 2]);
+        }
+        catch(...)
+        {
+            if(worker.joinable())
+            {
+                worker.join();
+            }
+            throw;
+        }
+        if(worker.joinable())
+        {
+            worker.join();
+        }
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
     }
+    return dataset;
+}
 
-    this->file_.close();
+void HDF5Writer::StartSWMR(void)
+{
+    if(this->swmrStarted_)
+    {
+        return;
+    }
+    if(H5Fstart_swmr_write(this->file_.getId()) < 0)
+    {
+        throw std::runtime_error("HDF5Writer: cannot switch to SWMR mode (was the writer created with WriterOptions::swmr?)");
+    }
+    this->swmrStarted_ = true;
+    this->lastFlush_ = std::chrono::steady_clock::now();
+}
+
+void HDF5Writer::Flush(void)
+{
+    this->file_.flush(H5F_SCOPE_LOCAL);
+    this->lastFlush_ = std::chrono::steady_clock::now();
+}
+
+void HDF5Writer::MarkDirty(const std::string &path)
+{
+    this->dumped_[path].dirty = true;
 }
 
 void HDF5Writer::AddExternalLink(const std::string &externalFile, const std::string &targetPath, const std::string &linkPath)
@@ -22,24 +414,114 @@ void HDF5Writer::AddExternalLink(const std::string &externalFile, const std::str
     // Create parent groups for the link location
     auto [groupPath, linkName] = HDF5Utils::splitPathAndName(linkPath);
 
+    this->CatalogChanged();
     H5::Group group = HDF5Utils::openGroupPath(this->file_, groupPath, true);
     H5Lcreate_external(externalFile.c_str(),  // the other .h5 file
                         targetPath.c_str(),    // path inside that file (e.g. "/dataset")
                         group.getId(),         // where the link lives in THIS file
                         linkName.c_str(),      // name of the link
                         H5P_DEFAULT, H5P_DEFAULT);
+    HDF5Writer_detail::RemovePyramid(group, linkName);
+}
+
+void HDF5Writer::AddVirtualDataset(const std::vector<std::string> &sourceFiles, const std::string &targetPath, const std::string &linkPath)
+{
+    if(sourceFiles.empty())
+    {
+        throw std::runtime_error("HDF5Writer: a virtual dataset needs at least one source file");
+    }
+
+    const std::string filename = this->file_.getFileName();
+    const std::string directory = filename.find('/') == std::string::npos ? "" : filename.substr(0, filename.find_last_of('/') + 1);
+
+    // empty sources only need to agree in rank
+    H5::DataType type;
+    std::vector<hsize_t> dims;
+    bool shaped = false;
+    std::vector<hsize_t> rows(sourceFiles.size());
+    for(size_t i = 0; i < sourceFiles.size(); ++i)
+    {
+        const std::string &source = sourceFiles[i];
+        H5::H5File sourceFile(source.front() == '/' ? source : directory + source, H5F_ACC_RDONLY);
+        H5::DataSet dataset = sourceFile.openDataSet(targetPath);
+        const H5::DataSpace space = dataset.getSpace();
+        std::vector<hsize_t> sourceDims(space.getSimpleExtentNdims());
+        space.getSimpleExtentDims(sourceDims.data());
+        if(sourceDims.empty())
+        {
+            throw std::runtime_error("HDF5Writer: cannot build a virtual dataset from scalar dataset " + targetPath);
+        }
+        if(i > 0 and sourceDims.size() != dims.size())
+        {
+            throw std::runtime_error("HDF5Writer: virtual dataset sources differ in rank: " + source);
+        }
+        rows[i] = sourceDims[0];
+        if(i == 0 or (not shaped and rows[i] > 0))
+        {
+            const hsize_t total = i == 0 ? 0 : dims[0];
+            type = dataset.getDataType();
+            dims = sourceDims;
+            dims[0] += total;
+            shaped = rows[i] > 0;
+        }
+        else if(rows[i] > 0)
+        {
+            if(not (dataset.getDataType() == type) or not std::equal(sourceDims.begin() + 1, sourceDims.end(), dims.begin() + 1))
+            {
+                throw std::runtime_error("HDF5Writer: virtual dataset sources differ in type or shape: " + source);
+            }
+            dims[0] += sourceDims[0];
+        }
+    }
+
+    const int ndims = static_cast<int>(dims.size());
+    H5::DataSpace virtualSpace(ndims, dims.data());
+    H5::DSetCreatPropList plist;
+    std::vector<hsize_t> start(ndims, 0);
+    std::vector<hsize_t> count(dims);
+    for(size_t i = 0; i < sourceFiles.size(); ++i)
+    {
+        if(rows[i] == 0)
+        {
+            continue;
+        }
+        count[0] = rows[i];
+        virtualSpace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+        H5::DataSpace sourceSpace(ndims, count.data());
+        H5Pset_virtual(plist.getId(), virtualSpace.getId(), sourceFiles[i].c_str(), targetPath.c_str(), sourceSpace.getId());
+        start[0] += rows[i];
+    }
+    virtualSpace.selectAll();
+
+    auto [groupPath, name] = HDF5Utils::splitPathAndName(linkPath);
+    this->CatalogChanged();
+    H5::Group group = HDF5Utils::openGroupPath(this->file_, groupPath, true);
+    HDF5Writer_detail::CreateOrOpenDataSet(group, name, type, virtualSpace, plist);
+    HDF5Writer_detail::RemovePyramid(group, name);
 }
 
 HDF5Writer::~HDF5Writer()
 {
-    this->Close();
+    try
+    {
+        this->Close();
+    }
+    catch(...)
+    {
+        // a catalog that could not be rewritten stays marked incomplete
+    }
 }
 
 void HDF5Writer::Close(void)
 {
     if(not closed)
     {
-        this->file_.close();
         closed = true;
+        const bool open = H5Iis_valid(this->file_.getId()) > 0;
+        if(open and this->options_.catalog and not this->options_.swmr and not this->catalogCurrent_)
+        {
+            HDF5Utils::WriteCatalog(this->file_, HDF5Utils::BuildCatalog(this->file_));
+        }
+        this->file_.close();
     }
 }
\ No newline at end of file
@@ -5,25 +5,42 @@
 #include <string>
 #include <functional>
 #include <set>
+#include <map>
+#include <unordered_map>
 #include <any>
+#include <chrono>
+#include <thread>
+#include <exception>
 #include "HDF5Writer_detail.hpp"
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#define HDF5UTILS_HAS_RANGES 1
+#endif
 
 class HDF5Writer
 {
 public:
     HDF5Writer(const std::string &filename, bool truncate = true);
 
+    HDF5Writer(const std::string &filename, const HDF5Utils::WriterOptions &options);
+
     ~HDF5Writer();
 
     /**
-    Closes the writer and the file.
+    Closes the writer and the file, rewriting the catalog (`WriterOptions::catalog`) if the file changed since the last `Dump()`.
     */
     void Close(void);
 
     /**
     Dumps the stored data to an HDF5 file.
+    In incremental mode the file stays open, and only elements that changed since the previous `Dump()` are written.
     */
     void Dump(void);
+
+    /**
+    Marks the element at `path` as changed, so the next incremental `Dump()` rewrites it.
+    */
+    void MarkDirty(const std::string &path);
     
     /**
     Writes an element at path `path`.
@@ -31,26 +48,126 @@ public:
     template<typename T>
     void WriteElement(const std::string &path, const T &data){this->AddElement(path, data, true);};
 
+    /**
+    Writes an element at path `path`, stored according to `options`.
+    */
+    template<typename T>
+    void WriteElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options){this->AddElement(path, data, options, true);};
+
     /**
     Adds an element to the writer. `data` MUST be accessible in `Dump()`.
+    Views (`HDF5Utils::StridedView`, `std::span`) are copied; only the memory they refer to must stay accessible.
+    */
+    template<typename T>
+    void AddElement(const std::string &path, const T &data, bool write = false){this->AddElement(path, data, HDF5Utils::ElementOptions(), write);};
+
+    /**
+    Adds an element to the writer, stored according to `options` (precision, filters). `data` MUST be accessible in `Dump()`.
+    */
+    template<typename T>
+    void AddElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options, bool write = false);
+
+    /**
+    Writes the row-major array of `dims` elements at `data` at path `path`, without copying it.
+    */
+    template<typename T>
+    void WriteElement(const std::string &path, const T *data, const std::vector<hsize_t> &dims,
+                      const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions())
+    {
+        this->AddElement(path, HDF5Utils::StridedView<T>(data, dims), options, true);
+    }
+
+    /**
+    Adds the row-major array of `dims` elements at `data` to the writer. The memory at `data` MUST be accessible in `Dump()`.
     */
     template<typename T>
-    void AddElement(const std::string &path, const T &data, bool write = false);
+    void AddElement(const std::string &path, const T *data, const std::vector<hsize_t> &dims,
+                    const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions())
+    {
+        this->AddElement(path, HDF5Utils::StridedView<T>(data, dims), options);
+    }
+
+    /**
+    Appends the rows of `data` to the appendable element at `path` (see `HDF5Utils::ElementOptions::appendable`).
+    */
+    template<typename T>
+    void AppendElement(const std::string &path, const T &data);
+
+    /**
+    Writes the row-major element of `dims` at `path` block by block, so it never has to be held in memory whole:
+    `producer(firstRow, rows, values)` fills `values` with the `rows` rows from `firstRow`, and is called for consecutive
+    blocks in order. `T` is a numeric or compound type. `options` apply as in `WriteElement()`, except that compounds
+    are stored as rows and no pyramid levels are stored; a zone map is computed block by block.
+    */
+    template<typename T, typename Producer>
+    void WriteBlocks(const std::string &path, const std::vector<hsize_t> &dims, Producer &&producer,
+                     const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions(),
+                     const HDF5Utils::BlockWriteOptions &blockOptions = HDF5Utils::BlockWriteOptions());
+
+#if HDF5UTILS_HAS_RANGES
+    /**
+    Writes the values of `range`, in row-major order, as the element of `dims` at `path`, block by block like `WriteBlocks()`.
+    Only as many values as `dims` holds are taken, so the range may be unbounded; a shorter range throws.
+    */
+    template<std::ranges::input_range Range>
+    void WriteRange(const std::string &path, const std::vector<hsize_t> &dims, Range &&range,
+                    const HDF5Utils::ElementOptions &options = HDF5Utils::ElementOptions(),
+                    const HDF5Utils::BlockWriteOptions &blockOptions = HDF5Utils::BlockWriteOptions());
+#endif
+
+    /**
+    Switches the file to SWMR writing. Called by `Dump()` in SWMR mode; all datasets must exist by then.
+    */
+    void StartSWMR(void);
+
+    /**
+    Flushes all written data to the file.
+    */
+    void Flush(void);
 
     /**
     Adds a HDF5 external link to `targetPath` in file `externalFile`, saved in `linkPath` in the current file.
     */
     void AddExternalLink(const std::string &externalFile, const std::string &targetPath, const std::string &linkPath);
 
+    /**
+    Adds a HDF5 virtual dataset at `linkPath` that concatenates, along the first dimension, the dataset `targetPath` of each file in `sourceFiles`.
+    Relative source file names are resolved against the directory of the current file, and the sources must already exist.
+    */
+    void AddVirtualDataset(const std::vector<std::string> &sourceFiles, const std::string &targetPath, const std::string &linkPath);
+
+    /**
+    Sets the memory resource of the temporary buffers of the writes (flattened values, variable-length descriptors,
+    conversion blocks, dictionaries). `nullptr` (the default) keeps the resource current at the time of the write, or
+    `std::pmr::get_default_resource()` outside any `HDF5Utils::ScopedMemoryResource`.
+    The resource must outlive the writes.
+    */
+    void SetMemoryResource(std::pmr::memory_resource *resource) { this->memoryResource_ = resource; }
+
+    /**
+    Elements linked instead of written, and the bytes saved, since the writer was created (`WriterOptions::deduplicate`).
+    */
+    const HDF5Utils::DedupStats &DedupStatistics(void) const { return this->dedupStats_; }
+
 private:
+    friend class HDF5WritePlan;
+
     struct Element
     {
         std::string fullpath;
         std::string groupPath;
         std::string name;
         std::function<void(H5::Group&)> write;
+        std::function<uint64_t(void)> hash;
+        HDF5Utils::ChangeTracking changeTracking = HDF5Utils::ChangeTracking::Hash;
+        uint64_t storage = 0;       // hash of the storage options; an incremental dump rewrites the element when they change
         std::any data;
 
+        // deduplication only: hash of the type and storage options, and payload size; `bytes` is empty if the element is never linked
+        uint64_t signature = 0;
+        std::function<size_t(void)> bytes;
+        std::function<bool(hid_t)> stored;      // true if the object holds the same payload
+
         bool operator<(const Element& other) const
         {
             return fullpath < other.fullpath;
@@ -67,13 +184,65 @@ private:
         }
     };
 
+    struct DumpState
+    {
+        uint64_t hash = 0;
+        uint64_t storage = 0;
+        bool dirty = false;
+    };
+
+    // Element a deduplicated element can be linked to: in this file if `file` is empty, else in a previous dump.
+    struct DedupTarget
+    {
+        std::string file;
+        std::string path;
+        uint64_t bytes = 0;
+    };
+
+    // True if `element` changed since its last dump; `state` receives what to record once it is written.
+    bool NeedsWrite(const Element &element, DumpState &state);
+
+    // Writes `element` into `group`, or links it to an identical element when deduplicating. `hash` is its content hash, if known.
+    void WriteStored(const Element &element, H5::Group &group, const uint64_t *hash);
+
+    void LoadDedupSources(void);
+
+    // Path of the `dedupSources` file `source`, resolved against the directory of this file.
+    std::string DedupSourcePath(const std::string &source) const;
+
+    // True if the element `target` refers to holds the payload of `element`.
+    bool HoldsPayload(const DedupTarget &target, const Element &element) const;
+
+    // Creates the dataset at `path` and writes it in blocks of `blockRows` rows, each produced into `buffers[0]`, or alternately
+    // into both buffers when `pipelined`, by `produce(firstRow, rows, buffer)`. `written(firstRow, rows, buffer)`, if set, is
+    // called on this thread once a block is written, while the HDF5 library is not busy with the next one.
+    H5::DataSet WriteProducedBlocks(const std::string &path, const std::vector<hsize_t> &dims, const H5::DataType &memType,
+                                    const H5::DataType &fileType, const H5::DSetCreatPropList &plist,
+                                    const HDF5Utils::ElementOptions &options, hsize_t blockRows, void *const buffers[2],
+                                    const std::function<void(hsize_t, hsize_t, void*)> &produce,
+                                    const std::function<void(hsize_t, hsize_t, const void*)> &written, bool pipelined);
+
+    void WriteDedupIndex(void);
+
+    // Marks a stored catalog incomplete before the file changes outside Dump(), so readers walk the file instead.
+    void CatalogChanged(void);
+
     bool closed = false;
+    bool catalogCurrent_ = false;
+    bool swmrStarted_ = false;
+    std::chrono::steady_clock::time_point lastFlush_;
     H5::H5File file_;
+    HDF5Utils::WriterOptions options_;
     std::set<Element> data;
+    std::map<std::string, DumpState> dumped_;
+    std::pmr::memory_resource *memoryResource_ = nullptr;
+    std::unordered_map<uint64_t, DedupTarget> dedupIndex_;     // content key -> element holding it
+    std::map<std::string, uint64_t> dedupKeys_;                 // path -> content key it holds in this file
+    HDF5Utils::DedupStats dedupStats_;
 };
 
 template<typename T>
-void HDF5Writer::AddElement(const std::string &path, const T &data, bool write)
+void HDF5Writer::AddElement(const std::string &path, const T &data, const HDF5Utils::ElementOptions &options, bool write)
 {
     Element element;
     
@@ -82,32 +251,249 @@ void HDF5Writer::AddElement(const std::string &path, const T &data, bool write)
 
     std::tie(element.groupPath, element.name) = HDF5Utils::splitPathAndName(path);
 
-    element.data = std::make_any<const T*>(&data);
+    element.changeTracking = options.changeTracking;
+    element.storage = HDF5Writer_detail::HashOptions(options, 0);
+    if constexpr(HDF5Utils::IsView<T>::value)
+    {
+        // views are small and often temporaries
+        element.data = std::make_any<T>(data);
+        element.hash = [view = data]()
+        {
+            return HDF5Writer_detail::HashData(view);
+        };
+    }
+    else
+    {
+        element.data = std::make_any<const T*>(&data);
+        element.hash = [ptr = &data]()
+        {
+            return HDF5Writer_detail::HashData(*ptr);
+        };
+    }
+
+    if(this->options_.deduplicate and not options.appendable and options.pyramidLevels == 0 and options.zoneMapRows == 0)
+    {
+        const std::string signature = HDF5Writer_detail::TypeSignature<T>();
+        element.signature = HDF5Writer_detail::HashOptions(options, HDF5Utils::HashBytes(signature.data(), signature.size()));
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            element.bytes = [view = data]()
+            {
+                return HDF5Writer_detail::PayloadBytes(view);
+            };
+            element.stored = [view = data](hid_t object)
+            {
+                return HDF5Writer_detail::StoredEquals(object, view);
+            };
+        }
+        else
+        {
+            element.bytes = [ptr = &data]()
+            {
+                return HDF5Writer_detail::PayloadBytes(*ptr);
+            };
+            element.stored = [ptr = &data](hid_t object)
+            {
+                return HDF5Writer_detail::StoredEquals(object, *ptr);
+            };
+        }
+    }
 
-    element.write = [element](H5::Group &group)
+    element.write = [element, options](H5::Group &group)
     {
-        const T &data = *std::any_cast<const T*>(element.data);
-        if constexpr(HDF5Utils::IsContainer<T>::value)
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            const T &view = std::any_cast<const T&>(element.data);
+            HDF5Writer_detail::WriteViewData(group, element.name, HDF5Utils::ToView(view), options);
+        }
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+        {
+            const T &data = *std::any_cast<const T*>(element.data);
+            HDF5Writer_detail::WriteSparseData(group, element.name, data, options);
+        }
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
         {
-            HDF5Writer_detail::WriteContainerData(group, element.name, data);
+            const T &data = *std::any_cast<const T*>(element.data);
+            HDF5Writer_detail::WriteContainerData(group, element.name, data, options);
         }
         else
         {
-            HDF5Writer_detail::WriteScalarData(group, element.name, data);
+            const T &data = *std::any_cast<const T*>(element.data);
+            HDF5Writer_detail::WriteScalarData(group, element.name, data, options);
         }
     };
 
     if(write)
     {
+        this->CatalogChanged();
+        const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
         H5::Group group = HDF5Utils::openGroupPath(this->file_, element.groupPath, true);
-        element.write(group);
+        this->WriteStored(element, group, nullptr);
         group.close();
     }
     else
     {
+        // a repeated AddElement() rebinds the path to the new data
+        this->data.erase(element);
         this->data.insert(element);
     }
 }
 
+template<typename T>
+void HDF5Writer::AppendElement(const std::string &path, const T &data)
+{
+    static_assert(HDF5Utils::IsContainer<T>::value, "HDF5Writer::AppendElement: data must be a container");
+    auto [groupPath, name] = HDF5Utils::splitPathAndName(path);
+
+    H5::Group group = HDF5Utils::openGroupPath(this->file_, groupPath);
+    if(not group.exists(name))
+    {
+        throw std::runtime_error("HDF5Writer: cannot append to missing dataset " + path);
+    }
+    H5::DataSet dataset = group.openDataSet(name);
+    this->CatalogChanged();
+    HDF5Writer_detail::RemovePyramid(group, name);
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    HDF5Writer_detail::AppendRectangularData(dataset, data);
+
+    if(this->swmrStarted_)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if(std::chrono::duration<double>(now - this->lastFlush_).count() >= this->options_.swmrFlushInterval)
+        {
+            this->Flush();
+        }
+    }
+}
+
+template<typename T, typename Producer>
+void HDF5Writer::WriteBlocks(const std::string &path, const std::vector<hsize_t> &dims, Producer &&producer,
+                             const HDF5Utils::ElementOptions &options, const HDF5Utils::BlockWriteOptions &blockOptions)
+{
+    constexpr bool numeric = std::is_arithmetic_v<T> and not std::is_same_v<T, bool>;
+    static_assert(numeric or HDF5Utils::HasCompType<T>::value, "HDF5Writer::WriteBlocks: values must be numeric or compound");
+    if(dims.empty())
+    {
+        throw std::runtime_error("HDF5Writer: WriteBlocks() needs at least one dimension: " + path);
+    }
+    if constexpr(numeric)
+    {
+        HDF5Writer_detail::CheckZoneMapOptions<T>(path, options);
+    }
+    const HDF5Utils::ScopedMemoryResource scope(this->memoryResource_);
+    const int ndims = static_cast<int>(dims.size());
+    size_t row = 1;
+    for(int i = 1; i < ndims; ++i)
+    {
+        row *= dims[i];
+    }
+
+    H5::DataType mem_type;
+    if constexpr(HDF5Utils::HasCompType<T>::value)
+        mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
+    else
+        mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
+    const H5::DataType file_type = HDF5Writer_detail::CreateFileType<T>(mem_type, options);
+    const H5::DSetCreatPropList plist = HDF5Writer_detail::CreateDataSetProps<T>(file_type, dims.data(), ndims, options);
+
+    // blocks hold whole zone map blocks, or whole chunks
+    const bool zone_map = numeric and options.zoneMapRows > 0 and not options.appendable;
+    hsize_t unit = 1;
+    if(zone_map)
+    {
+        unit = options.zoneMapRows;
+    }
+    else if(plist.getLayout() == H5D_CHUNKED)
+    {
+        std::vector<hsize_t> chunk(ndims);
+        plist.getChunk(ndims, chunk.data());
+        unit = chunk[0];
+    }
+    hsize_t block_rows = std::max<hsize_t>(1, blockOptions.blockBytes / std::max<size_t>(1, row * sizeof(T)));
+    block_rows = std::min(std::max(unit, block_rows / unit * unit), std::max<hsize_t>(1, dims[0]));
+    const bool pipelined = blockOptions.pipelined and dims[0] > block_rows;
+
+    std::vector<T> buffers[2];
+    buffers[0].resize(block_rows * row);
+    if(pipelined)
+    {
+        buffers[1].resize(block_rows * row);
+    }
+    std::vector<T> ranges;
+    if(zone_map)
+    {
+        ranges.resize(2 * ((dims[0] + options.zoneMapRows - 1) / options.zoneMapRows));
+    }
+    const bool converted = zone_map and not (file_type == mem_type);
+    const auto produce = [&](hsize_t first, hsize_t rows, void *values)
+    {
+        T *out = static_cast<T*>(values);
+        producer(first, rows, out);
+        if constexpr(numeric)
+        {
+            if(zone_map and not converted)
+            {
+                HDF5Writer_detail::ZoneRanges(out, rows, row, options.zoneMapRows, ranges.data() + 2 * (first / options.zoneMapRows));
+            }
+        }
+    };
+    // ranges of converted values go through H5Tconvert, so they are computed on the writing thread, between two writes
+    std::function<void(hsize_t, hsize_t, const void*)> written;
+    if constexpr(numeric)
+    {
+        if(converted)
+        {
+            written = [&](hsize_t first, hsize_t rows, const void *values)
+            {
+                HDF5Writer_detail::StoredZoneRanges(static_cast<const T*>(values), rows, row, options.zoneMapRows, file_type,
+                                                    ranges.data() + 2 * (first / options.zoneMapRows));
+            };
+        }
+    }
+    void *const pointers[2] = {buffers[0].data(), buffers[1].data()};
+    H5::DataSet dataset = this->WriteProducedBlocks(path, dims, mem_type, file_type, plist, options, block_rows, pointers, produce,
+                                                    written, pipelined);
+    if constexpr(numeric)
+    {
+        if(zone_map)
+        {
+            HDF5Writer_detail::StoreZoneMap(this->file_, path, dataset, ranges, options.zoneMapRows);
+        }
+    }
+}
+
+#if HDF5UTILS_HAS_RANGES
+template<std::ranges::input_range Range>
+void HDF5Writer::WriteRange(const std::string &path, const std::vector<hsize_t> &dims, Range &&range,
+                            const HDF5Utils::ElementOptions &options, const HDF5Utils::BlockWriteOptions &blockOptions)
+{
+    using T = std::ranges::range_value_t<Range>;
+    size_t row = 1;
+    for(size_t i = 1; i < dims.size(); ++i)
+    {
+        row *= dims[i];
+    }
+    auto it = std::ranges::begin(range);
+    const auto end = std::ranges::end(range);
+    bool started = false;
+    this->WriteBlocks<T>(path, dims, [&](hsize_t, hsize_t rows, T *values)
+    {
+        for(size_t i = 0; i < rows * row; ++i)
+        {
+            // advanced only before each value, so an input range is not read past the last value taken
+            if(started)
+            {
+                ++it;
+            }
+            started = true;
+            if(it == end)
+            {
+                throw std::runtime_error("HDF5Writer: range ends before filling " + path);
+            }
+            values[i] = *it;
+        }
+    }, options, blockOptions);
+}
+#endif
 
 #endif // HDF5WRITER_HPP
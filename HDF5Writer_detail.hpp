@@ -4,12 +4,385 @@
 #include <H5Cpp.h>
 #include <string>
 #include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
 #include "HDF5Helper.hpp"
+#include "HDF5Sparse.hpp"
 
 namespace HDF5Writer_detail
 {
+    // Whether dataset `dset_id` was created with the layout, chunking and filters in `plist_id`.
+    // Filters fill in their own parameters when the dataset is created, so only the ones the caller set are compared.
+    inline bool SameCreationProperties(hid_t dset_id, hid_t plist_id)
+    {
+        const hid_t wanted = plist_id == H5P_DEFAULT ? H5P_DATASET_CREATE_DEFAULT : plist_id;
+        const hid_t current = H5Dget_create_plist(dset_id);
+        if(current < 0)
+        {
+            return false;
+        }
+        const H5D_layout_t layout = H5Pget_layout(current);
+        bool same = layout == H5Pget_layout(wanted) and layout != H5D_VIRTUAL;
+        if(same and layout == H5D_CHUNKED)
+        {
+            hsize_t current_chunk[H5S_MAX_RANK];
+            hsize_t wanted_chunk[H5S_MAX_RANK];
+            const int rank = H5Pget_chunk(current, H5S_MAX_RANK, current_chunk);
+            same = rank == H5Pget_chunk(wanted, H5S_MAX_RANK, wanted_chunk) and std::equal(current_chunk, current_chunk + rank, wanted_chunk);
+        }
+        const int nfilters = same ? H5Pget_nfilters(current) : 0;
+        same = same and nfilters == H5Pget_nfilters(wanted);
+        for(int i = 0; same and i < nfilters; ++i)
+        {
+            unsigned current_flags = 0;
+            unsigned wanted_flags = 0;
+            unsigned current_values[16];
+            unsigned wanted_values[16];
+            size_t current_count = 16;
+            size_t wanted_count = 16;
+            const H5Z_filter_t filter = H5Pget_filter2(current, i, &current_flags, &current_count, current_values, 0, nullptr, nullptr);
+            same = filter == H5Pget_filter2(wanted, i, &wanted_flags, &wanted_count, wanted_values, 0, nullptr, nullptr) and
+                   current_flags == wanted_flags and wanted_count <= current_count and
+                   std::equal(wanted_values, wanted_values + std::min<size_t>(wanted_count, 16), current_values);
+        }
+        H5Pclose(current);
+        return same;
+    }
+
+    // Throws unless what is at `name` in `group_id` may be replaced by another element: nothing, a soft or external link, a
+    // dataset or the group of a columnar or sparse element. Other groups and objects are never removed to make room for one.
+    inline void CheckReplaceable(hid_t group_id, const std::string &name)
+    {
+        H5L_info_t link;
+        if(H5Lexists(group_id, name.c_str(), H5P_DEFAULT) <= 0 or H5Lget_info(group_id, name.c_str(), &link, H5P_DEFAULT) < 0 or
+           link.type != H5L_TYPE_HARD)
+        {
+            return;
+        }
+#if H5_VERSION_GE(1, 12, 0)
+        H5O_info2_t object;
+        const herr_t status = H5Oget_info_by_name3(group_id, name.c_str(), &object, H5O_INFO_BASIC, H5P_DEFAULT);
+#else
+        H5O_info_t object;
+        const herr_t status = H5Oget_info_by_name(group_id, name.c_str(), &object, H5P_DEFAULT);
+#endif
+        bool element = status >= 0 and object.type == H5O_TYPE_DATASET;
+        if(status >= 0 and object.type == H5O_TYPE_GROUP)
+        {
+            // the group of a columnar or sparse element
+            const hid_t group = H5Gopen2(group_id, name.c_str(), H5P_DEFAULT);
+            element = H5Aexists(group, HDF5Utils::LayoutAttribute) > 0;
+            H5Gclose(group);
+        }
+        if(not element)
+        {
+            throw std::runtime_error("HDF5Writer: cannot replace " + name + ", which is not a dataset");
+        }
+    }
+
+    // Value of LayoutAttribute of `group`, or "" if it has none.
+    inline std::string GroupLayout(const H5::Group &group)
+    {
+        std::string layout;
+        if(group.attrExists(HDF5Utils::LayoutAttribute))
+        {
+            const H5::Attribute attribute = group.openAttribute(HDF5Utils::LayoutAttribute);
+            attribute.read(attribute.getStrType(), layout);
+        }
+        return layout;
+    }
+
+    // Creates dataset `name`, or reopens an existing one with the same type, shape, layout and filters so it is overwritten in place.
+    // Another element, or a soft or external link, at `name` is unlinked first; anything else throws. A reopened dataset loses its
+    // zone map, which the new values invalidate.
+    inline hid_t CreateOrOpenDataSet(hid_t group_id, const std::string &name, hid_t type_id, hid_t space_id, hid_t plist_id)
+    {
+        CheckReplaceable(group_id, name);
+        H5L_info_t link;
+        if(H5Lexists(group_id, name.c_str(), H5P_DEFAULT) > 0 and H5Lget_info(group_id, name.c_str(), &link, H5P_DEFAULT) >= 0)
+        {
+            // a link is replaced, never written through: its target may be in another file
+            const hid_t existing = link.type == H5L_TYPE_HARD ? H5Dopen2(group_id, name.c_str(), H5P_DEFAULT) : -1;
+            if(existing >= 0)
+            {
+                const hid_t old_type = H5Dget_type(existing);
+                const hid_t old_space = H5Dget_space(existing);
+                const bool same = H5Tequal(old_type, type_id) > 0 and H5Sextent_equal(old_space, space_id) > 0 and
+                                  SameCreationProperties(existing, plist_id);
+                H5Tclose(old_type);
+                H5Sclose(old_space);
+                if(same)
+                {
+                    if(H5Aexists(existing, HDF5Utils::ZoneMapRowsAttribute) > 0)
+                    {
+                        H5Adelete(existing, HDF5Utils::ZoneMapRowsAttribute);
+                    }
+                    return existing;
+                }
+                H5Dclose(existing);
+            }
+            H5Ldelete(group_id, name.c_str(), H5P_DEFAULT);
+        }
+        return H5Dcreate2(group_id, name.c_str(), type_id, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
+    }
+
+    inline H5::DataSet CreateOrOpenDataSet(H5::Group &group, const std::string &name, const H5::DataType &type, const H5::DataSpace &space,
+                                           const H5::DSetCreatPropList &plist = H5::DSetCreatPropList::DEFAULT)
+    {
+        const hid_t dset_id = CreateOrOpenDataSet(group.getId(), name, type.getId(), space.getId(), plist.getId());
+        if(dset_id < 0)
+        {
+            throw std::runtime_error("HDF5Writer: cannot create dataset " + name);
+        }
+        H5::DataSet dataset(dset_id);
+        H5Dclose(dset_id);
+        return dataset;
+    }
+
+    // Calls `f` on the elements of `view` in row-major order.
+    template<typename T, typename F>
+    void VisitView(const HDF5Utils::StridedView<T> &view, F &&f)
+    {
+        const size_t ndims = view.dims.size();
+        const hsize_t total = view.Size();
+        if(ndims == 0 or total == 0)
+        {
+            return;
+        }
+        const std::vector<hsize_t> strides = view.ElementStrides();
+        const hsize_t cols = view.dims[ndims - 1];
+        const hsize_t step = strides[ndims - 1];
+        std::vector<hsize_t> index(ndims, 0);
+        hsize_t offset = 0;
+        for(hsize_t row = 0; row < total; row += cols)
+        {
+            const T *values = view.data + offset;
+            for(hsize_t j = 0; j < cols; ++j)
+            {
+                f(values[j * step]);
+            }
+            // advance the outer indices
+            for(size_t k = ndims - 1; k-- > 0;)
+            {
+                offset += strides[k];
+                if(++index[k] < view.dims[k])
+                {
+                    break;
+                }
+                offset -= strides[k] * view.dims[k];
+                index[k] = 0;
+            }
+        }
+    }
+
+    // Copies the elements of `view` in row-major order to `out`.
+    template<typename T>
+    void GatherView(const HDF5Utils::StridedView<T> &view, T *out)
+    {
+        VisitView(view, [&out](const T &value) { *out++ = value; });
+    }
+
+    // Memory dataspace whose hyperslab selects the elements of an array of `dims` laid out with `strides`,
+    // the outer extents being the ratios of consecutive strides. Returns false if the strides do not nest that way.
+    inline bool StridedMemorySpace(const std::vector<hsize_t> &dims, std::vector<hsize_t> strides, H5::DataSpace &memspace)
+    {
+        const int ndims = static_cast<int>(dims.size());
+        // the stride of a dimension of extent 1 is free; make it a whole row of the next dimension
+        for(int k = ndims; k-- > 0;)
+        {
+            if(dims[k] == 1)
+            {
+                strides[k] = k + 1 < ndims ? strides[k + 1] * dims[k + 1] : 1;
+            }
+        }
+        std::vector<hsize_t> extent(ndims);
+        std::vector<hsize_t> step(ndims);
+        hsize_t inner = 1;      // elements between consecutive indices of dimension k of the memory space
+        for(int k = ndims; k-- > 0;)
+        {
+            if(strides[k] == 0 or strides[k] % inner != 0)
+            {
+                return false;
+            }
+            step[k] = strides[k] / inner;
+            const hsize_t needed = (dims[k] - 1) * step[k] + 1;
+            extent[k] = needed;
+            if(k > 0)
+            {
+                if(strides[k - 1] % inner != 0 or strides[k - 1] / inner < needed)
+                {
+                    return false;
+                }
+                extent[k] = strides[k - 1] / inner;
+            }
+            inner *= extent[k];
+        }
+        memspace = H5::DataSpace(ndims, extent.data());
+        const std::vector<hsize_t> start(ndims, 0);
+        memspace.selectHyperslab(H5S_SELECT_SET, dims.data(), start.data(), step.data());
+        return true;
+    }
+
+    // Contiguous run of values with the interface WriteRectangularData() uses of a flat container.
+    template<typename T>
+    struct FlatSource
+    {
+        using value_type = T;
+
+        const T *values;
+        size_t count;
+
+        const T *data(void) const { return values; }
+        size_t size(void) const { return count; }
+        bool empty(void) const { return count == 0; }
+        const T &operator[](size_t i) const { return values[i]; }
+    };
+
+    // Hash of an element's contents, including the sizes of all nested containers.
+    template<typename T>
+    uint64_t HashData(const T &data, uint64_t seed = 0)
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            const auto view = HDF5Utils::ToView(data);
+            using V = typename decltype(view)::value_type;
+            seed = HDF5Utils::HashBytes(view.dims.data(), view.dims.size() * sizeof(hsize_t), seed);
+            if constexpr(not std::is_same_v<V, std::string>)
+            {
+                if(view.IsContiguous())
+                {
+                    return HDF5Utils::HashBytes(view.data, view.Size() * sizeof(V), seed);
+                }
+                HDF5Utils::Buffer<V> flat(view.Size());
+                GatherView(view, flat.data());
+                return HDF5Utils::HashBytes(flat.data(), flat.size() * sizeof(V), seed);
+            }
+            VisitView(view, [&seed](const V &value) { seed = HashData(value, seed); });
+            return seed;
+        }
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+        {
+            seed = HDF5Utils::HashBytes(&data.format, sizeof(data.format), seed);
+            seed = HashData(data.shape, seed);
+            seed = HashData(data.indptr, seed);
+            seed = HashData(data.indices, seed);
+            return HashData(data.values, seed);
+        }
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            using V = typename T::value_type;
+            const uint64_t size = data.size();
+            seed = HDF5Utils::HashBytes(&size, sizeof(size), seed);
+            if constexpr(not HDF5Utils::IsContainer<V>::value and not std::is_same_v<V, std::string>)
+            {
+                return HDF5Utils::HashBytes(data.data(), data.size() * sizeof(V), seed);
+            }
+            else
+            {
+                for(const V &x : data)
+                {
+                    seed = HashData(x, seed);
+                }
+                return seed;
+            }
+        }
+        else if constexpr(std::is_same_v<T, std::string>)
+        {
+            const uint64_t size = data.size();
+            return HDF5Utils::HashBytes(data.data(), data.size(), HDF5Utils::HashBytes(&size, sizeof(size), seed));
+        }
+        else
+        {
+            return HDF5Utils::HashBytes(&data, sizeof(T), seed);
+        }
+    }
+
+    // Stable description of the in-memory type of an element, so equal bytes of different types never match when deduplicating.
+    template<typename T>
+    std::string TypeSignature(void)
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            using V = typename decltype(HDF5Utils::ToView(std::declval<const T&>()))::value_type;
+            return "view<" + TypeSignature<V>() + ">";
+        }
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+            return "sparse<" + TypeSignature<typename T::value_type>() + ">";
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+            return "[" + TypeSignature<typename T::value_type>() + "]";
+        else if constexpr(std::is_same_v<T, std::string>)
+            return "string";
+        else if constexpr(HDF5Utils::HasCompType<T>::value)
+            return HDF5Utils::DescribeType(HDF5Utils::CompTypeCreator<T>::get().getId());
+        else
+            return HDF5Utils::DescribeType(HDF5Utils::HDF5Type<T>::value().getId());
+    }
+
+    // Hash of the options that change how an element is stored.
+    inline uint64_t HashOptions(const HDF5Utils::ElementOptions &options, uint64_t seed)
+    {
+        const int64_t fields[] = {static_cast<int64_t>(options.precision), options.scaleOffset, options.nbitPrecision,
+                                  static_cast<int64_t>(options.compoundLayout), static_cast<int64_t>(options.chunkRows),
+                                  options.appendable, static_cast<int64_t>(options.stringEncoding), options.pyramidLevels,
+                                  static_cast<int64_t>(options.pyramidReduction), static_cast<int64_t>(options.zoneMapRows)};
+        return HDF5Utils::HashBytes(fields, sizeof(fields), seed);
+    }
+
+    // Approximate payload size of an element in bytes.
+    template<typename T>
+    size_t PayloadBytes(const T &data)
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            const auto view = HDF5Utils::ToView(data);
+            using V = typename decltype(view)::value_type;
+            if constexpr(std::is_same_v<V, std::string>)
+            {
+                size_t bytes = 0;
+                VisitView(view, [&bytes](const V &value) { bytes += value.size(); });
+                return bytes;
+            }
+            return view.Size() * sizeof(V);
+        }
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+        {
+            return PayloadBytes(data.indptr) + PayloadBytes(data.indices) + PayloadBytes(data.values);
+        }
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            using V = typename T::value_type;
+            if constexpr(not HDF5Utils::IsContainer<V>::value and not std::is_same_v<V, std::string>)
+            {
+                return data.size() * sizeof(V);
+            }
+            else
+            {
+                size_t bytes = 0;
+                for(const V &x : data)
+                {
+                    bytes += PayloadBytes(x);
+                }
+                return bytes;
+            }
+        }
+        else if constexpr(std::is_same_v<T, std::string>)
+        {
+            return data.size();
+        }
+        else
+        {
+            return sizeof(T);
+        }
+    }
+
+    // hvl_t arrays of the nested levels of a jagged element
+    using HvlStorage = std::deque<HDF5Utils::Buffer<hvl_t>, HDF5Utils::ScratchAllocator<HDF5Utils::Buffer<hvl_t>>>;
+
     template<typename Container>
-    void CreateVHLsImpl(const Container &data, std::vector<hvl_t> &pointers, std::deque<std::vector<hvl_t>> &storage)
+    void CreateVHLsImpl(const Container &data, HDF5Utils::Buffer<hvl_t> &pointers, HvlStorage &storage)
     {
         using Inner = typename Container::value_type;
         using T = typename Inner::value_type;
@@ -64,7 +437,7 @@ namespace HDF5Writer_detail
 
     template<typename Container>
     void WriteJaggedDataNestedVLEN(H5::Group &group, const std::string &name, const Container &data,
-                                    std::vector<hvl_t> &vhl, std::deque<std::vector<hvl_t>> &storage)
+                                    HDF5Utils::Buffer<hvl_t> &vhl, HvlStorage &storage)
     {
         using Inner = typename Container::value_type;
         using T = typename Inner::value_type;
@@ -93,8 +466,7 @@ namespace HDF5Writer_detail
         hsize_t dims[] = {static_cast<hsize_t>(data.size())};
         hid_t space_id = H5Screate_simple(1, dims, nullptr);
         hid_t group_id = group.getId();
-        hid_t dset_id = H5Dcreate2(group_id, name.c_str(), vlen_tid, space_id,
-                                  H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        hid_t dset_id = CreateOrOpenDataSet(group_id, name, vlen_tid, space_id, H5P_DEFAULT);
 
         H5Dwrite(dset_id, vlen_tid, H5S_ALL, H5S_ALL, H5P_DEFAULT, vhl.data());
 
@@ -111,8 +483,8 @@ namespace HDF5Writer_detail
     {
         using Inner = typename Container::value_type;
         using T = typename Inner::value_type;
-        std::vector<hvl_t> vhl;
-        std::deque<std::vector<hvl_t>> storage;
+        HDF5Utils::Buffer<hvl_t> vhl;
+        HvlStorage storage;
         CreateVHLsImpl(data, vhl, storage);
 
         if constexpr(HDF5Utils::IsContainer<T>::value)
@@ -125,13 +497,13 @@ namespace HDF5Writer_detail
             H5::DataType &type = HDF5Writer_detail::CreateVarLenType<Inner>(types);
             hsize_t dims[] = {static_cast<hsize_t>(data.size())};
             H5::DataSpace dataspace(1, dims);
-            H5::DataSet dataset = group.createDataSet(name, type, dataspace);
+            H5::DataSet dataset = CreateOrOpenDataSet(group, name, type, dataspace);
             dataset.write(vhl.data(), type);
         }
     }
 
-    template<typename Container>
-    void flattenRectangular(const Container &data, std::vector<typename HDF5Utils::InnerType<Container>::type> &flat)
+    template<typename Container, typename Flat>
+    void flattenRectangular(const Container &data, Flat &flat)
     {
         using T = typename Container::value_type;
         if constexpr(HDF5Utils::IsContainer<T>::value)
@@ -149,160 +521,1385 @@ namespace HDF5Writer_detail
         }
     }
 
-    template<typename Container>
-    void WriteRectangularData(H5::Group &group, const std::string &name, const Container &data, const hsize_t *dims, int ndims)
+    // Copies the rectangular `data` of `dims` to `out`, advancing it. Returns false if a row does not match `dims`.
+    template<typename Container, typename Scalar>
+    bool flattenRectangularInto(const Container &data, const hsize_t *dims, Scalar *&out)
     {
         using T = typename Container::value_type;
-        if constexpr(HDF5Utils::IsContainer<T>::value)
+        if(data.size() != dims[0])
         {
-            using Scalar = typename HDF5Utils::InnerType<Container>::type;
-            std::vector<Scalar> flat;
-            flattenRectangular(data, flat);
-            WriteRectangularData(group, name, flat, dims, ndims);
+            return false;
         }
-        else if constexpr(std::is_same_v<T, std::string>)
+        if constexpr(HDF5Utils::IsContainer<T>::value)
         {
-            H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
-            H5::DataSpace dataspace(ndims, dims);
-            H5::DataSet dataset = group.createDataSet(name, strType, dataspace);
-            if(not data.empty())
+            for(const auto &row : data)
             {
-                std::vector<const char*> cstrs(data.size());
-                for(size_t i = 0; i < data.size(); i++)
-                    cstrs[i] = data[i].c_str();
-                dataset.write(cstrs.data(), strType);
+                if(not flattenRectangularInto(row, dims + 1, out))
+                {
+                    return false;
+                }
             }
         }
         else
         {
-            H5::DataSpace dataspace(ndims, dims);
-            H5::DataType mem_type;
-            if constexpr(HDF5Utils::HasCompType<T>::value)
-            {
-                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
-            }
-            else
+            out = std::copy(data.begin(), data.end(), out);
+        }
+        return true;
+    }
+
+    // On-disk type for scalar type T: compound types are packed, and `options` may narrow floating-point
+    // or integer types. HDF5 converts from the memory type on write and back on read.
+    template<typename T>
+    H5::DataType CreateFileType(const H5::DataType &mem_type, const HDF5Utils::ElementOptions &options)
+    {
+        if constexpr(HDF5Utils::HasCompType<T>::value)
+        {
+            if(options.compoundLayout == HDF5Utils::CompoundLayout::Native)
             {
-                mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
+                return mem_type;
             }
-
-            H5::DataType file_type = mem_type;
-            if constexpr(HDF5Utils::HasCompType<T>::value)
+            hid_t packed_id = H5Tcopy(mem_type.getId());
+            H5Tpack(packed_id);
+            H5::DataType packed(packed_id);
+            H5Tclose(packed_id);
+            return packed;
+        }
+        else if constexpr(std::is_floating_point_v<T>)
+        {
+            hid_t type_id = H5Tcopy(mem_type.getId());
+            if(options.precision == HDF5Utils::StoragePrecision::Float32 and sizeof(T) > sizeof(float))
             {
-                hid_t packed_id = H5Tcopy(mem_type.getId());
-                H5Tpack(packed_id);
-                file_type = H5::DataType(packed_id);
+                H5Tclose(type_id);
+                type_id = H5Tcopy(H5T_NATIVE_FLOAT);
             }
-
-            H5::DataSet dataset = group.createDataSet(name, file_type, dataspace);
-            if(not data.empty())
+            if(options.nbitPrecision > 0)
             {
-                dataset.write(data.data(), mem_type);
+                // keep sign and exponent, drop the low mantissa bits
+                size_t spos, epos, esize, mpos, msize;
+                H5Tget_fields(type_id, &spos, &epos, &esize, &mpos, &msize);
+                const size_t keep = std::min(static_cast<size_t>(options.nbitPrecision), msize);
+                const size_t offset = mpos + msize - keep;
+                H5Tset_fields(type_id, spos, epos, esize, offset, keep);
+                // moving the offset first grows the type; shrink it back once the precision is set
+                const size_t size = H5Tget_size(type_id);
+                H5Tset_offset(type_id, offset);
+                H5Tset_precision(type_id, spos - offset + 1);
+                H5Tset_size(type_id, size);
             }
-            else
+            H5::DataType file_type(type_id);
+            H5Tclose(type_id);
+            return file_type;
+        }
+        else if constexpr(std::is_integral_v<T>)
+        {
+            hid_t type_id = H5Tcopy(mem_type.getId());
+            if(options.nbitPrecision > 0)
             {
-                dataset.write(nullptr, mem_type);
+                const size_t bits = std::min(static_cast<size_t>(options.nbitPrecision), 8 * sizeof(T));
+                H5Tset_precision(type_id, bits);
             }
+            H5::DataType file_type(type_id);
+            H5Tclose(type_id);
+            return file_type;
+        }
+        else
+        {
+            return mem_type;
         }
     }
 
-    template<typename Container>
-    bool isRectangular(const Container &data, std::vector<hsize_t> &dims)
+    // Dataset creation properties for a rectangular element: chunked when a filter is requested.
+    template<typename T>
+    H5::DSetCreatPropList CreateDataSetProps(const H5::DataType &file_type, const hsize_t *dims, int ndims,
+                                             const HDF5Utils::ElementOptions &options)
     {
-        using T = typename Container::value_type;
-        dims.clear();
-        if constexpr(not HDF5Utils::IsContainer<T>::value) 
-        {
-            dims.push_back(static_cast<hsize_t>(data.size()));
-            return true;
-        }
-        if(data.empty())
+        H5::DSetCreatPropList plist;
+        const bool filtered = std::is_arithmetic_v<T> and (options.scaleOffset >= 0 or options.nbitPrecision > 0);
+        if((not filtered and not options.appendable) or ndims == 0)
         {
-            dims.assign(static_cast<size_t>(HDF5Utils::Rank<T>::value), 1);
-            return true;
+            return plist;
         }
-        dims.push_back(static_cast<hsize_t>(data.size()));
-        const size_t first = data[0].size();
-        for(size_t i = 1; i < data.size(); ++i)
+        // an appendable element created empty takes its row shape from the first append
+        std::vector<hsize_t> chunk(dims, dims + ndims);
+        size_t row_bytes = file_type.getSize();
+        for(int i = 1; i < ndims; ++i)
         {
-            if(data[i].size() != first)
+            if(options.appendable and chunk[i] == 0)
             {
-                return false;
+                chunk[i] = 1;
             }
+            row_bytes *= chunk[i];
+        }
+        if((dims[0] == 0 and not options.appendable) or row_bytes == 0)
+        {
+            return plist;
+        }
+
+        hsize_t rows = options.chunkRows > 0 ? options.chunkRows : std::max<hsize_t>(1, (1 << 20) / row_bytes);
+        chunk[0] = options.appendable ? rows : std::min(rows, dims[0]);
+        plist.setChunk(ndims, chunk.data());
+        if(not filtered)
+        {
+            return plist;
         }
-        if constexpr(HDF5Utils::IsContainer<typename T::value_type>::value)
+
+        if(options.scaleOffset >= 0)
         {
-            std::vector<hsize_t> inner_dims;
-            if(not isRectangular(data[0], inner_dims))
+            if constexpr(std::is_floating_point_v<T>)
             {
-                return false;
+                H5Pset_scaleoffset(plist.getId(), H5Z_SO_FLOAT_DSCALE, options.scaleOffset);
             }
-            dims.insert(dims.end(), inner_dims.begin(), inner_dims.end());
-            for(size_t i = 1; i < data.size(); ++i) 
+            else if constexpr(std::is_integral_v<T>)
             {
-                std::vector<hsize_t> row_dims;
-                if(not isRectangular(data[i], row_dims))
-                {
-                    return false;
-                }
-                if(row_dims != inner_dims)
-                {
-                    return false;
-                }
+                H5Pset_scaleoffset(plist.getId(), H5Z_SO_INT, options.scaleOffset);
             }
         }
-        else
+        if(options.nbitPrecision > 0)
         {
-            dims.push_back(static_cast<hsize_t>(first));
+            plist.setNbit();
         }
-        return true;
+        return plist;
     }
 
-    template<typename Container>
-    void WriteContainerData(H5::Group &group, const std::string &name, const Container &data)
+    // File dataspace of a rectangular element; appendable elements get an unlimited first dimension.
+    inline H5::DataSpace CreateDataSpace(const hsize_t *dims, int ndims, const H5::DSetCreatPropList &plist,
+                                         const HDF5Utils::ElementOptions &options)
     {
-        using T = typename Container::value_type;
-        if constexpr(HDF5Utils::IsContainer<T>::value) 
+        std::vector<hsize_t> maxdims(dims, dims + ndims);
+        if(options.appendable and plist.getLayout() == H5D_CHUNKED)
         {
-            // high dimension (>= 2)
-            std::vector<hsize_t> dims;
-            if (isRectangular(data, dims))
-            {
-                WriteRectangularData(group, name, data, dims.data(), static_cast<int>(dims.size()));
-            }
-            else 
+            for(int i = 0; i < ndims; ++i)
             {
-                WriteJaggedData(group, name, data);
+                if(i == 0 or dims[i] == 0)
+                {
+                    maxdims[i] = H5S_UNLIMITED;
+                }
             }
         }
-        else
+        return H5::DataSpace(ndims, dims, maxdims.data());
+    }
+
+    // Size of the staging buffer that WriteCompoundBlocks() needs for records of `recordBytes` (in the file) in an element of `dims`.
+    inline size_t CompoundStagingBytes(const hsize_t *dims, int ndims, size_t recordBytes)
+    {
+        size_t row_records = 1;
+        for(int i = 1; i < ndims; ++i)
         {
-            // flat vector
-            hsize_t dims[] = {static_cast<hsize_t>(data.size())};
-            WriteRectangularData(group, name, data, dims, 1);
+            row_records *= dims[i];
+        }
+        if(ndims == 0 or dims[0] == 0 or row_records == 0)
+        {
+            return 0;
+        }
+        const hsize_t block_rows = std::max<hsize_t>(1, HDF5Utils::CompoundBlockBytes / (row_records * recordBytes));
+        return std::min(block_rows, dims[0]) * row_records * recordBytes;
+    }
+
+    // Repacks the records at `data` following `plan` in blocks of rows staged in `buffer` (`bufferBytes`, at least one row)
+    // and writes each block into the dataset of `file_type`.
+    inline void WriteCompoundBlocks(H5::DataSet &dataset, const void *data, const H5::DataType &file_type, const HDF5Utils::CompoundCopyPlan &plan,
+                                    char *buffer, size_t bufferBytes, const hsize_t *dims, int ndims)
+    {
+        size_t row_records = 1;
+        for(int i = 1; i < ndims; ++i)
+        {
+            row_records *= dims[i];
+        }
+        const hsize_t block_rows = std::max<hsize_t>(1, bufferBytes / (row_records * plan.dstSize));
+        const char *records = static_cast<const char*>(data);
+
+        H5::DataSpace filespace = dataset.getSpace();
+        std::vector<hsize_t> start(ndims, 0);
+        std::vector<hsize_t> count(dims, dims + ndims);
+        for(hsize_t row = 0; row < dims[0]; row += block_rows)
+        {
+            start[0] = row;
+            count[0] = std::min(block_rows, dims[0] - row);
+            HDF5Utils::ApplyCompoundCopyPlan(plan, records + row * row_records * plan.srcSize, buffer, count[0] * row_records);
+            H5::DataSpace memspace(ndims, count.data());
+            filespace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+            dataset.write(buffer, file_type, memspace, filespace);
         }
     }
 
+    // Writes compound records into the packed `file_type` by repacking them in bounded blocks of rows,
+    // so HDF5 sees identical memory and file types and skips its generic conversion.
     template<typename T>
-    void WriteScalarData(H5::Group &group, const std::string &name, const T &data)
+    void WritePackedCompound(H5::DataSet &dataset, const T *data, const H5::DataType &mem_type, const H5::DataType &file_type,
+                             const hsize_t *dims, int ndims)
     {
-        if constexpr(std::is_same_v<T, std::string>)
+        const HDF5Utils::CompoundCopyPlan plan = HDF5Utils::BuildCompoundCopyPlan(mem_type.getId(), file_type.getId());
+        if(not plan.valid)
         {
-            H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
-            H5::DataSpace dataspace;
-            H5::DataSet dataset = group.createDataSet(name, strType, dataspace);
-            const char *cstr = data.c_str();
-            dataset.write(&cstr, strType);
+            dataset.write(data, mem_type);
+            return;
         }
-        else
+        HDF5Utils::Buffer<char> buffer(CompoundStagingBytes(dims, ndims, plan.dstSize));
+        if(not buffer.empty())
         {
-            H5::DataSpace dataspace;
-            H5::DataType mem_type;
-            if constexpr(HDF5Utils::HasCompType<T>::value)
-                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
-            else
-                mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
-            H5::DataSet dataset = group.createDataSet(name, mem_type, dataspace);
+            WriteCompoundBlocks(dataset, data, file_type, plan, buffer.data(), buffer.size(), dims, ndims);
+        }
+    }
+
+    // Writes compound records as a group `name` with one dataset per member of `mem_type` (struct of arrays),
+    // gathering each member in bounded blocks of rows.
+    template<typename T>
+    void WriteColumnarCompound(H5::Group &group, const std::string &name, const T *data, const H5::DataType &mem_type,
+                               const hsize_t *dims, int ndims)
+    {
+        // only the group of an earlier columnar element is reused; a dataset or a sparse element is replaced
+        CheckReplaceable(group.getId(), name);
+        if(group.exists(name) and (group.childObjType(name) != H5O_TYPE_GROUP or GroupLayout(group.openGroup(name)) != HDF5Utils::ColumnarLayout))
+        {
+            H5Ldelete(group.getId(), name.c_str(), H5P_DEFAULT);
+        }
+        H5::Group columns = group.exists(name) ? group.openGroup(name) : group.createGroup(name);
+        if(columns.attrExists(HDF5Utils::LayoutAttribute))
+        {
+            columns.removeAttr(HDF5Utils::LayoutAttribute);
+        }
+        H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+        columns.createAttribute(HDF5Utils::LayoutAttribute, str_type, H5::DataSpace()).write(str_type, std::string(HDF5Utils::ColumnarLayout));
+
+        // drop columns of members the type no longer has
+        const hid_t mem_id = mem_type.getId();
+        for(hsize_t n = columns.getNumObjs(); n-- > 0;)
+        {
+            const std::string column = columns.getObjnameByIdx(n);
+            if(H5Tget_member_index(mem_id, column.c_str()) < 0)
+            {
+                H5Ldelete(columns.getId(), column.c_str(), H5P_DEFAULT);
+            }
+        }
+
+        size_t row_records = 1;
+        for(int i = 1; i < ndims; ++i)
+        {
+            row_records *= dims[i];
+        }
+        const H5::DataSpace dataspace(ndims, dims);
+        const int members = H5Tget_nmembers(mem_id);
+        for(int m = 0; m < members; ++m)
+        {
+            char *member_name = H5Tget_member_name(mem_id, m);
+            const std::string column(member_name);
+            H5free_memory(member_name);
+            const size_t offset = H5Tget_member_offset(mem_id, m);
+            const hid_t member_id = H5Tget_member_type(mem_id, m);
+            H5::DataType column_type(member_id);
+            H5Tclose(member_id);
+            H5::DataType file_type = column_type;
+            if(column_type.getClass() == H5T_COMPOUND)
+            {
+                const hid_t packed_id = H5Tcopy(column_type.getId());
+                H5Tpack(packed_id);
+                file_type = H5::DataType(packed_id);
+                H5Tclose(packed_id);
+            }
+
+            H5::DataSet dataset = CreateOrOpenDataSet(columns, column, file_type, dataspace);
+            if(ndims == 0 or dims[0] == 0 or row_records == 0)
+            {
+                continue;
+            }
+            const size_t size = column_type.getSize();
+            HDF5Utils::CompoundCopyPlan gather;
+            gather.segments.push_back({offset, 0, size});
+            gather.srcSize = sizeof(T);
+            gather.dstSize = size;
+            gather.valid = true;
+            const hsize_t block_rows = std::max<hsize_t>(1, HDF5Utils::CompoundBlockBytes / (row_records * size));
+            HDF5Utils::Buffer<char> buffer(std::min(block_rows, dims[0]) * row_records * size);
+            H5::DataSpace filespace = dataset.getSpace();
+            std::vector<hsize_t> start(ndims, 0);
+            std::vector<hsize_t> count(dims, dims + ndims);
+            for(hsize_t row = 0; row < dims[0]; row += block_rows)
+            {
+                start[0] = row;
+                count[0] = std::min(block_rows, dims[0] - row);
+                HDF5Utils::ApplyCompoundCopyPlan(gather, data + row * row_records, buffer.data(), count[0] * row_records);
+                H5::DataSpace memspace(ndims, count.data());
+                filespace.selectHyperslab(H5S_SELECT_SET, count.data(), start.data());
+                dataset.write(buffer.data(), column_type, memspace, filespace);
+            }
+        }
+    }
+
+    template<typename Code>
+    void WriteDictionaryCodes(H5::Group &group, const std::string &name, const std::vector<const std::string*> &dictionary,
+                              const HDF5Utils::Buffer<uint16_t> &codes, const H5::PredType &base, const hsize_t *dims, int ndims,
+                              const HDF5Utils::ElementOptions &options)
+    {
+        std::string empty_name;
+        for(const std::string *value : dictionary)
+        {
+            if(value->empty())
+            {
+                empty_name = "<empty>";
+                while(std::any_of(dictionary.begin(), dictionary.end(), [&](const std::string *v) { return *v == empty_name; }))
+                {
+                    empty_name += '_';
+                }
+            }
+        }
+
+        hid_t type_id = H5Tenum_create(base.getId());
+        for(size_t i = 0; i < dictionary.size(); ++i)
+        {
+            const Code value = static_cast<Code>(i);
+            H5Tenum_insert(type_id, dictionary[i]->empty() ? empty_name.c_str() : dictionary[i]->c_str(), &value);
+        }
+        H5::DataType enum_type(type_id);
+        H5Tclose(type_id);
+
+        const HDF5Utils::Buffer<Code> narrow(codes.begin(), codes.end());
+        H5::DSetCreatPropList plist = CreateDataSetProps<std::string>(enum_type, dims, ndims, options);
+        H5::DataSpace dataspace = CreateDataSpace(dims, ndims, plist, options);
+        H5::DataSet dataset = CreateOrOpenDataSet(group, name, enum_type, dataspace, plist);
+        dataset.write(narrow.data(), enum_type);
+
+        if(dataset.attrExists(HDF5Utils::DictionaryEmptyAttribute))
+        {
+            dataset.removeAttr(HDF5Utils::DictionaryEmptyAttribute);
+        }
+        if(not empty_name.empty())
+        {
+            H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+            H5::Attribute attribute = dataset.createAttribute(HDF5Utils::DictionaryEmptyAttribute, str_type, H5::DataSpace());
+            attribute.write(str_type, empty_name);
+        }
+    }
+
+    // Dictionary encoding of `count` strings. Returns false, without creating anything, if the distinct strings
+    // do not fit in an enum type.
+    inline bool WriteDictionaryStrings(H5::Group &group, const std::string &name, const std::string *values, size_t count,
+                                       const hsize_t *dims, int ndims, const HDF5Utils::ElementOptions &options)
+    {
+        std::pmr::unordered_map<std::string_view, uint16_t> index(HDF5Utils::CurrentMemoryResource());
+        std::vector<const std::string*> dictionary;
+        HDF5Utils::Buffer<uint16_t> codes(count);
+        size_t bytes = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            auto [it, inserted] = index.try_emplace(std::string_view(values[i]), static_cast<uint16_t>(dictionary.size()));
+            if(inserted)
+            {
+                // enum names are C strings
+                bytes += values[i].size() + 1;
+                if(bytes > HDF5Utils::DictionaryMaxBytes or values[i].find('\0') != std::string::npos)
+                {
+                    return false;
+                }
+                dictionary.push_back(&values[i]);
+            }
+            codes[i] = it->second;
+        }
+        if(dictionary.empty())
+        {
+            return false;
+        }
+
+        if(dictionary.size() <= 256)
+            WriteDictionaryCodes<uint8_t>(group, name, dictionary, codes, H5::PredType::NATIVE_UINT8, dims, ndims, options);
+        else
+            WriteDictionaryCodes<uint16_t>(group, name, dictionary, codes, H5::PredType::NATIVE_UINT16, dims, ndims, options);
+        return true;
+    }
+
+    // Halves `axis` of the row-major array `in` of `dims` into `out`, combining rows 2j and 2j + 1 with `op`; an odd last row
+    // is copied. The inner loop runs over contiguous values, so the compiler vectorizes it for every axis but the last.
+    template<typename In, typename W, typename Op>
+    void HalveAxis(const In *in, W *out, const std::vector<hsize_t> &dims, size_t axis, Op op)
+    {
+        size_t outer = 1, inner = 1;
+        for(size_t i = 0; i < axis; ++i)
+        {
+            outer *= dims[i];
+        }
+        for(size_t i = axis + 1; i < dims.size(); ++i)
+        {
+            inner *= dims[i];
+        }
+        const size_t rows = dims[axis], pairs = rows / 2, halved = (rows + 1) / 2;
+        for(size_t o = 0; o < outer; ++o)
+        {
+            const In *src = in + o * rows * inner;
+            W *dst = out + o * halved * inner;
+            if(inner == 1)
+            {
+                for(size_t j = 0; j < pairs; ++j)
+                {
+                    dst[j] = op(static_cast<W>(src[2 * j]), static_cast<W>(src[2 * j + 1]));
+                }
+            }
+            else
+            {
+                for(size_t j = 0; j < pairs; ++j)
+                {
+                    const In *a = src + 2 * j * inner;
+                    const In *b = a + inner;
+                    W *r = dst + j * inner;
+                    for(size_t k = 0; k < inner; ++k)
+                    {
+                        r[k] = op(static_cast<W>(a[k]), static_cast<W>(b[k]));
+                    }
+                }
+            }
+            if(rows % 2 != 0)
+            {
+                const In *a = src + pairs * 2 * inner;
+                W *r = dst + pairs * inner;
+                for(size_t k = 0; k < inner; ++k)
+                {
+                    r[k] = static_cast<W>(a[k]);
+                }
+            }
+        }
+    }
+
+    // Writes the decimated levels of the numeric element `group/name` under HDF5Utils::PyramidGroup, in type W: each level
+    // halves every dimension of the previous one, axis by axis. Levels left over from an earlier, deeper pyramid are removed.
+    template<typename T, typename W>
+    void WritePyramidLevels(H5::Group &group, const std::string &name, const T *data, const hsize_t *dims, int ndims,
+                            const HDF5Utils::ElementOptions &options)
+    {
+        const HDF5Utils::PyramidReduction reduction = options.pyramidReduction;
+        const auto op = [reduction](W a, W b) -> W
+        {
+            switch(reduction)
+            {
+                case HDF5Utils::PyramidReduction::Mean: return (a + b) / 2;
+                case HDF5Utils::PyramidReduction::Max: return a < b ? b : a;
+                default: return a;
+            }
+        };
+
+        std::string path = group.getObjName();
+        path = (path == "/" ? "" : path) + "/" + name;
+        const hid_t file_id = H5Iget_file_id(group.getId());
+        H5::H5File file(file_id);
+        H5Fclose(file_id);
+        H5::Group pyramid = HDF5Utils::openGroupPath(file, HDF5Utils::PyramidPath(path), true);
+        if(pyramid.attrExists(HDF5Utils::ReductionAttribute))
+        {
+            pyramid.removeAttr(HDF5Utils::ReductionAttribute);
+        }
+        const char *names[] = {"mean", "max", "stride"};
+        const H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+        pyramid.createAttribute(HDF5Utils::ReductionAttribute, str_type, H5::DataSpace())
+               .write(str_type, std::string(names[static_cast<int>(reduction)]));
+
+        // levels keep the precision of the element, not its filters
+        HDF5Utils::ElementOptions level_options;
+        level_options.precision = options.precision;
+        const H5::DataType mem_type(HDF5Utils::HDF5Type<W>::value());
+        const H5::DataType file_type = CreateFileType<W>(mem_type, level_options);
+
+        std::vector<hsize_t> shape(dims, dims + ndims);
+        std::vector<W> current, next;
+        unsigned level = 0;
+        while(level < options.pyramidLevels and std::any_of(shape.begin(), shape.end(), [](hsize_t d) { return d > 1; }))
+        {
+            for(size_t axis = 0; axis < shape.size(); ++axis)
+            {
+                if(shape[axis] <= 1)
+                {
+                    continue;
+                }
+                size_t size = 1;
+                for(size_t i = 0; i < shape.size(); ++i)
+                {
+                    size *= i == axis ? (shape[i] + 1) / 2 : shape[i];
+                }
+                next.resize(size);
+                // the first pass reads the element itself
+                if(current.empty())
+                    HalveAxis(data, next.data(), shape, axis, op);
+                else
+                    HalveAxis(current.data(), next.data(), shape, axis, op);
+                shape[axis] = (shape[axis] + 1) / 2;
+                current.swap(next);
+            }
+            ++level;
+            H5::DSetCreatPropList plist = CreateDataSetProps<W>(file_type, shape.data(), ndims, level_options);
+            H5::DataSpace dataspace = CreateDataSpace(shape.data(), ndims, plist, level_options);
+            CreateOrOpenDataSet(pyramid, std::to_string(level), file_type, dataspace, plist).write(current.data(), mem_type);
+        }
+        for(std::string stale = std::to_string(level + 1); pyramid.exists(stale); stale = std::to_string(++level + 1))
+        {
+            H5Ldelete(pyramid.getId(), stale.c_str(), H5P_DEFAULT);
+        }
+    }
+
+    // Removes the levels of the element at `path` of the file of `loc_id`, rewritten without them. Pyramids of the elements
+    // below `path`, if it was a group, are left alone.
+    inline void RemovePyramid(hid_t loc_id, const std::string &path)
+    {
+        const std::string pyramid_path = HDF5Utils::PyramidPath(path);
+        htri_t exists = 0;
+        H5E_BEGIN_TRY
+        {
+            exists = H5Lexists(loc_id, HDF5Utils::PyramidGroup, H5P_DEFAULT) > 0 ? H5Lexists(loc_id, pyramid_path.c_str(), H5P_DEFAULT) : 0;
+        }
+        H5E_END_TRY
+        if(exists <= 0)
+        {
+            return;
+        }
+        const hid_t pyramid = H5Gopen2(loc_id, pyramid_path.c_str(), H5P_DEFAULT);
+        if(pyramid < 0)
+        {
+            return;
+        }
+        for(unsigned level = 1; H5Lexists(pyramid, std::to_string(level).c_str(), H5P_DEFAULT) > 0; ++level)
+        {
+            H5Ldelete(pyramid, std::to_string(level).c_str(), H5P_DEFAULT);
+        }
+        if(H5Aexists(pyramid, HDF5Utils::ReductionAttribute) > 0)
+        {
+            H5Adelete(pyramid, HDF5Utils::ReductionAttribute);
+        }
+        H5G_info_t info;
+        const bool empty = H5Gget_info(pyramid, &info) >= 0 and info.nlinks == 0;
+        H5Gclose(pyramid);
+        if(empty)
+        {
+            H5Ldelete(loc_id, pyramid_path.c_str(), H5P_DEFAULT);
+        }
+    }
+
+    inline void RemovePyramid(H5::Group &group, const std::string &name)
+    {
+        const std::string path = group.getObjName();
+        RemovePyramid(group.getId(), (path == "/" ? "" : path) + "/" + name);
+    }
+
+    // Removes the levels left by an earlier write of `group/name` unless this write of values of type T may store them;
+    // WritePyramidLevels prunes those it does not rewrite.
+    template<typename T>
+    void PrunePyramid(H5::Group &group, const std::string &name, const HDF5Utils::ElementOptions &options)
+    {
+        if(not (std::is_arithmetic_v<T> and not std::is_same_v<T, bool>) or options.pyramidLevels == 0 or options.appendable)
+        {
+            RemovePyramid(group, name);
+        }
+    }
+
+    template<typename T>
+    void WritePyramid(H5::Group &group, const std::string &name, const T *data, const hsize_t *dims, int ndims,
+                      const HDF5Utils::ElementOptions &options)
+    {
+        // integer means would truncate, so they are kept in double
+        if constexpr(std::is_integral_v<T>)
+        {
+            if(options.pyramidReduction == HDF5Utils::PyramidReduction::Mean)
+            {
+                WritePyramidLevels<T, double>(group, name, data, dims, ndims, options);
+                return;
+            }
+        }
+        WritePyramidLevels<T, T>(group, name, data, dims, ndims, options);
+    }
+
+    // Minimum and maximum of `count` values; NaNs are skipped, so a block of NaNs gets an empty range (max < min).
+    // Plain select loops, which the compiler turns into vector min/max.
+    template<typename T>
+    std::pair<T, T> MinMax(const T *values, size_t count)
+    {
+        T low = HDF5Utils::ValueRange<T>().high;
+        T high = HDF5Utils::ValueRange<T>().low;
+        for(size_t i = 0; i < count; ++i)
+        {
+            low = values[i] < low ? values[i] : low;
+            high = values[i] > high ? values[i] : high;
+        }
+        return {low, high};
+    }
+
+    // Minimum and maximum of each block of `block_rows` rows of `rows` rows of `row` values, into `ranges` (2 per block).
+    template<typename T>
+    void ZoneRanges(const T *data, hsize_t rows, size_t row, hsize_t block_rows, T *ranges)
+    {
+        for(hsize_t first = 0, b = 0; first < rows; first += block_rows, ++b)
+        {
+            const hsize_t count = std::min(block_rows, rows - first);
+            std::tie(ranges[2 * b], ranges[2 * b + 1]) = MinMax(data + first * row, count * row);
+        }
+    }
+
+    // Throws if `options` ask for a zone map of values that scale-offset rounds: the filter changes them after the ranges
+    // are computed.
+    template<typename T>
+    void CheckZoneMapOptions(const std::string &name, const HDF5Utils::ElementOptions &options)
+    {
+        const bool rounded = options.scaleOffset > 0 or (std::is_floating_point_v<T> and options.scaleOffset >= 0);
+        if(options.zoneMapRows > 0 and not options.appendable and rounded)
+        {
+            throw std::runtime_error("HDF5Writer: zone maps need a lossless scaleOffset: " + name);
+        }
+    }
+
+    // Like ZoneRanges(), for the values as stored with `file_type` (Float32 or n-bit precision): each block is converted to
+    // the file type and back first. The file type is never wider than T, so the conversion fits in place.
+    template<typename T>
+    void StoredZoneRanges(const T *data, hsize_t rows, size_t row, hsize_t block_rows, const H5::DataType &file_type, T *ranges)
+    {
+        const hid_t mem_id = HDF5Utils::HDF5Type<T>::value().getId();
+        std::vector<T> buffer(std::min(block_rows, rows) * row);
+        for(hsize_t first = 0, b = 0; first < rows; first += block_rows, ++b)
+        {
+            const size_t count = std::min(block_rows, rows - first) * row;
+            std::copy(data + first * row, data + first * row + count, buffer.begin());
+            H5Tconvert(mem_id, file_type.getId(), count, buffer.data(), nullptr, H5P_DEFAULT);
+            H5Tconvert(file_type.getId(), mem_id, count, buffer.data(), nullptr, H5P_DEFAULT);
+            std::tie(ranges[2 * b], ranges[2 * b + 1]) = MinMax(buffer.data(), count);
+        }
+    }
+
+    // Stores the zone map `ranges` of the element `path` under HDF5Utils::ZoneMapGroup and marks its `dataset` as having one.
+    template<typename T>
+    void StoreZoneMap(H5::H5File &file, const std::string &path, H5::DataSet &dataset, const std::vector<T> &ranges, hsize_t block_rows)
+    {
+        const auto [map_group, map_name] = HDF5Utils::splitPathAndName(HDF5Utils::ZoneMapPath(path));
+        H5::Group parent = HDF5Utils::openGroupPath(file, map_group, true);
+        const hsize_t map_dims[] = {ranges.size() / 2, 2};
+        const H5::DataType mem_type(HDF5Utils::HDF5Type<T>::value());
+        H5::DataSet map = CreateOrOpenDataSet(parent, map_name, mem_type, H5::DataSpace(2, map_dims));
+        if(not ranges.empty())
+        {
+            map.write(ranges.data(), mem_type);
+        }
+        dataset.createAttribute(HDF5Utils::ZoneMapRowsAttribute, H5::PredType::STD_U64LE, H5::DataSpace())
+               .write(HDF5Utils::HDF5Type<hsize_t>::value(), &block_rows);
+    }
+
+    // Writes the zone map of the numeric element `group/name`, stored in `dataset`.
+    template<typename T>
+    void WriteZoneMap(H5::Group &group, const std::string &name, H5::DataSet &dataset, const T *data, const hsize_t *dims, int ndims,
+                      const HDF5Utils::ElementOptions &options)
+    {
+        size_t row = 1;
+        for(int i = 1; i < ndims; ++i)
+        {
+            row *= dims[i];
+        }
+        const hsize_t block_rows = options.zoneMapRows;
+        std::vector<T> ranges(2 * ((dims[0] + block_rows - 1) / block_rows));
+        const H5::DataType file_type = dataset.getDataType();
+        if(not (file_type == HDF5Utils::HDF5Type<T>::value()))
+        {
+            StoredZoneRanges(data, dims[0], row, block_rows, file_type, ranges.data());
+        }
+        else
+        {
+            ZoneRanges(data, dims[0], row, block_rows, ranges.data());
+        }
+
+        std::string path = group.getObjName();
+        path = (path == "/" ? "" : path) + "/" + name;
+        const hid_t file_id = H5Iget_file_id(group.getId());
+        H5::H5File file(file_id);
+        H5Fclose(file_id);
+        StoreZoneMap(file, path, dataset, ranges, block_rows);
+    }
+
+    template<typename Container>
+    void WriteRectangularData(H5::Group &group, const std::string &name, const Container &data, const hsize_t *dims, int ndims,
+                              const HDF5Utils::ElementOptions &options)
+    {
+        using T = typename Container::value_type;
+        if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            using Scalar = typename HDF5Utils::InnerType<Container>::type;
+            size_t total = 1;
+            for(int i = 0; i < ndims; ++i)
+            {
+                total *= dims[i];
+            }
+            HDF5Utils::Buffer<Scalar> flat;
+            flat.reserve(total);
+            flattenRectangular(data, flat);
+            WriteRectangularData(group, name, flat, dims, ndims, options);
+        }
+        else if constexpr(std::is_same_v<T, std::string>)
+        {
+            if(options.stringEncoding == HDF5Utils::StringEncoding::Dictionary and not options.appendable and
+               WriteDictionaryStrings(group, name, data.data(), data.size(), dims, ndims, options))
+            {
+                return;
+            }
+            H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
+            H5::DSetCreatPropList plist = CreateDataSetProps<T>(strType, dims, ndims, options);
+            H5::DataSpace dataspace = CreateDataSpace(dims, ndims, plist, options);
+            H5::DataSet dataset = CreateOrOpenDataSet(group, name, strType, dataspace, plist);
+            if(not data.empty())
+            {
+                HDF5Utils::Buffer<const char*> cstrs(data.size());
+                for(size_t i = 0; i < data.size(); i++)
+                    cstrs[i] = data[i].c_str();
+                dataset.write(cstrs.data(), strType);
+            }
+        }
+        else
+        {
+            H5::DataType mem_type;
+            if constexpr(HDF5Utils::HasCompType<T>::value)
+            {
+                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
+            }
+            else
+            {
+                mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
+            }
+
+            if constexpr(HDF5Utils::HasCompType<T>::value)
+            {
+                if(options.compoundLayout == HDF5Utils::CompoundLayout::Columnar and not options.appendable)
+                {
+                    WriteColumnarCompound(group, name, data.data(), mem_type, dims, ndims);
+                    return;
+                }
+            }
+
+            if constexpr(std::is_arithmetic_v<T>)
+            {
+                CheckZoneMapOptions<T>(name, options);
+            }
+            H5::DataType file_type = CreateFileType<T>(mem_type, options);
+            H5::DSetCreatPropList plist = CreateDataSetProps<T>(file_type, dims, ndims, options);
+            H5::DataSpace dataspace = CreateDataSpace(dims, ndims, plist, options);
+
+            H5::DataSet dataset = CreateOrOpenDataSet(group, name, file_type, dataspace, plist);
+            if(data.empty())
+            {
+                dataset.write(nullptr, mem_type);
+                if(options.pyramidLevels > 0)
+                {
+                    RemovePyramid(group, name);
+                }
+            }
+            else if constexpr(HDF5Utils::HasCompType<T>::value)
+            {
+                if(options.compoundLayout == HDF5Utils::CompoundLayout::Packed)
+                {
+                    WritePackedCompound(dataset, data.data(), mem_type, file_type, dims, ndims);
+                }
+                else
+                {
+                    dataset.write(data.data(), mem_type);
+                }
+            }
+            else
+            {
+                dataset.write(data.data(), mem_type);
+                if constexpr(std::is_arithmetic_v<T> and not std::is_same_v<T, bool>)
+                {
+                    if(options.pyramidLevels > 0 and not options.appendable and ndims > 0 and not data.empty())
+                    {
+                        WritePyramid(group, name, data.data(), dims, ndims, options);
+                    }
+                    else if(options.pyramidLevels > 0)
+                    {
+                        RemovePyramid(group, name);
+                    }
+                    if(options.zoneMapRows > 0 and not options.appendable and ndims > 0)
+                    {
+                        WriteZoneMap(group, name, dataset, data.data(), dims, ndims, options);
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename Container>
+    bool isRectangular(const Container &data, std::vector<hsize_t> &dims)
+    {
+        using T = typename Container::value_type;
+        dims.clear();
+        if constexpr(not HDF5Utils::IsContainer<T>::value) 
+        {
+            dims.push_back(static_cast<hsize_t>(data.size()));
+            return true;
+        }
+        else
+        {
+            if(data.empty())
+            {
+                dims.assign(static_cast<size_t>(HDF5Utils::Rank<T>::value), 0);
+                return true;
+            }
+            dims.push_back(static_cast<hsize_t>(data.size()));
+            const size_t first = data[0].size();
+            for(size_t i = 1; i < data.size(); ++i)
+            {
+                if(data[i].size() != first)
+                {
+                    return false;
+                }
+            }
+            if constexpr(HDF5Utils::IsContainer<typename T::value_type>::value)
+            {
+                std::vector<hsize_t> inner_dims;
+                if(not isRectangular(data[0], inner_dims))
+                {
+                    return false;
+                }
+                dims.insert(dims.end(), inner_dims.begin(), inner_dims.end());
+                for(size_t i = 1; i < data.size(); ++i) 
+                {
+                    std::vector<hsize_t> row_dims;
+                    if(not isRectangular(data[i], row_dims))
+                    {
+                        return false;
+                    }
+                    if(row_dims != inner_dims)
+                    {
+                        return false;
+                    }
+                }
+            }
+            else
+            {
+                dims.push_back(static_cast<hsize_t>(first));
+            }
+            return true;
+        }
+    }
+
+    // Appends the rows of `data` to an appendable dataset; all dimensions but the first must match.
+    template<typename Container>
+    void AppendRectangularData(H5::DataSet &dataset, const Container &data)
+    {
+        using Scalar = typename HDF5Utils::InnerType<Container>::type;
+        if(data.empty())
+        {
+            return;
+        }
+        std::vector<hsize_t> dims;
+        if(not isRectangular(data, dims))
+        {
+            throw std::runtime_error("HDF5Writer: appended data must be rectangular");
+        }
+
+        H5::DataSpace filespace = dataset.getSpace();
+        const int ndims = filespace.getSimpleExtentNdims();
+        std::vector<hsize_t> current(ndims);
+        std::vector<hsize_t> maxdims(ndims);
+        filespace.getSimpleExtentDims(current.data(), maxdims.data());
+        if(static_cast<size_t>(ndims) != dims.size())
+        {
+            throw std::runtime_error("HDF5Writer: appended data does not match the dataset rank");
+        }
+        std::vector<hsize_t> extended(current);
+        extended[0] += dims[0];
+        for(int i = 1; i < ndims; ++i)
+        {
+            if(current[i] == dims[i])
+            {
+                continue;
+            }
+            if(current[0] != 0 or maxdims[i] != H5S_UNLIMITED)
+            {
+                throw std::runtime_error("HDF5Writer: appended data does not match the dataset shape");
+            }
+            extended[i] = dims[i];
+        }
+
+        dataset.extend(extended.data());
+        filespace = dataset.getSpace();
+        std::vector<hsize_t> start(ndims, 0);
+        start[0] = current[0];
+        filespace.selectHyperslab(H5S_SELECT_SET, dims.data(), start.data());
+        H5::DataSpace memspace(ndims, dims.data());
+
+        HDF5Utils::Buffer<Scalar> flat;
+        const Scalar *values = nullptr;
+        if constexpr(HDF5Utils::IsContainer<typename Container::value_type>::value)
+        {
+            flat.reserve(memspace.getSimpleExtentNpoints());
+            flattenRectangular(data, flat);
+            values = flat.data();
+        }
+        else
+        {
+            values = data.data();
+        }
+
+        if constexpr(std::is_same_v<Scalar, std::string>)
+        {
+            H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
+            HDF5Utils::Buffer<const char*> cstrs(memspace.getSimpleExtentNpoints());
+            for(size_t i = 0; i < cstrs.size(); i++)
+                cstrs[i] = values[i].c_str();
+            dataset.write(cstrs.data(), strType, memspace, filespace);
+        }
+        else
+        {
+            H5::DataType mem_type;
+            if constexpr(HDF5Utils::HasCompType<Scalar>::value)
+                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<Scalar>::get());
+            else
+                mem_type = H5::DataType(HDF5Utils::HDF5Type<Scalar>::value());
+            dataset.write(values, mem_type, memspace, filespace);
+        }
+    }
+
+    template<typename Container>
+    void WriteContainerData(H5::Group &group, const std::string &name, const Container &data, const HDF5Utils::ElementOptions &options)
+    {
+        using T = typename Container::value_type;
+        PrunePyramid<typename HDF5Utils::InnerType<Container>::type>(group, name, options);
+        if constexpr(HDF5Utils::IsContainer<T>::value) 
+        {
+            // high dimension (>= 2)
+            std::vector<hsize_t> dims;
+            if (isRectangular(data, dims))
+            {
+                WriteRectangularData(group, name, data, dims.data(), static_cast<int>(dims.size()), options);
+            }
+            else 
+            {
+                if(options.pyramidLevels > 0)
+                {
+                    RemovePyramid(group, name);
+                }
+                WriteJaggedData(group, name, data);
+            }
+        }
+        else
+        {
+            // flat vector
+            hsize_t dims[] = {static_cast<hsize_t>(data.size())};
+            WriteRectangularData(group, name, data, dims, 1, options);
+        }
+    }
+
+    // True if the dataset `object_id` has the extent `dims`.
+    inline bool SameExtent(hid_t object_id, const hsize_t *dims, int ndims)
+    {
+        if(H5Iget_type(object_id) != H5I_DATASET)
+        {
+            return false;
+        }
+        const hid_t space = H5Dget_space(object_id);
+        std::vector<hsize_t> stored(std::max(0, H5Sget_simple_extent_ndims(space)));
+        H5Sget_simple_extent_dims(space, stored.data(), nullptr);
+        H5Sclose(space);
+        return stored == std::vector<hsize_t>(dims, dims + ndims);
+    }
+
+    // True if the dataset `object_id` holds the values `values` of extent `dims`. Compounds are compared packed, so their
+    // padding does not count; strings must be variable-length.
+    template<typename V>
+    bool StoredValuesEqual(hid_t object_id, const V *values, const hsize_t *dims, int ndims)
+    {
+        if(not SameExtent(object_id, dims, ndims))
+        {
+            return false;
+        }
+        size_t count = 1;
+        for(int i = 0; i < ndims; ++i)
+        {
+            count *= dims[i];
+        }
+        if(count == 0)
+        {
+            return true;
+        }
+        if constexpr(std::is_same_v<V, std::string>)
+        {
+            const hid_t file_type = H5Dget_type(object_id);
+            const bool variable = H5Tget_class(file_type) == H5T_STRING and H5Tis_variable_str(file_type) > 0;
+            H5Tclose(file_type);
+            if(not variable)
+            {
+                return false;
+            }
+            const H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+            std::vector<char*> stored(count, nullptr);
+            if(H5Dread(object_id, str_type.getId(), H5S_ALL, H5S_ALL, H5P_DEFAULT, stored.data()) < 0)
+            {
+                return false;
+            }
+            bool equal = true;
+            for(size_t i = 0; i < count and equal; ++i)
+            {
+                equal = stored[i] and values[i] == stored[i];
+            }
+            const hid_t space = H5Dget_space(object_id);
+            H5Dvlen_reclaim(str_type.getId(), space, H5P_DEFAULT, stored.data());
+            H5Sclose(space);
+            return equal;
+        }
+        else
+        {
+            H5::DataType mem_type;
+            if constexpr(HDF5Utils::HasCompType<V>::value)
+                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<V>::get());
+            else
+                mem_type = H5::DataType(HDF5Utils::HDF5Type<V>::value());
+            const hid_t packed = H5Tcopy(mem_type.getId());
+            H5Tpack(packed);
+            const size_t size = H5Tget_size(packed);
+            std::vector<unsigned char> expected(count * sizeof(V));
+            std::memcpy(expected.data(), values, expected.size());
+            std::vector<unsigned char> stored(count * size);
+            const bool read = H5Tconvert(mem_type.getId(), packed, count, expected.data(), nullptr, H5P_DEFAULT) >= 0 and
+                              H5Dread(object_id, packed, H5S_ALL, H5S_ALL, H5P_DEFAULT, stored.data()) >= 0;
+            H5Tclose(packed);
+            return read and std::memcmp(stored.data(), expected.data(), stored.size()) == 0;
+        }
+    }
+
+    // True if the nested hvl_t arrays `stored` hold the rows of the jagged `data`.
+    template<typename Container>
+    bool StoredRowsEqual(const hvl_t *stored, const Container &data)
+    {
+        for(size_t i = 0; i < data.size(); ++i)
+        {
+            using Row = typename Container::value_type;
+            using R = typename Row::value_type;
+            if(stored[i].len != data[i].size())
+            {
+                return false;
+            }
+            if constexpr(HDF5Utils::IsContainer<R>::value)
+            {
+                if(not StoredRowsEqual(static_cast<const hvl_t*>(stored[i].p), data[i]))
+                {
+                    return false;
+                }
+            }
+            else if(not data[i].empty() and std::memcmp(stored[i].p, data[i].data(), data[i].size() * sizeof(R)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if the object `object_id` holds exactly `data`, as its element would write it. Deduplication only links to an
+    // object whose contents it has compared, as equal hashes do not prove equal contents.
+    template<typename T>
+    bool StoredEquals(hid_t object_id, const T &data)
+    {
+        if constexpr(HDF5Utils::IsView<T>::value)
+        {
+            const auto view = HDF5Utils::ToView(data);
+            using V = typename decltype(view)::value_type;
+            HDF5Utils::Buffer<V> flat(view.Size());
+            GatherView(view, flat.data());
+            return StoredValuesEqual(object_id, flat.data(), view.dims.data(), static_cast<int>(view.dims.size()));
+        }
+        else if constexpr(HDF5Utils::IsSparse<T>::value)
+        {
+            if(H5Iget_type(object_id) != H5I_GROUP)
+            {
+                return false;
+            }
+            const H5::Group sparse(object_id);
+            if(not sparse.attrExists(HDF5Utils::LayoutAttribute) or not sparse.attrExists(HDF5Utils::ShapeAttribute) or
+               not sparse.exists("indices") or not sparse.exists("values"))
+            {
+                return false;
+            }
+            std::string layout;
+            const H5::Attribute layout_attribute = sparse.openAttribute(HDF5Utils::LayoutAttribute);
+            layout_attribute.read(layout_attribute.getStrType(), layout);
+            const H5::Attribute shape_attribute = sparse.openAttribute(HDF5Utils::ShapeAttribute);
+            std::vector<hsize_t> shape(shape_attribute.getSpace().getSimpleExtentNpoints());
+            shape_attribute.read(HDF5Utils::HDF5Type<hsize_t>::value(), shape.data());
+            if(layout != HDF5Utils::SparseLayoutName(data.format) or shape != data.shape)
+            {
+                return false;
+            }
+            const hsize_t rank = data.shape.size();
+            const hsize_t nonzeros[] = {static_cast<hsize_t>(data.values.size()), rank};
+            const bool coo = data.format == HDF5Utils::SparseFormat::COO;
+            if(not coo)
+            {
+                const hsize_t offsets[] = {static_cast<hsize_t>(data.indptr.size())};
+                if(not sparse.exists("indptr") or
+                   not StoredValuesEqual(sparse.openDataSet("indptr").getId(), data.indptr.data(), offsets, 1))
+                {
+                    return false;
+                }
+            }
+            return StoredValuesEqual(sparse.openDataSet("indices").getId(), data.indices.data(), nonzeros, coo ? 2 : 1) and
+                   StoredValuesEqual(sparse.openDataSet("values").getId(), data.values.data(), nonzeros, 1);
+        }
+        else if constexpr(HDF5Utils::IsContainer<T>::value)
+        {
+            using V = typename T::value_type;
+            if constexpr(HDF5Utils::IsContainer<V>::value)
+            {
+                using Scalar = typename HDF5Utils::InnerType<T>::type;
+                std::vector<hsize_t> dims;
+                if(isRectangular(data, dims))
+                {
+                    HDF5Utils::Buffer<Scalar> flat;
+                    flattenRectangular(data, flat);
+                    return StoredValuesEqual(object_id, flat.data(), dims.data(), static_cast<int>(dims.size()));
+                }
+                const hsize_t rows[] = {static_cast<hsize_t>(data.size())};
+                if constexpr(std::is_same_v<Scalar, std::string> or HDF5Utils::HasCompType<Scalar>::value)
+                {
+                    // compared by shape alone
+                    return SameExtent(object_id, rows, 1);
+                }
+                else
+                {
+                    if(not SameExtent(object_id, rows, 1))
+                    {
+                        return false;
+                    }
+                    std::deque<H5::DataType> types;
+                    const H5::DataType &type = CreateVarLenType<V>(types);
+                    HDF5Utils::Buffer<hvl_t> stored(data.size());
+                    if(H5Dread(object_id, type.getId(), H5S_ALL, H5S_ALL, H5P_DEFAULT, stored.data()) < 0)
+                    {
+                        return false;
+                    }
+                    const bool equal = StoredRowsEqual(stored.data(), data);
+                    const hid_t space = H5Dget_space(object_id);
+                    H5Dvlen_reclaim(type.getId(), space, H5P_DEFAULT, stored.data());
+                    H5Sclose(space);
+                    return equal;
+                }
+            }
+            else
+            {
+                const hsize_t dims[] = {static_cast<hsize_t>(data.size())};
+                return StoredValuesEqual(object_id, data.data(), dims, 1);
+            }
+        }
+        else
+        {
+            return StoredValuesEqual(object_id, &data, nullptr, 0);
+        }
+    }
+
+    // Writes a view straight from the caller's memory: contiguous views like a flat container, nesting strides
+    // through a memory hyperslab. Strings, columnar compounds and other strides are gathered into a buffer first.
+    template<typename T>
+    void WriteViewData(H5::Group &group, const std::string &name, const HDF5Utils::StridedView<T> &view,
+                       const HDF5Utils::ElementOptions &options)
+    {
+        if(view.dims.empty())
+        {
+            throw std::runtime_error("HDF5Writer: view needs at least one dimension: " + name);
+        }
+        if(not view.strides.empty() and view.strides.size() != view.dims.size())
+        {
+            throw std::runtime_error("HDF5Writer: view strides do not match its dimensions: " + name);
+        }
+        PrunePyramid<T>(group, name, options);
+        const int ndims = static_cast<int>(view.dims.size());
+        const hsize_t total = view.Size();
+        if(total == 0 or view.IsContiguous())
+        {
+            WriteRectangularData(group, name, FlatSource<T>{view.data, static_cast<size_t>(total)}, view.dims.data(), ndims, options);
+            return;
+        }
+
+        if constexpr(not std::is_same_v<T, std::string>)
+        {
+            bool columnar = false;
+            if constexpr(HDF5Utils::HasCompType<T>::value)
+            {
+                columnar = options.compoundLayout == HDF5Utils::CompoundLayout::Columnar and not options.appendable;
+            }
+            // pyramids and zone maps are computed from contiguous values
+            const bool gather = (options.pyramidLevels > 0 or options.zoneMapRows > 0) and not options.appendable;
+            H5::DataSpace memspace;
+            if(not columnar and not gather and StridedMemorySpace(view.dims, view.ElementStrides(), memspace))
+            {
+                H5::DataType mem_type;
+                if constexpr(HDF5Utils::HasCompType<T>::value)
+                    mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
+                else
+                    mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
+                H5::DataType file_type = CreateFileType<T>(mem_type, options);
+                H5::DSetCreatPropList plist = CreateDataSetProps<T>(file_type, view.dims.data(), ndims, options);
+                H5::DataSpace dataspace = CreateDataSpace(view.dims.data(), ndims, plist, options);
+                H5::DataSet dataset = CreateOrOpenDataSet(group, name, file_type, dataspace, plist);
+                dataset.write(view.data, mem_type, memspace, dataspace);
+                return;
+            }
+        }
+
+        HDF5Utils::Buffer<T> flat(total);
+        GatherView(view, flat.data());
+        WriteRectangularData(group, name, flat, view.dims.data(), ndims, options);
+    }
+
+    // Throws if the index arrays of `data` do not match its format and shape.
+    template<typename T>
+    void CheckSparse(const HDF5Utils::SparseArray<T> &data, const std::string &name)
+    {
+        const auto fail = [&name](const std::string &what)
+        {
+            throw std::runtime_error("HDF5Writer: sparse element " + name + ": " + what);
+        };
+        const size_t nnz = data.values.size();
+        if(data.format == HDF5Utils::SparseFormat::COO)
+        {
+            const size_t rank = data.shape.size();
+            if(rank == 0)
+            {
+                fail("needs at least one dimension");
+            }
+            if(data.indices.size() != nnz * rank)
+            {
+                fail("indices must hold " + std::to_string(rank) + " coordinates per value");
+            }
+            for(size_t i = 0; i < data.indices.size(); ++i)
+            {
+                if(data.indices[i] >= data.shape[i % rank])
+                {
+                    fail("coordinate out of range");
+                }
+            }
+            return;
+        }
+
+        if(data.shape.size() != 2)
+        {
+            fail("CSR and CSC need a shape of two dimensions");
+        }
+        const bool csr = data.format == HDF5Utils::SparseFormat::CSR;
+        const hsize_t major = csr ? data.shape[0] : data.shape[1];
+        const hsize_t minor = csr ? data.shape[1] : data.shape[0];
+        if(data.indptr.size() != major + 1 or data.indptr.front() != 0 or data.indptr.back() != nnz)
+        {
+            fail(std::string("indptr must hold one offset per ") + (csr ? "row" : "column") + " plus one, from 0 to the number of values");
+        }
+        for(size_t i = 1; i < data.indptr.size(); ++i)
+        {
+            if(data.indptr[i] < data.indptr[i - 1])
+            {
+                fail("indptr must not decrease");
+            }
+        }
+        if(data.indices.size() != nnz)
+        {
+            fail("indices must hold one index per value");
+        }
+        for(hsize_t index : data.indices)
+        {
+            if(index >= minor)
+            {
+                fail("index out of range");
+            }
+        }
+    }
+
+    // Narrowest unsigned integer file type for indices up to `bound`.
+    inline H5::PredType SparseIndexType(hsize_t bound)
+    {
+        if(bound <= UINT16_MAX)
+            return H5::PredType::STD_U16LE;
+        if(bound <= UINT32_MAX)
+            return H5::PredType::STD_U32LE;
+        return H5::PredType::STD_U64LE;
+    }
+
+    inline void WriteSparseIndices(H5::Group &group, const std::string &name, const std::vector<hsize_t> &indices,
+                                   const hsize_t *dims, int ndims, hsize_t bound)
+    {
+        const H5::DataSpace dataspace(ndims, dims);
+        H5::DataSet dataset = CreateOrOpenDataSet(group, name, SparseIndexType(bound), dataspace);
+        if(not indices.empty())
+        {
+            dataset.write(indices.data(), HDF5Utils::HDF5Type<hsize_t>::value());
+        }
+    }
+
+    // Writes a sparse element as a group `name` holding its index and value datasets (see `HDF5Utils::SparseArray`).
+    // `options` apply to the values.
+    template<typename T>
+    void WriteSparseData(H5::Group &group, const std::string &name, const HDF5Utils::SparseArray<T> &data,
+                         const HDF5Utils::ElementOptions &options)
+    {
+        static_assert(std::is_arithmetic_v<T> and not std::is_same_v<T, bool>, "HDF5Writer: sparse values must be numeric");
+        CheckSparse(data, name);
+        RemovePyramid(group, name);
+        CheckReplaceable(group.getId(), name);
+        if(group.exists(name) and (group.childObjType(name) != H5O_TYPE_GROUP or GroupLayout(group.openGroup(name)) == HDF5Utils::ColumnarLayout))
+        {
+            H5Ldelete(group.getId(), name.c_str(), H5P_DEFAULT);
+        }
+        H5::Group sparse = group.exists(name) ? group.openGroup(name) : group.createGroup(name);
+
+        // the format and shape may change between incremental dumps
+        for(const char *attribute : {HDF5Utils::LayoutAttribute, HDF5Utils::ShapeAttribute, HDF5Utils::SortedAttribute})
+        {
+            if(sparse.attrExists(attribute))
+            {
+                sparse.removeAttr(attribute);
+            }
+        }
+        const H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+        sparse.createAttribute(HDF5Utils::LayoutAttribute, str_type, H5::DataSpace())
+              .write(str_type, std::string(HDF5Utils::SparseLayoutName(data.format)));
+        const hsize_t rank[] = {static_cast<hsize_t>(data.shape.size())};
+        sparse.createAttribute(HDF5Utils::ShapeAttribute, H5::PredType::STD_U64LE, H5::DataSpace(1, rank))
+              .write(HDF5Utils::HDF5Type<hsize_t>::value(), data.shape.data());
+
+        const hsize_t dims[] = {static_cast<hsize_t>(data.values.size()), rank[0]};
+        if(data.format == HDF5Utils::SparseFormat::COO)
+        {
+            if(sparse.exists("indptr"))
+            {
+                H5Ldelete(sparse.getId(), "indptr", H5P_DEFAULT);
+            }
+            WriteSparseIndices(sparse, "indices", data.indices, dims, 2, *std::max_element(data.shape.begin(), data.shape.end()));
+            bool sorted = true;
+            for(size_t i = rank[0]; i < data.indices.size() and sorted; i += rank[0])
+            {
+                sorted = data.indices[i - rank[0]] <= data.indices[i];
+            }
+            if(sorted)
+            {
+                const uint8_t flag = 1;
+                sparse.createAttribute(HDF5Utils::SortedAttribute, H5::PredType::STD_U8LE, H5::DataSpace())
+                      .write(H5::PredType::NATIVE_UINT8, &flag);
+            }
+        }
+        else
+        {
+            const hsize_t offsets[] = {static_cast<hsize_t>(data.indptr.size())};
+            const hsize_t minor = data.format == HDF5Utils::SparseFormat::CSR ? data.shape[1] : data.shape[0];
+            WriteSparseIndices(sparse, "indptr", data.indptr, offsets, 1, dims[0]);
+            WriteSparseIndices(sparse, "indices", data.indices, dims, 1, minor);
+        }
+        WriteRectangularData(sparse, "values", data.values, dims, 1, options);
+    }
+
+    template<typename T>
+    void WriteScalarData(H5::Group &group, const std::string &name, const T &data, const HDF5Utils::ElementOptions &options)
+    {
+        RemovePyramid(group, name);
+        if constexpr(std::is_same_v<T, std::string>)
+        {
+            H5::StrType strType(H5::PredType::C_S1, H5T_VARIABLE);
+            H5::DataSpace dataspace;
+            H5::DataSet dataset = CreateOrOpenDataSet(group, name, strType, dataspace);
+            const char *cstr = data.c_str();
+            dataset.write(&cstr, strType);
+        }
+        else
+        {
+            H5::DataSpace dataspace;
+            H5::DataType mem_type;
+            if constexpr(HDF5Utils::HasCompType<T>::value)
+                mem_type = H5::DataType(HDF5Utils::CompTypeCreator<T>::get());
+            else
+                mem_type = H5::DataType(HDF5Utils::HDF5Type<T>::value());
+            H5::DataType file_type = mem_type;
+            if constexpr(not HDF5Utils::HasCompType<T>::value)
+                file_type = CreateFileType<T>(mem_type, options);
+            H5::DataSet dataset = CreateOrOpenDataSet(group, name, file_type, dataspace);
             dataset.write(&data, mem_type);
         }
     }
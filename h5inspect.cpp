@@ -0,0 +1,373 @@
+// Prints the structure of an HDF5 file (groups, links, dataset types, shapes, layout, chunking, filters, sizes)
+// without reading any data, with optional sampled previews and streaming statistics of the datasets.
+//
+//   h5inspect [--head N] [--tail N] [--stride K] [--limit M] [--stats] file.h5 [path]
+
+#include <H5Cpp.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "HDF5Reader.hpp"
+
+namespace
+{
+    struct Settings
+    {
+        hsize_t head = 0;
+        hsize_t tail = 0;
+        hsize_t stride = 0;
+        hsize_t limit = 10;    // rows shown by a strided preview
+        bool stats = false;
+    };
+
+    // Values of one row shown before eliding the rest.
+    constexpr size_t RowValues = 8;
+
+    // Elements read per block by the statistics pass.
+    constexpr size_t StatsBlockElements = size_t(1) << 20;
+
+    std::string FormatBytes(hsize_t bytes)
+    {
+        const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+        double value = static_cast<double>(bytes);
+        int unit = 0;
+        while(value >= 1024.0 and unit < 4)
+        {
+            value /= 1024.0;
+            ++unit;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+        return text;
+    }
+
+    std::string FormatDims(const std::vector<hsize_t> &dims)
+    {
+        if(dims.empty())
+        {
+            return "scalar";
+        }
+        std::string text = "[";
+        for(size_t i = 0; i < dims.size(); ++i)
+        {
+            text += (i > 0 ? " x " : "") + std::to_string(dims[i]);
+        }
+        return text + "]";
+    }
+
+    std::string JoinPath(const std::string &group, const std::string &name)
+    {
+        return group == "/" ? "/" + name : group + "/" + name;
+    }
+
+    template<typename T>
+    void PrintValue(const T &value)
+    {
+        if constexpr(std::is_same_v<T, std::string>)
+        {
+            std::cout << '"' << value << '"';
+        }
+        else
+        {
+            std::cout << value;
+        }
+    }
+
+    // Prints rows [first, first + rows * stride) of `path`, one line per row.
+    template<typename T>
+    void PrintRows(const HDF5Reader &reader, const std::string &path, const std::string &indent,
+                   hsize_t first, hsize_t rows, hsize_t stride)
+    {
+        std::vector<T> values;
+        reader.ReadRows(path, first, rows, values, stride);
+        const size_t perRow = rows == 0 ? 0 : values.size() / rows;
+        for(hsize_t r = 0; r < rows; ++r)
+        {
+            std::cout << indent << "  [" << first + r * stride << "] ";
+            for(size_t i = 0; i < perRow and i < RowValues; ++i)
+            {
+                if(i > 0)
+                {
+                    std::cout << ", ";
+                }
+                PrintValue(values[r * perRow + i]);
+            }
+            if(perRow > RowValues)
+            {
+                std::cout << ", ... (" << perRow << " values)";
+            }
+            std::cout << '\n';
+        }
+    }
+
+    void PrintPreview(const HDF5Reader &reader, const std::string &path, const HDF5Utils::ObjectInfo &info,
+                      const Settings &settings, const std::string &indent)
+    {
+        const hsize_t available = info.dims.empty() ? 1 : info.dims[0];
+        auto print = [&](hsize_t first, hsize_t rows, hsize_t stride)
+        {
+            if(info.typeClass == H5T_STRING or info.typeClass == H5T_ENUM)
+                PrintRows<std::string>(reader, path, indent, first, rows, stride);
+            else
+                PrintRows<double>(reader, path, indent, first, rows, stride);
+        };
+        if(info.typeClass != H5T_INTEGER and info.typeClass != H5T_FLOAT and info.typeClass != H5T_STRING and
+           info.typeClass != H5T_ENUM)
+        {
+            std::cout << indent << "  (no preview for " << info.typeName << ")\n";
+            return;
+        }
+        if(settings.head > 0)
+        {
+            print(0, std::min(settings.head, available), 1);
+        }
+        if(settings.tail > 0)
+        {
+            const hsize_t rows = std::min(settings.tail, available);
+            // do not repeat rows already shown by --head
+            const hsize_t first = std::max(available - rows, std::min(settings.head, available));
+            if(settings.head > 0 and first > std::min(settings.head, available))
+            {
+                std::cout << indent << "  ...\n";
+            }
+            print(first, available - first, 1);
+        }
+        if(settings.stride > 0)
+        {
+            const hsize_t rows = std::min(settings.limit, (available + settings.stride - 1) / settings.stride);
+            std::cout << indent << "  every " << settings.stride << " rows:\n";
+            print(0, rows, settings.stride);
+        }
+    }
+
+    // One pass over the dataset in blocks of rows, merging per-block moments (Chan et al.).
+    void PrintStats(const HDF5Reader &reader, const std::string &path, const HDF5Utils::ObjectInfo &info,
+                    const std::string &indent)
+    {
+        if(info.typeClass != H5T_INTEGER and info.typeClass != H5T_FLOAT)
+        {
+            return;
+        }
+        const hsize_t available = info.dims.empty() ? 1 : info.dims[0];
+        size_t perRow = 1;
+        for(size_t i = 1; i < info.dims.size(); ++i)
+        {
+            perRow *= info.dims[i];
+        }
+        if(perRow == 0)
+        {
+            return;
+        }
+        const hsize_t blockRows = std::max<hsize_t>(1, StatsBlockElements / perRow);
+
+        double count = 0.0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        double minimum = std::numeric_limits<double>::infinity();
+        double maximum = -std::numeric_limits<double>::infinity();
+        size_t nans = 0;
+        std::vector<double> values;
+        for(hsize_t first = 0; first < available; first += blockRows)
+        {
+            reader.ReadRows(path, first, std::min(blockRows, available - first), values);
+            double blockCount = 0.0;
+            double blockSum = 0.0;
+            for(double v : values)
+            {
+                if(std::isnan(v))
+                {
+                    ++nans;
+                    continue;
+                }
+                minimum = std::min(minimum, v);
+                maximum = std::max(maximum, v);
+                blockSum += v;
+                blockCount += 1.0;
+            }
+            if(blockCount == 0.0)
+            {
+                continue;
+            }
+            const double blockMean = blockSum / blockCount;
+            double blockM2 = 0.0;
+            for(double v : values)
+            {
+                if(not std::isnan(v))
+                {
+                    blockM2 += (v - blockMean) * (v - blockMean);
+                }
+            }
+            const double delta = blockMean - mean;
+            const double total = count + blockCount;
+            mean += delta * blockCount / total;
+            m2 += blockM2 + delta * delta * count * blockCount / total;
+            count = total;
+        }
+
+        std::cout << indent << "  count " << static_cast<size_t>(count);
+        if(count > 0.0)
+        {
+            std::cout << "  min " << minimum << "  max " << maximum << "  mean " << mean
+                      << "  std " << std::sqrt(m2 / count);
+        }
+        if(nans > 0)
+        {
+            std::cout << "  nan " << nans;
+        }
+        std::cout << '\n';
+    }
+
+    void PrintDataSet(const HDF5Utils::ObjectInfo &info)
+    {
+        std::cout << "  " << info.typeName << ' ' << FormatDims(info.dims);
+        if(info.maxDims != info.dims)
+        {
+            std::cout << " (resizable)";
+        }
+        std::cout << "  " << info.layout;
+        if(not info.chunkDims.empty())
+        {
+            std::cout << ' ' << FormatDims(info.chunkDims);
+        }
+        for(const std::string &filter : info.filters)
+        {
+            std::cout << ' ' << filter;
+        }
+        std::cout << "  stored " << FormatBytes(info.storageSize);
+        if(info.rawSize == 0 and info.storageSize > 0)
+        {
+            std::cout << " (variable-length)";
+        }
+        else if(info.rawSize != info.storageSize)
+        {
+            std::cout << " / raw " << FormatBytes(info.rawSize);
+            if(info.storageSize > 0)
+            {
+                char ratio[32];
+                std::snprintf(ratio, sizeof(ratio), " (x%.2f)", static_cast<double>(info.rawSize) / info.storageSize);
+                std::cout << ratio;
+            }
+        }
+        if(info.attributes > 0)
+        {
+            std::cout << "  " << info.attributes << " attribute" << (info.attributes > 1 ? "s" : "");
+        }
+        std::cout << '\n';
+    }
+
+    void Inspect(const HDF5Reader &reader, const std::string &path, const std::string &name, int depth,
+                 const Settings &settings)
+    {
+        const std::string indent(2 * depth, ' ');
+        const HDF5Utils::ObjectInfo info = reader.Info(path);
+        std::cout << indent << name;
+        if(info.link != H5L_TYPE_HARD)
+        {
+            std::cout << " -> " << info.linkTarget;
+        }
+
+        switch(info.type)
+        {
+            case H5O_TYPE_GROUP:
+            {
+                std::cout << (name == "/" ? "" : "/");
+                if(info.attributes > 0)
+                {
+                    std::cout << "  " << info.attributes << " attribute" << (info.attributes > 1 ? "s" : "");
+                }
+                std::cout << '\n';
+                // linked groups may point back up the tree; they are listed but not entered
+                if(info.link != H5L_TYPE_HARD)
+                {
+                    break;
+                }
+                for(const std::string &child : reader.ReadGroupNames(path))
+                {
+                    Inspect(reader, JoinPath(path, child), child, depth + 1, settings);
+                }
+                break;
+            }
+            case H5O_TYPE_DATASET:
+                PrintDataSet(info);
+                PrintPreview(reader, path, info, settings, indent);
+                if(settings.stats)
+                {
+                    PrintStats(reader, path, info, indent);
+                }
+                break;
+            case H5O_TYPE_NAMED_DATATYPE:
+                std::cout << "  (named datatype)\n";
+                break;
+            default:
+                std::cout << "  (dangling link)\n";
+                break;
+        }
+    }
+
+    void Usage(const char *program)
+    {
+        std::cerr << "usage: " << program << " [--head N] [--tail N] [--stride K] [--limit M] [--stats] file.h5 [path]\n"
+                  << "  --head N    show the first N rows of every dataset\n"
+                  << "  --tail N    show the last N rows of every dataset\n"
+                  << "  --stride K  show every K-th row, at most --limit rows (default 10)\n"
+                  << "  --stats     count, min, max, mean and standard deviation of numeric datasets\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto count = [&]() -> hsize_t
+        {
+            if(i + 1 >= argc)
+            {
+                Usage(argv[0]);
+                std::exit(2);
+            }
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if(arg == "--head") settings.head = count();
+        else if(arg == "--tail") settings.tail = count();
+        else if(arg == "--stride") settings.stride = count();
+        else if(arg == "--limit") settings.limit = count();
+        else if(arg == "--stats") settings.stats = true;
+        else if(arg == "-h" or arg == "--help")
+        {
+            Usage(argv[0]);
+            return 0;
+        }
+        else positional.push_back(arg);
+    }
+    if(positional.empty() or positional.size() > 2)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    H5::Exception::dontPrint();
+    try
+    {
+        const HDF5Reader reader(positional[0]);
+        const std::string path = positional.size() > 1 ? positional[1] : "/";
+        Inspect(reader, path, path, 0, settings);
+    }
+    catch(const H5::Exception &e)
+    {
+        std::cerr << "h5inspect: " << e.getDetailMsg() << '\n';
+        return 1;
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << "h5inspect: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef TESTUTILS_HPP
+#define TESTUTILS_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Stops the test with the failed expression and its location.
+#define CHECK(expr)                                                                    \
+    do                                                                                 \
+    {                                                                                  \
+        if(not (expr))                                                                 \
+        {                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr); \
+            std::exit(1);                                                              \
+        }                                                                              \
+    } while(0)
+
+// Checks that `stmt` throws an exception of type `type`.
+#define CHECK_THROWS(stmt, type)                                                       \
+    do                                                                                 \
+    {                                                                                  \
+        bool thrown = false;                                                           \
+        try                                                                            \
+        {                                                                              \
+            stmt;                                                                      \
+        }                                                                              \
+        catch(const type &)                                                            \
+        {                                                                              \
+            thrown = true;                                                             \
+        }                                                                              \
+        if(not thrown)                                                                 \
+        {                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK_THROWS failed: %s\n", __FILE__, __LINE__, #stmt); \
+            std::exit(1);                                                              \
+        }                                                                              \
+    } while(0)
+
+namespace TestUtils
+{
+    // Path of a scratch file in the directory run_tests.sh gives the tests (TEST_TMPDIR), or in /tmp.
+    inline std::string TempPath(const std::string &name)
+    {
+        const char *directory = std::getenv("TEST_TMPDIR");
+        return std::string(directory ? directory : "/tmp") + "/" + name;
+    }
+}
+
+#endif // TESTUTILS_HPP
@@ -0,0 +1,43 @@
+#!/bin/sh
+# Builds the library sources and h5inspect with h5c++, then builds every tests/test_*.cpp against them and runs it.
+# Usage: tests/run_tests.sh [test names...]   (CXX and CXXFLAGS override the compiler and flags)
+set -u
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD=${BUILD_DIR:-$ROOT/tests/build}
+CXX=${CXX:-h5c++}
+CXXFLAGS=${CXXFLAGS:--std=c++20 -O1 -g -Wall -Wextra}
+mkdir -p "$BUILD/tmp"
+
+for source in "$ROOT"/*.cpp; do
+    name=$(basename "$source" .cpp)
+    if [ ! -f "$BUILD/$name.o" ] || [ "$source" -nt "$BUILD/$name.o" ] || [ -n "$(find "$ROOT" -maxdepth 1 -name '*.hpp' -newer "$BUILD/$name.o")" ]; then
+        $CXX $CXXFLAGS -I"$ROOT" -c "$source" -o "$BUILD/$name.o" || exit 1
+    fi
+done
+# the tool the tests run as ./h5inspect
+$CXX $CXXFLAGS "$BUILD/h5inspect.o" "$BUILD"/HDF5*.o -o "$BUILD/h5inspect" -lpthread || exit 1
+
+if [ $# -gt 0 ]; then
+    tests=$*
+else
+    tests=$(cd "$ROOT/tests" && ls test_*.cpp | sed 's/\.cpp$//')
+fi
+
+failed=0
+for test in $tests; do
+    if ! { $CXX $CXXFLAGS -I"$ROOT" -c "$ROOT/tests/$test.cpp" -o "$BUILD/$test.o" &&
+           $CXX $CXXFLAGS "$BUILD/$test.o" "$BUILD"/HDF5*.o -o "$BUILD/$test" -lpthread; }; then
+        echo "BUILD FAILED $test"
+        failed=$((failed + 1))
+        continue
+    fi
+    if (cd "$BUILD" && TEST_TMPDIR="$BUILD/tmp" "./$test"); then
+        echo "PASSED $test"
+    else
+        echo "FAILED $test"
+        failed=$((failed + 1))
+    fi
+done
+
+[ $failed -eq 0 ] || { echo "$failed test(s) failed"; exit 1; }
@@ -0,0 +1,150 @@
+// WriteBlocks() and WriteRange(): elements produced block by block, serially or pipelined, read back equal to the values
+// the producer made, with blocks that respect chunks and zone map blocks.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Particle
+    {
+        double x;
+        int id;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Particle));
+            type.insertMember("x", HOFFSET(Particle, x), H5::PredType::NATIVE_DOUBLE);
+            type.insertMember("id", HOFFSET(Particle, id), H5::PredType::NATIVE_INT);
+            return type;
+        }
+    };
+
+    void Iota(hsize_t first, hsize_t rows, double *values)
+    {
+        for(hsize_t i = 0; i < rows; ++i)
+        {
+            values[i] = static_cast<double>(first + i);
+        }
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("block_writes.h5");
+    const hsize_t n = 2000000;
+    {
+        HDF5Writer writer(filename);
+        HDF5Utils::BlockWriteOptions one_mib;
+        one_mib.blockBytes = 1 << 20;
+        size_t calls = 0;
+        hsize_t next = 0;
+        writer.WriteBlocks<double>("/serial", {n}, [&](hsize_t first, hsize_t rows, double *values)
+        {
+            // blocks come in order and fill the buffer
+            CHECK(first == next and (rows == (1 << 17) or first + rows == n));
+            next = first + rows;
+            ++calls;
+            Iota(first, rows, values);
+        }, HDF5Utils::ElementOptions(), one_mib);
+        CHECK(calls == (n + (1 << 17) - 1) / (1 << 17));
+
+        HDF5Utils::BlockWriteOptions pipelined = one_mib;
+        pipelined.pipelined = true;
+        writer.WriteBlocks<double>("/pipelined", {n}, Iota, HDF5Utils::ElementOptions(), pipelined);
+
+        // blocks of whole chunks, through a filter
+        HDF5Utils::ElementOptions chunked;
+        chunked.scaleOffset = 0;
+        chunked.chunkRows = 7;
+        HDF5Utils::BlockWriteOptions tiny;
+        tiny.blockBytes = 100;
+        writer.WriteBlocks<int>("/g/matrix", {50, 3}, [](hsize_t first, hsize_t rows, int *values)
+        {
+            CHECK(first % 7 == 0 and (rows % 7 == 0 or first + rows == 50));
+            for(hsize_t i = 0; i < rows * 3; ++i)
+            {
+                values[i] = static_cast<int>(first * 3 + i);
+            }
+        }, chunked, tiny);
+        writer.WriteBlocks<Particle>("/particles", {1000}, [](hsize_t first, hsize_t rows, Particle *values)
+        {
+            for(hsize_t i = 0; i < rows; ++i)
+            {
+                values[i] = Particle{(first + i) / 2.0, static_cast<int>(first + i)};
+            }
+        }, HDF5Utils::ElementOptions(), tiny);
+
+        // blocks of whole zone map blocks
+        HDF5Utils::ElementOptions zone_map;
+        zone_map.zoneMapRows = 1000;
+        HDF5Utils::BlockWriteOptions small_pipelined;
+        small_pipelined.blockBytes = 64 << 10;
+        small_pipelined.pipelined = true;
+        writer.WriteBlocks<float>("/zones", {100000}, [](hsize_t first, hsize_t rows, float *values)
+        {
+            CHECK(first % 1000 == 0 and rows % 1000 == 0);
+            for(hsize_t i = 0; i < rows; ++i)
+            {
+                values[i] = static_cast<float>(first + i);
+            }
+        }, zone_map, small_pipelined);
+
+        writer.WriteBlocks<float>("/empty", {0, 4}, [](hsize_t, hsize_t, float *)
+        {
+            CHECK(false);
+        });
+        // a producer's exception reaches the caller, also from the pipeline
+        for(const bool pipeline : {false, true})
+        {
+            HDF5Utils::BlockWriteOptions failing = small_pipelined;
+            failing.pipelined = pipeline;
+            CHECK_THROWS(writer.WriteBlocks<float>("/failed", {100000}, [](hsize_t first, hsize_t, float *)
+            {
+                if(first > 0)
+                {
+                    throw std::runtime_error("producer failed");
+                }
+            }, HDF5Utils::ElementOptions(), failing), std::runtime_error);
+        }
+        CHECK_THROWS(writer.WriteBlocks<double>("/scalar", {}, Iota), std::runtime_error);
+#if HDF5UTILS_HAS_RANGES
+        writer.WriteRange("/range", {1000, 10}, std::views::iota(0) | std::views::transform([](int i) { return i * 2.0; }),
+                          HDF5Utils::ElementOptions(), tiny);
+        const std::vector<int> too_short(10);
+        CHECK_THROWS(writer.WriteRange("/short", {11}, too_short), std::runtime_error);
+#endif
+    }
+
+    HDF5Reader reader(filename);
+    std::vector<double> values;
+    for(const char *path : {"/serial", "/pipelined"})
+    {
+        reader.ReadElement(path, values);
+        CHECK(values.size() == n);
+        for(hsize_t i = 0; i < n; ++i)
+        {
+            CHECK(values[i] == i);
+        }
+    }
+    std::vector<std::vector<int>> matrix;
+    reader.ReadElement("/g/matrix", matrix);
+    CHECK(matrix.size() == 50 and matrix[10][1] == 31 and matrix[49][2] == 149);
+    CHECK(not reader.Info("/g/matrix").filters.empty());
+    std::vector<Particle> particles;
+    reader.ReadElement("/particles", particles);
+    CHECK(particles.size() == 1000 and particles[999].id == 999 and particles[999].x == 499.5);
+
+    std::vector<float> floats;
+    std::vector<hsize_t> indices;
+    const HDF5Utils::ScanStats stats = reader.ReadWhere("/zones", HDF5Utils::ValueRange<float>::Between(5000, 5001), floats, indices);
+    CHECK(stats.zoneMap and stats.blocks == 100 and stats.blocksRead == 1 and floats.size() == 2 and indices[0] == 5000);
+    reader.ReadElement("/empty", floats);
+    CHECK(floats.empty());
+#if HDF5UTILS_HAS_RANGES
+    std::vector<std::vector<double>> rows;
+    reader.ReadElement("/range", rows);
+    CHECK(rows.size() == 1000 and rows[999][9] == 19998.0);
+#endif
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Catalogs: a reader answering Exists() and ReadGroupNames() from the stored catalog agrees with one walking the file, and
+// rewriting the catalog at every Dump() does not grow the file.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <filesystem>
+
+using HDF5Utils::CatalogMode;
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("catalog.h5");
+    const std::string external = TestUtils::TempPath("catalog_external.h5");
+    const std::vector<double> x{1.0, 2.0, 3.0};
+    const std::vector<double> big(2000, 1.0);
+    const std::vector<double> none;
+    {
+        HDF5Utils::WriterOptions options;
+        options.catalog = true;
+        HDF5Writer writer(filename, options);
+        writer.AddElement("/a/x", x);
+        writer.AddElement("/a/b/big", big);
+        writer.AddElement("/c/big", big);
+        writer.AddElement("/empty/none", none);
+        writer.Dump();
+    }
+    {
+        HDF5Writer writer(external);
+        writer.WriteElement("/t/y", x);
+    }
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        options.catalog = true;
+        HDF5Writer writer(filename, options);
+        writer.AddExternalLink("catalog_external.h5", "/t", "/ext");
+        writer.Dump();
+    }
+    // changed by hand, then cataloged again by reopening with a catalog
+    {
+        H5::H5File file(filename, H5F_ACC_RDWR);
+        H5Lcreate_soft("/a", file.getId(), "/soft", H5P_DEFAULT, H5P_DEFAULT);
+        H5Gclose(H5Gcreate2(file.getId(), "/emptygroup", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT));
+    }
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        options.catalog = true;
+        HDF5Writer writer(filename, options);
+        writer.Dump();
+    }
+
+    const std::vector<std::string> paths{"/", "a", "/a", "/a/", "/a/x", "/a/b", "/a/b/big", "/c/big", "/ext", "/ext/y", "/ext/z",
+                                         "/soft", "/soft/x", "/soft/nothing", "/nothing", "/nothing/deeper", "/empty/none",
+                                         "/emptygroup"};
+    const std::vector<std::string> groups{"/", "/a", "/a/b", "/ext", "/soft", "/emptygroup"};
+    HDF5Reader walking(filename);
+    for(const CatalogMode mode : {CatalogMode::Lazy, CatalogMode::Eager})
+    {
+        HDF5Utils::ReaderOptions options;
+        options.catalog = mode;
+        HDF5Reader reader(filename, options);
+        for(const std::string &path : paths)
+        {
+            CHECK(reader.Exists(path) == walking.Exists(path));
+        }
+        for(const std::string &group : groups)
+        {
+            CHECK(reader.ReadGroupNames(group) == walking.ReadGroupNames(group));
+        }
+        CHECK_THROWS(reader.ReadGroupNames("/nothing"), std::runtime_error);
+        const HDF5Utils::CatalogEntry *entry = reader.Catalog().Find("/a/b/big");
+        CHECK(entry and entry->type == H5O_TYPE_DATASET and entry->dims == std::vector<hsize_t>{2000});
+        CHECK(entry->typeName == "float64" and entry->layout == "contiguous");
+        CHECK(reader.Catalog().Find("/ext")->link == H5L_TYPE_EXTERNAL and reader.Catalog().Find("/soft")->link == H5L_TYPE_SOFT);
+    }
+
+    // built from the file when none is stored
+    {
+        HDF5Utils::ReaderOptions options;
+        options.catalog = CatalogMode::Lazy;
+        HDF5Reader reader(external, options);
+        CHECK(reader.Exists("/t/y") and not reader.Exists("/t/z") and reader.ReadGroupNames("/t").size() == 1);
+    }
+
+    // incremental dumps rewrite the catalog in place
+    const std::string incremental = TestUtils::TempPath("catalog_incremental.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.catalog = true;
+        options.incremental = true;
+        std::vector<double> scalars(1000, 0.0);
+        std::vector<double> changing(10, 0.0);
+        HDF5Writer writer(incremental, options);
+        for(int k = 0; k < 1000; ++k)
+        {
+            writer.AddElement("/g" + std::to_string(k % 10) + "/d" + std::to_string(k), scalars[k]);
+        }
+        writer.AddElement("/changing", changing);
+        writer.Dump();
+        const auto size = std::filesystem::file_size(incremental);
+        for(int i = 1; i <= 50; ++i)
+        {
+            changing[0] = i;
+            if(i == 25)
+            {
+                writer.AddElement("/late", changing);
+            }
+            writer.Dump();
+        }
+        // one more element and catalog record, not 50 catalogs
+        CHECK(std::filesystem::file_size(incremental) < size + 64 * 1024);
+    }
+    HDF5Utils::ReaderOptions options;
+    options.catalog = CatalogMode::Eager;
+    HDF5Reader reader(incremental, options);
+    CHECK(reader.Exists("/late") and reader.Exists("/g9/d999") and not reader.Exists("/g9/d998"));
+    CHECK(reader.ReadGroupNames("/g3").size() == 100 and reader.ReadGroupNames("/").size() == 12);
+    std::vector<double> values;
+    reader.ReadElement("/changing", values);
+    CHECK(values[0] == 50.0);
+
+    // writes outside Dump() are never hidden by a stale catalog, before and after Close() rewrites it
+    const std::string late = TestUtils::TempPath("catalog_late.h5");
+    {
+        HDF5Utils::WriterOptions writer_options;
+        writer_options.catalog = true;
+        writer_options.incremental = true;
+        HDF5Writer writer(late, writer_options);
+        writer.AddElement("/x", x);
+        writer.Dump();
+        writer.WriteElement("/late", x);
+        writer.WriteBlocks<double>("/blocks", {10}, [](hsize_t first, hsize_t rows, double *out)
+        {
+            std::fill(out, out + rows, static_cast<double>(first));
+        });
+        {
+            HDF5Reader open_reader(late, options);
+            CHECK(open_reader.Exists("/x") and open_reader.Exists("/late") and open_reader.Exists("/blocks"));
+        }
+    }
+    {
+        HDF5Reader closed_reader(late, options);
+        CHECK(closed_reader.Exists("/late") and closed_reader.Exists("/blocks"));
+        CHECK(closed_reader.ReadGroupNames("/") == HDF5Reader(late).ReadGroupNames("/"));
+    }
+    // reopening rewrites the catalog in place instead of leaking it
+    const auto late_size = std::filesystem::file_size(late);
+    for(int i = 0; i < 20; ++i)
+    {
+        HDF5Utils::WriterOptions writer_options;
+        writer_options.catalog = true;
+        writer_options.truncate = false;
+        HDF5Writer writer(late, writer_options);
+    }
+    CHECK(std::filesystem::file_size(late) < late_size + 16 * 1024);
+    {
+        HDF5Utils::WriterOptions writer_options;
+        writer_options.truncate = false;
+        HDF5Writer writer(late, writer_options);
+        writer.WriteElement("/plain", x);
+    }
+    CHECK(HDF5Reader(late, options).Exists("/plain"));
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Columnar compounds round-trip, ReadFields() projects members from both layouts, an incremental dump can switch layouts, and only
+// groups marked columnar are read or reused as columns.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Inner
+    {
+        int a;
+        char b;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Inner));
+            type.insertMember("a", HOFFSET(Inner, a), H5::PredType::NATIVE_INT);
+            type.insertMember("b", HOFFSET(Inner, b), H5::PredType::NATIVE_CHAR);
+            return type;
+        }
+    };
+
+    struct Particle
+    {
+        double x;
+        double vx;
+        double f[3];
+        int id;
+        Inner inner;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Particle));
+            type.insertMember("x", HOFFSET(Particle, x), H5::PredType::NATIVE_DOUBLE);
+            type.insertMember("vx", HOFFSET(Particle, vx), H5::PredType::NATIVE_DOUBLE);
+            for(int i = 0; i < 3; ++i)
+            {
+                type.insertMember("f" + std::to_string(i), HOFFSET(Particle, f) + i * sizeof(double), H5::PredType::NATIVE_DOUBLE);
+            }
+            type.insertMember("id", HOFFSET(Particle, id), H5::PredType::NATIVE_INT);
+            type.insertMember("inner", HOFFSET(Particle, inner), Inner::CreateHDF5CompType());
+            return type;
+        }
+
+        bool operator==(const Particle &other) const
+        {
+            return x == other.x and vx == other.vx and f[0] == other.f[0] and f[1] == other.f[1] and f[2] == other.f[2] and
+                   id == other.id and inner.a == other.inner.a and inner.b == other.inner.b;
+        }
+    };
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("columnar_compound.h5");
+    std::vector<Particle> particles(100000);
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        const int n = static_cast<int>(i);
+        particles[i] = Particle{double(i), -double(i), {0.0, 2.0 * i, 0.5}, n, {n, 'q'}};
+    }
+    std::vector<std::vector<Particle>> grid(10, std::vector<Particle>(3));
+    for(int i = 0; i < 10; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            grid[i][j] = Particle{0.0, 0.0, {0.0, 0.0, 0.0}, i * 3 + j, {0, 'g'}};
+        }
+    }
+    const std::vector<Particle> empty;
+
+    HDF5Utils::ElementOptions columnar;
+    columnar.compoundLayout = HDF5Utils::CompoundLayout::Columnar;
+    {
+        HDF5Writer writer(filename);
+        writer.AddElement("row", particles);
+        writer.AddElement("col", particles, columnar);
+        writer.AddElement("grid", grid, columnar);
+        writer.AddElement("empty", empty, columnar);
+        writer.Dump();
+    }
+
+    {
+        HDF5Reader reader(filename);
+        CHECK(reader.Info("col").type == H5O_TYPE_GROUP);
+        for(const char *path : {"row", "col"})
+        {
+            std::vector<Particle> read;
+            reader.ReadElement(path, read);
+            CHECK(read == particles);
+
+            // members not listed keep their values; new records are value-initialized
+            std::vector<Particle> projected;
+            reader.ReadFields(path, {"x", "vx"}, projected);
+            CHECK(projected.size() == particles.size());
+            CHECK(projected[77].x == 77.0 and projected[77].vx == -77.0 and projected[77].id == 0 and projected[77].f[1] == 0.0);
+            reader.ReadFields(path, {"inner", "f1"}, projected);
+            CHECK(projected[77].x == 77.0 and projected[77].inner.a == 77 and projected[77].inner.b == 'q' and projected[77].f[1] == 154.0);
+
+            CHECK_THROWS(reader.ReadFields(path, {"missing"}, projected), std::runtime_error);
+        }
+        std::vector<std::vector<Particle>> grid_read;
+        reader.ReadElement("grid", grid_read);
+        CHECK(grid_read == grid);
+        reader.ReadFields("grid", {"id"}, grid_read);
+        CHECK(grid_read[9][2].id == 29);
+        std::vector<Particle> empty_read;
+        reader.ReadElement("empty", empty_read);
+        CHECK(empty_read.empty());
+    }
+
+    // an incremental dump replaces a dataset with a columnar group and back
+    {
+        HDF5Utils::WriterOptions options;
+        options.incremental = true;
+        options.truncate = false;
+        HDF5Writer writer(filename, options);
+        writer.AddElement("row", particles, columnar);
+        writer.AddElement("col", particles);
+        writer.Dump();
+    }
+    {
+        HDF5Reader reader(filename);
+        CHECK(reader.Info("row").type == H5O_TYPE_GROUP and reader.Info("col").type == H5O_TYPE_DATASET);
+        std::vector<Particle> read;
+        reader.ReadElement("row", read);
+        CHECK(read == particles);
+        reader.ReadElement("col", read);
+        CHECK(read == particles);
+    }
+
+    // a sparse group is neither read as columns nor reused for them
+    {
+        HDF5Utils::SparseArray<double> sparse;
+        sparse.shape = {2, 2};
+        sparse.indptr = {0, 1, 1};
+        sparse.indices = {1};
+        sparse.values = {2.0};
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        HDF5Writer writer(filename, options);
+        writer.WriteElement("sparse", sparse);
+        writer.WriteElement("to_columns", sparse);
+        writer.WriteElement("to_columns", particles, columnar);
+    }
+    HDF5Reader reader(filename);
+    std::vector<Particle> read;
+    CHECK_THROWS(reader.ReadElement("sparse", read), std::runtime_error);
+    reader.ReadElement("to_columns", read);
+    CHECK(read == particles);
+    std::string layout;
+    H5::H5File file(filename, H5F_ACC_RDONLY);
+    const H5::Attribute attribute = file.openGroup("to_columns").openAttribute(HDF5Utils::LayoutAttribute);
+    attribute.read(attribute.getStrType(), layout);
+    CHECK(layout == HDF5Utils::ColumnarLayout and not file.openGroup("to_columns").exists("indptr"));
+    return 0;
+}
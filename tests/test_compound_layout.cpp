@@ -0,0 +1,99 @@
+// Packed and native compound layouts round-trip, including nested members and data larger than one repacking block.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Inner
+    {
+        char c;
+        double d;
+    };
+
+    struct Particle
+    {
+        double x;
+        int id;
+        float v[3];
+        Inner inner;
+        short s;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType inner(sizeof(Inner));
+            inner.insertMember("c", HOFFSET(Inner, c), H5::PredType::NATIVE_CHAR);
+            inner.insertMember("d", HOFFSET(Inner, d), H5::PredType::NATIVE_DOUBLE);
+            const hsize_t dims[1] = {3};
+            H5::CompType type(sizeof(Particle));
+            type.insertMember("x", HOFFSET(Particle, x), H5::PredType::NATIVE_DOUBLE);
+            type.insertMember("id", HOFFSET(Particle, id), H5::PredType::NATIVE_INT);
+            type.insertMember("v", HOFFSET(Particle, v), H5::ArrayType(H5::PredType::NATIVE_FLOAT, 1, dims));
+            type.insertMember("inner", HOFFSET(Particle, inner), inner);
+            type.insertMember("s", HOFFSET(Particle, s), H5::PredType::NATIVE_SHORT);
+            return type;
+        }
+
+        bool operator==(const Particle &other) const
+        {
+            return x == other.x and id == other.id and v[0] == other.v[0] and v[1] == other.v[1] and v[2] == other.v[2] and
+                   inner.c == other.inner.c and inner.d == other.inner.d and s == other.s;
+        }
+    };
+
+    size_t StoredSize(const std::string &filename, const std::string &path)
+    {
+        H5::H5File file(filename, H5F_ACC_RDONLY);
+        return file.openDataSet(path).getDataType().getSize();
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("compound_layout.h5");
+    // about 14 MiB of records, so the packed path repacks in several blocks
+    std::vector<Particle> particles(300000);
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        const int n = static_cast<int>(i);
+        particles[i] = Particle{i * 0.25, n, {1.0f, 2.0f, float(i)}, {char(i % 128), i * 0.5}, short(i % 30000)};
+    }
+    std::vector<std::vector<Particle>> grid(100, std::vector<Particle>(7));
+    for(size_t i = 0; i < grid.size(); ++i)
+    {
+        for(size_t j = 0; j < grid[i].size(); ++j)
+        {
+            grid[i][j] = particles[(i * 7919 + j * 104729) % particles.size()];
+        }
+    }
+
+    {
+        HDF5Utils::ElementOptions native;
+        native.compoundLayout = HDF5Utils::CompoundLayout::Native;
+        HDF5Writer writer(filename);
+        writer.AddElement("packed", particles);
+        writer.AddElement("native", particles, native);
+        writer.AddElement("grid", grid);
+        writer.AddElement("grid_native", grid, native);
+        writer.Dump();
+    }
+
+    HDF5Reader reader(filename);
+    for(const char *path : {"packed", "native"})
+    {
+        std::vector<Particle> read;
+        reader.ReadElement(path, read);
+        CHECK(read == particles);
+    }
+    for(const char *path : {"grid", "grid_native"})
+    {
+        std::vector<std::vector<Particle>> read;
+        reader.ReadElement(path, read);
+        CHECK(read == grid);
+    }
+
+    CHECK(StoredSize(filename, "packed") == sizeof(double) + sizeof(int) + 3 * sizeof(float) + 1 + sizeof(double) + sizeof(short));
+    CHECK(StoredSize(filename, "native") == sizeof(Particle));
+    CHECK(StoredSize(filename, "grid_native") == sizeof(Particle));
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Concurrent reader: several threads read elements, query objects and refresh extents through one HDF5Reader.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <atomic>
+#include <thread>
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("concurrent_reader.h5");
+    std::vector<double> contiguous(1000000);
+    for(size_t i = 0; i < contiguous.size(); ++i)
+    {
+        contiguous[i] = i * 0.5;
+    }
+    std::vector<std::vector<int>> matrix(1001, std::vector<int>(37));
+    for(size_t i = 0; i < matrix.size(); ++i)
+    {
+        for(int j = 0; j < 37; ++j)
+        {
+            matrix[i][j] = static_cast<int>(i) * 100 + j;
+        }
+    }
+    std::vector<float> small(1000);
+    for(int i = 0; i < 1000; ++i)
+    {
+        small[i] = static_cast<float>(i);
+    }
+    const std::vector<std::string> strings{"x", "yy"};
+    {
+        HDF5Utils::ElementOptions chunked;
+        chunked.appendable = true;
+        chunked.chunkRows = 1000;
+        HDF5Writer writer(filename);
+        writer.AddElement("a", contiguous);
+        writer.AddElement("g/a", contiguous, chunked);
+        writer.AddElement("g/m", matrix, chunked);
+        writer.AddElement("f", small);
+        writer.AddElement("s", strings);
+        writer.Dump();
+    }
+
+    HDF5Utils::ReaderOptions options;
+    options.concurrent = true;
+    options.readThreads = 4;
+    HDF5Reader reader(filename, options);
+    std::atomic<int> failures{0};
+    const auto check = [&failures](bool ok)
+    {
+        if(not ok)
+        {
+            ++failures;
+        }
+    };
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for(int k = 0; k < 5; ++k)
+            {
+                std::vector<double> values;
+                reader.ReadElement(t % 2 ? "a" : "g/a", values);
+                check(values == contiguous);
+                std::vector<std::vector<int>> rows;
+                reader.ReadElement("g/m", rows);
+                check(rows == matrix);
+                std::vector<int> flat;
+                reader.ReadElement("g/m", flat);
+                check(flat.size() == 1001 * 37 and flat[37 * 5 + 3] == 503);
+                std::vector<double> converted;
+                reader.ReadElement("f", converted);
+                check(converted.size() == 1000 and converted[999] == 999.0);
+                std::vector<std::string> strings_read;
+                reader.ReadElement("s", strings_read);
+                check(strings_read == strings);
+            }
+        });
+    }
+    // object queries run alongside the reads and take the same lock
+    for(int t = 0; t < 2; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for(int k = 0; k < 200; ++k)
+            {
+                check(reader.Exists("g/m") and not reader.Exists("missing"));
+                check(reader.ReadGroupNames("g") == std::vector<std::string>({"a", "m"}));
+                check(reader.Refresh("g/m") == std::vector<hsize_t>({1001, 37}));
+            }
+        });
+    }
+    for(std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(failures == 0);
+    return 0;
+}
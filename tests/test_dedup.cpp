@@ -0,0 +1,159 @@
+// Deduplication: identical elements become hard links within a dump and external links to earlier dumps, only once their
+// contents are compared, and stay correct when changed.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <cstring>
+
+int main()
+{
+    std::vector<double> connectivity(50000);
+    for(size_t i = 0; i < connectivity.size(); ++i)
+    {
+        connectivity[i] = static_cast<double>(i % 977);
+    }
+    // same bytes, other type: must not be linked
+    std::vector<long> as_integers(connectivity.size());
+    std::memcpy(as_integers.data(), connectivity.data(), connectivity.size() * sizeof(double));
+    const std::vector<double> steps(20000, 1.5);
+    const std::vector<double> small(10, 2.0);
+    const std::vector<std::vector<double>> table(300, std::vector<double>(100, 3.0));
+
+    const std::string first = TestUtils::TempPath("dedup_a.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.deduplicate = true;
+        HDF5Utils::ElementOptions float32;
+        float32.precision = HDF5Utils::StoragePrecision::Float32;
+        HDF5Writer writer(first, options);
+        writer.AddElement("/g1/connectivity", connectivity);
+        writer.AddElement("/g2/connectivity", connectivity);
+        writer.AddElement("/g3/connectivity", connectivity);
+        writer.AddElement("/g1/integers", as_integers);
+        writer.AddElement("/g1/connectivity32", connectivity, float32);
+        writer.AddElement("/g1/small", small);
+        writer.AddElement("/g2/small", small);
+        writer.AddElement("/g1/table", table);
+        writer.AddElement("/g2/table", table);
+        writer.AddElement("/g1/steps", steps);
+        writer.Dump();
+        const HDF5Utils::DedupStats stats = writer.DedupStatistics();
+        CHECK(stats.hardLinks == 3 and stats.externalLinks == 0);
+        CHECK(stats.bytesSaved == 2 * connectivity.size() * sizeof(double) + 300 * 100 * sizeof(double));
+    }
+    {
+        HDF5Reader reader(first);
+        std::vector<double> values;
+        reader.ReadElement("/g3/connectivity", values);
+        CHECK(values == connectivity);
+        std::vector<long> integers;
+        reader.ReadElement("/g1/integers", integers);
+        CHECK(integers == as_integers);
+        reader.ReadElement("/g1/connectivity32", values);
+        CHECK(values == connectivity and reader.Info("/g1/connectivity32").typeName == "float32");
+        reader.ReadElement("/g2/small", values);
+        CHECK(values == small);
+        std::vector<std::vector<double>> table_read;
+        reader.ReadElement("/g2/table", table_read);
+        CHECK(table_read == table);
+        // the index is found, but never listed
+        CHECK(reader.Exists(HDF5Utils::DedupIndexGroup));
+        CHECK((reader.ReadGroupNames("/") == std::vector<std::string>{"g1", "g2", "g3"}));
+    }
+    for(const HDF5Utils::CatalogMode mode : {HDF5Utils::CatalogMode::Lazy, HDF5Utils::CatalogMode::Eager})
+    {
+        HDF5Utils::ReaderOptions options;
+        options.catalog = mode;
+        CHECK((HDF5Reader(first, options).ReadGroupNames("/") == std::vector<std::string>{"g1", "g2", "g3"}));
+    }
+
+    // a second dump links to the elements of the first
+    const std::string second = TestUtils::TempPath("dedup_b.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.deduplicate = true;
+        options.dedupSources = {"dedup_a.h5"};
+        const std::vector<double> new_steps(20000, 2.5);
+        HDF5Writer writer(second, options);
+        writer.AddElement("/g1/connectivity", connectivity);
+        writer.AddElement("/g1/steps", new_steps);
+        writer.AddElement("/g9/table", table);
+        writer.Dump();
+        CHECK(writer.DedupStatistics().externalLinks == 2);
+    }
+    {
+        HDF5Reader reader(second);
+        std::vector<double> values;
+        reader.ReadElement("/g1/connectivity", values);
+        CHECK(values == connectivity and reader.Info("/g1/connectivity").link == H5L_TYPE_EXTERNAL);
+        reader.ReadElement("/g1/steps", values);
+        CHECK(values.size() == 20000 and values[0] == 2.5);
+        std::vector<std::vector<double>> table_read;
+        reader.ReadElement("/g9/table", table_read);
+        CHECK(table_read == table);
+    }
+
+    // equal keys with other contents, as after a hash collision, are written rather than linked
+    {
+        H5::H5File file(first, H5F_ACC_RDWR);
+        const std::vector<double> changed(20000, 7.0);
+        file.openDataSet("/g1/steps").write(changed.data(), H5::PredType::NATIVE_DOUBLE);
+    }
+    const std::string third = TestUtils::TempPath("dedup_c.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.deduplicate = true;
+        options.dedupSources = {"dedup_a.h5"};
+        const std::vector<std::string> names(300, "a name of some length");
+        const std::vector<std::vector<int>> jagged{{1, 2, 3}, std::vector<int>(500, 4), {}};
+        std::vector<std::vector<int>> other_jagged = jagged;
+        other_jagged[1][499] = 5;
+        HDF5Writer writer(third, options);
+        writer.AddElement("/steps", steps);
+        writer.AddElement("/connectivity", connectivity);
+        writer.AddElement("/names", names);
+        writer.AddElement("/names2", names);
+        writer.AddElement("/jagged", jagged);
+        writer.AddElement("/jagged2", jagged);
+        writer.AddElement("/other_jagged", other_jagged);
+        writer.Dump();
+        CHECK(writer.DedupStatistics().externalLinks == 1 and writer.DedupStatistics().hardLinks == 2);
+    }
+    {
+        HDF5Reader reader(third);
+        std::vector<double> values;
+        reader.ReadElement("/steps", values);
+        CHECK(values == steps and reader.Info("/steps").link == H5L_TYPE_HARD);
+        CHECK(reader.Info("/connectivity").link == H5L_TYPE_EXTERNAL);
+    }
+
+    // incremental: changing one of two linked elements must not change the other
+    const std::string incremental = TestUtils::TempPath("dedup_incremental.h5");
+    HDF5Utils::WriterOptions options;
+    options.deduplicate = true;
+    options.incremental = true;
+    std::vector<double> a(5000, 1.0);
+    std::vector<double> b(5000, 1.0);
+    HDF5Writer writer(incremental, options);
+    writer.AddElement("/a", a);
+    writer.AddElement("/b", b);
+    writer.Dump();
+    CHECK(writer.DedupStatistics().hardLinks == 1);
+    const auto value7 = [&incremental](const char *path)
+    {
+        std::vector<double> values;
+        HDF5Reader(incremental).ReadElement(path, values);
+        return values[7];
+    };
+    a[7] = 9.0;
+    writer.Dump();
+    CHECK(value7("/a") == 9.0 and value7("/b") == 1.0);
+    b[7] = 9.0;
+    writer.Dump();
+    CHECK(writer.DedupStatistics().hardLinks == 2);
+    CHECK(value7("/a") == 9.0 and value7("/b") == 9.0);
+    b[7] = 3.0;
+    writer.Dump();
+    CHECK(value7("/a") == 9.0 and value7("/b") == 3.0);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Dictionary-encoded strings round-trip, shrink low-cardinality data, and fall back to variable-length strings when too large.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+int main()
+{
+    const std::string plain_file = TestUtils::TempPath("dictionary_plain.h5");
+    const std::string dictionary_file = TestUtils::TempPath("dictionary.h5");
+    const char *labels[] = {"electron", "proton", "neutron", "", "muon-with-a-label-longer-than-the-small-string-buffer"};
+    std::vector<std::string> strings(200000);
+    for(size_t i = 0; i < strings.size(); ++i)
+    {
+        strings[i] = labels[(i * 7) % 5];
+    }
+    std::vector<std::vector<std::string>> matrix(100, std::vector<std::string>(3));
+    for(int i = 0; i < 100; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            matrix[i][j] = std::to_string(i % 30 + j);
+        }
+    }
+    std::vector<std::string> many(1000);
+    for(int i = 0; i < 1000; ++i)
+    {
+        many[i] = std::to_string(i);
+    }
+    // distinct strings past HDF5Utils::DictionaryMaxBytes
+    std::vector<std::string> huge(5000);
+    for(int i = 0; i < 5000; ++i)
+    {
+        huge[i] = std::string(20, 'a') + std::to_string(i);
+    }
+    const std::vector<std::string> empty;
+
+    {
+        HDF5Writer writer(plain_file);
+        writer.AddElement("strings", strings);
+        writer.Dump();
+    }
+    {
+        HDF5Utils::ElementOptions dictionary;
+        dictionary.stringEncoding = HDF5Utils::StringEncoding::Dictionary;
+        HDF5Writer writer(dictionary_file);
+        writer.AddElement("strings", strings, dictionary);
+        writer.AddElement("matrix", matrix, dictionary);
+        writer.AddElement("many", many, dictionary);
+        writer.AddElement("huge", huge, dictionary);
+        writer.AddElement("empty", empty, dictionary);
+        writer.Dump();
+    }
+
+    HDF5Reader reader(dictionary_file);
+    std::vector<std::string> read;
+    reader.ReadElement("strings", read);
+    CHECK(read == strings);
+    std::vector<std::vector<std::string>> matrix_read;
+    reader.ReadElement("matrix", matrix_read);
+    CHECK(matrix_read == matrix);
+    reader.ReadElement("many", read);
+    CHECK(read == many);
+    reader.ReadElement("huge", read);
+    CHECK(read == huge);
+    reader.ReadElement("empty", read);
+    CHECK(read.empty());
+    reader.ReadRows("strings", 5, 2, read);
+    CHECK(read.size() == 2 and read[0] == strings[5] and read[1] == strings[6]);
+
+    // codes are stored as small enum values; the fallback keeps variable-length strings
+    CHECK(reader.Info("strings").typeClass == H5T_ENUM and reader.Info("strings").rawSize == strings.size());
+    CHECK(reader.Info("many").typeName.find("uint16") != std::string::npos);
+    CHECK(reader.Info("huge").typeClass == H5T_STRING);
+    CHECK(reader.Info("strings").storageSize * 4 < HDF5Reader(plain_file).Info("strings").storageSize);
+
+    // a code naming no member of the dictionary is refused
+    const std::string corrupt_file = TestUtils::TempPath("dictionary_corrupt.h5");
+    {
+        H5::H5File file(corrupt_file, H5F_ACC_TRUNC);
+        H5::EnumType type(H5::PredType::STD_U8LE);
+        uint8_t a = 0;
+        uint8_t b = 1;
+        type.insert("a", &a);
+        type.insert("b", &b);
+        const hsize_t dims[] = {3};
+        const uint8_t codes[] = {0, 7, 1};
+        file.createDataSet("codes", type, H5::DataSpace(1, dims)).write(codes, type);
+    }
+    CHECK_THROWS(HDF5Reader(corrupt_file).ReadElement("codes", read), std::runtime_error);
+    return 0;
+}
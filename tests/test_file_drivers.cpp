@@ -0,0 +1,133 @@
+// File layouts: family and split files and aligned datasets round-trip, and the reader reports the layout it opened.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <filesystem>
+
+using HDF5Utils::FileDriver;
+
+int main()
+{
+    const std::vector<double> big(600000, 1.25);
+    const std::vector<double> small(7, 2.0);
+    std::vector<double> values;
+
+    // a family of 1 MiB members, reopened and appended to
+    const std::string family = TestUtils::TempPath("drivers_family-%d.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.layout.driver = FileDriver::Family;
+        options.layout.familyMemberBytes = 1 << 20;
+        HDF5Writer writer(family, options);
+        writer.AddElement("/big", big);
+        writer.AddElement("/small", small);
+        writer.Dump();
+    }
+    CHECK(std::filesystem::exists(TestUtils::TempPath("drivers_family-4.h5")));
+    {
+        HDF5Reader reader(family);
+        reader.ReadElement("/big", values);
+        CHECK(values == big);
+        CHECK(reader.Layout().driver == FileDriver::Family and reader.Layout().familyMemberBytes == (1 << 20));
+    }
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        HDF5Writer writer(family, options);
+        writer.WriteElement("/small2", small);
+    }
+    {
+        HDF5Reader reader(family);
+        reader.ReadElement("/small2", values);
+        CHECK(values == small);
+        reader.ReadElement("/big", values);
+        CHECK(values == big);
+    }
+
+    // metadata and raw data in separate files, with default and custom extensions
+    const std::string split = TestUtils::TempPath("drivers_split");
+    {
+        HDF5Utils::WriterOptions options;
+        options.layout.driver = FileDriver::Split;
+        HDF5Writer writer(split, options);
+        writer.WriteElement("/big", big);
+    }
+    CHECK(std::filesystem::file_size(split + "-r.h5") >= big.size() * sizeof(double));
+    CHECK(std::filesystem::file_size(split + "-m.h5") < big.size() * sizeof(double));
+    {
+        HDF5Reader reader(split);
+        reader.ReadElement("/big", values);
+        CHECK(values == big and reader.Layout().driver == FileDriver::Split);
+    }
+    const std::string custom = TestUtils::TempPath("drivers_custom");
+    {
+        HDF5Utils::WriterOptions options;
+        options.layout.driver = FileDriver::Split;
+        options.layout.metaExtension = ".meta";
+        options.layout.rawExtension = ".raw";
+        HDF5Writer writer(custom, options);
+        writer.WriteElement("/big", big);
+    }
+    {
+        CHECK(std::filesystem::exists(custom + ".meta") and std::filesystem::exists(custom + ".raw"));
+        HDF5Utils::ReaderOptions options;
+        options.layout.metaExtension = ".meta";
+        options.layout.rawExtension = ".raw";
+        HDF5Reader reader(custom, options);
+        reader.ReadElement("/big", values);
+        CHECK(values == big);
+    }
+
+    // large datasets start on 64 KiB boundaries
+    const std::string aligned = TestUtils::TempPath("drivers_aligned.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.layout.alignment = 1 << 16;
+        options.layout.alignmentThreshold = 4096;
+        options.layout.metadataBlockBytes = 1 << 16;
+        HDF5Writer writer(aligned, options);
+        writer.AddElement("/a", big);
+        writer.AddElement("/small", small);
+        writer.AddElement("/b", big);
+        writer.Dump();
+    }
+    {
+        H5::H5File file(aligned, H5F_ACC_RDONLY);
+        for(const char *path : {"/a", "/b"})
+        {
+            CHECK(H5Dget_offset(file.openDataSet(path).getId()) % (1 << 16) == 0);
+        }
+    }
+    {
+        HDF5Reader reader(aligned);
+        CHECK(reader.Layout().alignment == (1 << 16) and reader.Layout().driver == FileDriver::Default);
+        reader.ReadElement("/b", values);
+        CHECK(values == big);
+        reader.ReadElement("/small", values);
+        CHECK(values == small);
+    }
+    {
+        const std::string filesystem = TestUtils::TempPath("drivers_filesystem.h5");
+        HDF5Utils::WriterOptions options;
+        options.layout.alignToFilesystem = true;
+        HDF5Writer writer(filesystem, options);
+        writer.WriteElement("/a", big);
+        HDF5Reader(filesystem).ReadElement("/a", values);
+        CHECK(values == big);
+    }
+    // small elements below the default threshold are not padded to the alignment
+    {
+        const std::string packed = TestUtils::TempPath("drivers_packed.h5");
+        {
+            HDF5Utils::WriterOptions options;
+            options.layout.alignment = 1 << 20;
+            HDF5Writer writer(packed, options);
+            for(int i = 0; i < 50; ++i)
+            {
+                writer.WriteElement("/small" + std::to_string(i), small);
+            }
+        }
+        CHECK(std::filesystem::file_size(packed) < (1 << 20));
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+// h5inspect: the tool built next to the tests lists a file and prints previews and statistics of its datasets.
+#include "HDF5Writer.hpp"
+#include "TestUtils.hpp"
+#include <cstdio>
+#include <sys/wait.h>
+
+namespace
+{
+    // Runs ./h5inspect with `arguments` and returns its standard output; `status` is its exit code.
+    std::string Inspect(const std::string &arguments, int &status)
+    {
+        std::string output;
+        FILE *pipe = popen(("./h5inspect " + arguments + " 2>/dev/null").c_str(), "r");
+        if(not pipe)
+        {
+            status = -1;
+            return output;
+        }
+        char buffer[4096];
+        for(size_t n; (n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0;)
+        {
+            output.append(buffer, n);
+        }
+        const int result = pclose(pipe);
+        status = WIFEXITED(result) ? WEXITSTATUS(result) : -1;
+        return output;
+    }
+
+    bool Contains(const std::string &output, const std::string &text)
+    {
+        return output.find(text) != std::string::npos;
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("h5inspect.h5");
+    {
+        std::vector<double> ramp(100);
+        for(int i = 0; i < 100; ++i)
+        {
+            ramp[i] = i;
+        }
+        HDF5Writer writer(filename);
+        writer.WriteElement("/g/ramp", ramp);
+        writer.WriteElement("/g/matrix", std::vector<std::vector<int>>(4, std::vector<int>(3, 7)));
+        writer.WriteElement("/names", std::vector<std::string>{"first", "second"});
+        writer.WriteElement("/x", 2.5);
+    }
+
+    int status = 0;
+    std::string output = Inspect(filename, status);
+    CHECK(status == 0);
+    CHECK(Contains(output, "g/") and Contains(output, "ramp  float64 [100]") and Contains(output, "matrix  int32 [4 x 3]"));
+    CHECK(Contains(output, "x  float64 scalar") and not Contains(output, "[0] "));
+
+    output = Inspect("--head 2 --tail 1 " + filename + " /g/ramp", status);
+    CHECK(status == 0 and Contains(output, "[0] 0\n") and Contains(output, "[1] 1\n") and Contains(output, "  ...\n"));
+    CHECK(Contains(output, "[99] 99\n") and not Contains(output, "[2] "));
+
+    output = Inspect("--stride 25 --limit 3 " + filename + " /g/ramp", status);
+    CHECK(status == 0 and Contains(output, "every 25 rows:") and Contains(output, "[50] 50\n") and not Contains(output, "[75] "));
+
+    output = Inspect("--stats " + filename + " /g", status);
+    CHECK(status == 0 and Contains(output, "count 100  min 0  max 99  mean 49.5") and Contains(output, "count 12  min 7  max 7"));
+
+    output = Inspect("--head 1 " + filename + " /names", status);
+    CHECK(status == 0 and Contains(output, "[0] \"first\""));
+
+    Inspect(filename + " /nothing", status);
+    CHECK(status == 1);
+    Inspect(TestUtils::TempPath("h5inspect_missing.h5"), status);
+    CHECK(status == 1);
+    Inspect("--head", status);
+    CHECK(status == 2);
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Repeated Dump() on an open file: changed elements are rewritten, same-layout ones in place, and new storage options take effect.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    // File offset of a contiguous dataset's data (HADDR_UNDEF when chunked), and its number of filters.
+    std::pair<haddr_t, int> Storage(const std::string &filename, const std::string &path)
+    {
+        H5::H5File file(filename, H5F_ACC_RDONLY);
+        H5::DataSet dataset = file.openDataSet(path);
+        return {H5Dget_offset(dataset.getId()), dataset.getCreatePlist().getNfilters()};
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("incremental_dump.h5");
+    std::vector<double> mesh(100000, 1.0);
+    std::vector<double> field(1000, 0.0);
+    std::vector<std::vector<int>> jagged{{1}, {2, 3}};
+    std::vector<double> flagged(10, 1.0);
+    std::string label = "a";
+
+    HDF5Utils::WriterOptions options;
+    options.incremental = true;
+    HDF5Utils::ElementOptions dirty;
+    dirty.changeTracking = HDF5Utils::ChangeTracking::DirtyFlag;
+    HDF5Writer writer(filename, options);
+    haddr_t field_offset = HADDR_UNDEF;
+    for(int step = 0; step < 3; ++step)
+    {
+        field[0] = step;
+        if(step == 2)
+        {
+            field.resize(500);
+            jagged.push_back({4, 5, 6});
+            label = "longer";
+            flagged[0] = 99.0;
+        }
+        writer.AddElement("mesh", mesh);
+        writer.AddElement("f/field", field);
+        writer.AddElement("jagged", jagged);
+        writer.AddElement("label", label);
+        writer.AddElement("step", step);
+        writer.AddElement("flagged", flagged, dirty);
+        writer.Dump();
+
+        HDF5Reader reader(filename);
+        std::vector<double> values;
+        reader.ReadElement("f/field", values);
+        CHECK(values == field);
+        int stored_step = -1;
+        reader.ReadElement("step", stored_step);
+        CHECK(stored_step == step);
+        std::vector<std::vector<int>> jagged_read;
+        reader.ReadElement("jagged", jagged_read);
+        CHECK(jagged_read == jagged);
+        std::string label_read;
+        reader.ReadElement("label", label_read);
+        CHECK(label_read == label);
+        // a dirty-flag element is only rewritten after MarkDirty()
+        reader.ReadElement("flagged", values);
+        CHECK(values[0] == 1.0);
+
+        const haddr_t offset = Storage(filename, "f/field").first;
+        if(step == 1)
+        {
+            // same shape: overwritten in place
+            CHECK(offset == field_offset);
+        }
+        field_offset = offset;
+    }
+    writer.MarkDirty("flagged");
+    writer.Dump();
+    {
+        HDF5Reader reader(filename);
+        std::vector<double> values;
+        reader.ReadElement("flagged", values);
+        CHECK(values[0] == 99.0);
+    }
+
+    // changed storage options replace the dataset instead of keeping its old layout and filters
+    HDF5Utils::ElementOptions scaled;
+    scaled.scaleOffset = 2;
+    writer.AddElement("mesh", mesh, scaled);
+    writer.Dump();
+    CHECK(Storage(filename, "mesh").second == 1);
+    writer.AddElement("mesh", mesh);
+    writer.Dump();
+    CHECK(Storage(filename, "mesh").second == 0);
+    CHECK(Storage(filename, "mesh").first != HADDR_UNDEF);
+    writer.Close();
+
+    // reopening without truncation overwrites an existing element of the same shape
+    {
+        HDF5Writer reopened(filename, false);
+        field.assign(500, 7.0);
+        reopened.AddElement("f/field", field, scaled);
+        reopened.Dump();
+    }
+    // an element never replaces a group
+    {
+        HDF5Writer reopened(filename, false);
+        CHECK_THROWS(reopened.WriteElement("f", 1.0), std::runtime_error);
+    }
+    HDF5Reader reader(filename);
+    std::vector<double> values;
+    reader.ReadElement("f/field", values);
+    CHECK(values == field);
+    CHECK(Storage(filename, "f/field").second == 1);
+    reader.ReadElement("mesh", values);
+    CHECK(values == mesh);
+
+    // an element whose write threw is written again, not taken as dumped
+    {
+        HDF5Writer retrying(TestUtils::TempPath("incremental_retry.h5"), options);
+        HDF5Utils::SparseArray<double> sparse;
+        sparse.shape = {2, 2};
+        sparse.indptr = {0, 1, 1};
+        sparse.indices = {5};
+        sparse.values = {1.0};
+        retrying.AddElement("sparse", sparse);
+        CHECK_THROWS(retrying.Dump(), std::runtime_error);
+        CHECK_THROWS(retrying.Dump(), std::runtime_error);
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Vectors with polymorphic allocators round-trip, results keep their allocator, and scratch buffers use the set memory resource.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <memory_resource>
+
+namespace
+{
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    struct Record
+    {
+        int a;
+        double b;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Record));
+            type.insertMember("a", HOFFSET(Record, a), H5::PredType::NATIVE_INT);
+            type.insertMember("b", HOFFSET(Record, b), H5::PredType::NATIVE_DOUBLE);
+            return type;
+        }
+
+        bool operator==(const Record &other) const
+        {
+            return a == other.a and b == other.b;
+        }
+    };
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("memory_resource.h5");
+    const std::pmr::vector<double> flat{1.0, 2.0, 3.0, 4.0};
+    const std::pmr::vector<std::pmr::vector<int>> nested(3, std::pmr::vector<int>{1, 2, 3});
+    const std::pmr::vector<std::pmr::vector<int>> jagged{{1}, {2, 3}, {4, 5, 6}};
+    const std::pmr::vector<std::string> strings{"a", "bb", "ccc"};
+    const std::pmr::vector<Record> records{{1, 1.5}, {2, 2.5}};
+    std::vector<std::string> labels(1000);
+    for(int i = 0; i < 1000; ++i)
+    {
+        labels[i] = "s" + std::to_string(i % 7);
+    }
+
+    CountingResource writer_scratch;
+    {
+        HDF5Utils::ElementOptions dictionary;
+        dictionary.stringEncoding = HDF5Utils::StringEncoding::Dictionary;
+        HDF5Writer writer(filename);
+        writer.SetMemoryResource(&writer_scratch);
+        writer.AddElement("flat", flat);
+        writer.AddElement("nested", nested);
+        writer.AddElement("jagged", jagged);
+        writer.AddElement("strings", strings);
+        writer.AddElement("records", records);
+        writer.AddElement("labels", labels, dictionary);
+        writer.Dump();
+    }
+    CHECK(writer_scratch.allocations > 0);
+
+    CountingResource reader_scratch;
+    HDF5Reader reader(filename);
+    reader.SetMemoryResource(&reader_scratch);
+    std::pmr::monotonic_buffer_resource arena(1 << 16);
+    std::pmr::vector<double> flat_read(&arena);
+    reader.ReadElement("flat", flat_read);
+    CHECK(flat_read == flat and flat_read.get_allocator().resource() == &arena);
+    std::pmr::vector<std::pmr::vector<int>> nested_read(&arena);
+    reader.ReadElement("nested", nested_read);
+    CHECK(nested_read == nested and nested_read[1].get_allocator().resource() == &arena);
+    std::pmr::vector<std::pmr::vector<int>> jagged_read;
+    reader.ReadElement("jagged", jagged_read);
+    CHECK(jagged_read == jagged);
+    std::pmr::vector<std::string> strings_read;
+    reader.ReadElement("strings", strings_read);
+    CHECK(strings_read == strings);
+    std::pmr::vector<Record> records_read;
+    reader.ReadElement("records", records_read);
+    CHECK(records_read == records);
+    std::vector<std::string> labels_read;
+    reader.ReadElement("labels", labels_read);
+    CHECK(labels_read == labels);
+    std::pmr::vector<std::string> rows;
+    reader.ReadRows("strings", 1, 2, rows);
+    CHECK(rows.size() == 2 and rows[1] == "ccc");
+    CHECK(reader_scratch.allocations > 0);
+    return 0;
+}
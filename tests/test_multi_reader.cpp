@@ -0,0 +1,85 @@
+// HDF5MultiReader: reads across files through a bounded LRU pool, and bounds the files kept open by external links.
+#include "HDF5Writer.hpp"
+#include "HDF5MultiReader.hpp"
+#include "TestUtils.hpp"
+#include <dirent.h>
+
+namespace
+{
+    // Number of open file descriptors of this process.
+    size_t OpenDescriptors(void)
+    {
+        size_t count = 0;
+        if(DIR *directory = opendir("/proc/self/fd"))
+        {
+            while(readdir(directory))
+            {
+                ++count;
+            }
+            closedir(directory);
+        }
+        return count;
+    }
+}
+
+int main()
+{
+    const int files = 20;
+    std::vector<std::string> names;
+    for(int i = 0; i < files; ++i)
+    {
+        names.push_back(TestUtils::TempPath("multi" + std::to_string(i) + ".h5"));
+        HDF5Writer writer(names.back());
+        writer.WriteElement("g/v", std::vector<int>{i, i + 1});
+    }
+    const std::string links = TestUtils::TempPath("multi_links.h5");
+    {
+        HDF5Writer writer(links);
+        for(int i = 0; i < files; ++i)
+        {
+            writer.AddExternalLink(names[i], "/g/v", "l/v" + std::to_string(i));
+        }
+        writer.Dump();
+    }
+
+    {
+        HDF5MultiReader reader(4);
+        for(int pass = 0; pass < 3; ++pass)
+        {
+            for(int i = 0; i < files; ++i)
+            {
+                std::vector<int> values;
+                reader.ReadElement(names[i] + ":/g/v", values);
+                CHECK((values == std::vector<int>{i, i + 1}));
+                CHECK(reader.OpenFiles() == static_cast<size_t>(std::min(i + 1 + 4 * pass, 4)));
+            }
+        }
+        CHECK(reader.Exists(names[3] + ":/g/v"));
+        CHECK(not reader.Exists(names[3] + ":/x"));
+        CHECK(reader.ReadGroupNames(links + ":/l").size() == static_cast<size_t>(files));
+        std::vector<int> values;
+        CHECK_THROWS(reader.ReadElement("missing.h5:/g/v", values), H5::Exception);
+        CHECK(reader.OpenFiles() == 4);
+        reader.Clear();
+        CHECK(reader.OpenFiles() == 0);
+    }
+
+    // following the links of one pooled file keeps only a few targets open
+    const size_t before = OpenDescriptors();
+    {
+        HDF5MultiReader reader;
+        for(int pass = 0; pass < 2; ++pass)
+        {
+            for(int i = 0; i < files; ++i)
+            {
+                std::vector<int> values;
+                reader.ReadElement(links, "/l/v" + std::to_string(i), values);
+                CHECK((values == std::vector<int>{i, i + 1}));
+            }
+        }
+        CHECK(OpenDescriptors() <= before + 1 + HDF5MultiReader::LinkCacheSize);
+    }
+    CHECK(OpenDescriptors() == before);
+    CHECK(HDF5MultiReader::SplitLocation("a:b.h5:/x/y") == std::make_pair(std::string("a:b.h5"), std::string("/x/y")));
+    return 0;
+}
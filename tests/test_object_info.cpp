@@ -0,0 +1,84 @@
+// Info(): layout, shape, type, filters and sizes of datasets, groups and links, as shown by h5inspect, without reading data.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("object_info.h5");
+    const std::string target = TestUtils::TempPath("object_info_target.h5");
+    std::vector<double> values(1000);
+    for(size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = i * 0.25;
+    }
+    const std::vector<std::string> strings{"a", "bb"};
+    {
+        HDF5Writer writer(target);
+        writer.WriteElement("data", values);
+    }
+    {
+        HDF5Utils::ElementOptions scaled;
+        scaled.scaleOffset = 2;
+        scaled.chunkRows = 100;
+        HDF5Utils::ElementOptions appendable;
+        appendable.appendable = true;
+        appendable.chunkRows = 64;
+        HDF5Writer writer(filename);
+        writer.AddElement("g/plain", values);
+        writer.AddElement("g/scaled", values, scaled);
+        writer.AddElement("g/appendable", values, appendable);
+        writer.AddElement("strings", strings);
+        writer.AddExternalLink(target, "/data", "links/external");
+        writer.AddExternalLink(target, "/missing", "links/dangling");
+        writer.Dump();
+    }
+    {
+        H5::H5File file(filename, H5F_ACC_RDWR);
+        H5Lcreate_soft("/g/plain", file.getId(), "links/soft", H5P_DEFAULT, H5P_DEFAULT);
+    }
+
+    HDF5Reader reader(filename);
+    const HDF5Utils::ObjectInfo plain = reader.Info("g/plain");
+    CHECK(plain.type == H5O_TYPE_DATASET and plain.link == H5L_TYPE_HARD);
+    CHECK(plain.layout == "contiguous" and plain.chunkDims.empty() and plain.filters.empty());
+    CHECK(plain.dims == std::vector<hsize_t>{1000} and plain.maxDims == std::vector<hsize_t>{1000});
+    CHECK(plain.typeClass == H5T_FLOAT and plain.typeName == "float64");
+    CHECK(plain.rawSize == 8000 and plain.storageSize == 8000);
+
+    const HDF5Utils::ObjectInfo scaled = reader.Info("g/scaled");
+    CHECK(scaled.layout == "chunked" and scaled.chunkDims == std::vector<hsize_t>{100});
+    CHECK(scaled.filters.size() == 1);
+    CHECK(scaled.rawSize == 8000 and scaled.storageSize > 0 and scaled.storageSize < scaled.rawSize);
+
+    const HDF5Utils::ObjectInfo appendable = reader.Info("g/appendable");
+    CHECK(appendable.layout == "chunked" and appendable.maxDims == std::vector<hsize_t>{H5S_UNLIMITED});
+
+    const HDF5Utils::ObjectInfo string_info = reader.Info("strings");
+    CHECK(string_info.typeName == "string" and string_info.rawSize == 0 and string_info.dims == std::vector<hsize_t>{2});
+
+    CHECK(reader.Info("g").type == H5O_TYPE_GROUP);
+    CHECK(reader.Info("/").type == H5O_TYPE_GROUP);
+
+    const HDF5Utils::ObjectInfo soft = reader.Info("links/soft");
+    CHECK(soft.link == H5L_TYPE_SOFT and soft.linkTarget == "/g/plain" and soft.type == H5O_TYPE_DATASET);
+    const HDF5Utils::ObjectInfo external = reader.Info("links/external");
+    CHECK(external.link == H5L_TYPE_EXTERNAL and external.linkTarget == target + ":/data");
+    CHECK(external.type == H5O_TYPE_DATASET and external.dims == std::vector<hsize_t>{1000});
+    const HDF5Utils::ObjectInfo dangling = reader.Info("links/dangling");
+    CHECK(dangling.link == H5L_TYPE_EXTERNAL and dangling.type == H5O_TYPE_UNKNOWN);
+
+    // the catalog describes datasets the same way
+    const HDF5Utils::Catalog &catalog = reader.Catalog();
+    for(const char *path : {"/g/plain", "/g/scaled", "/g/appendable"})
+    {
+        const HDF5Utils::CatalogEntry *entry = catalog.Find(path);
+        CHECK(entry and entry->layout == reader.Info(path).layout and entry->dims == reader.Info(path).dims);
+    }
+
+    // previews read sampled rows only
+    std::vector<double> rows;
+    reader.ReadRows("g/scaled", 10, 5, rows, 100);
+    CHECK(rows.size() == 5 and rows[0] == 2.5 and rows[4] == 102.5);
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Pyramids: every reduction produces the expected coarser levels, BestLevel picks the smallest level covering a size, and rewrites drop
+// stale levels, all of them when written without any.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "HDF5WritePlan.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+
+using HDF5Utils::ElementOptions;
+using HDF5Utils::PyramidReduction;
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("pyramid.h5");
+    // 5 x 7 values i * 7 + j, so odd edges reduce partial blocks
+    std::vector<std::vector<float>> matrix(5, std::vector<float>(7));
+    for(int i = 0; i < 5; ++i)
+    {
+        for(int j = 0; j < 7; ++j)
+        {
+            matrix[i][j] = static_cast<float>(i * 7 + j);
+        }
+    }
+    std::vector<int> integers(9);
+    for(int i = 0; i < 9; ++i)
+    {
+        integers[i] = i;
+    }
+    std::vector<double> big(512 * 512);
+    for(size_t i = 0; i < big.size(); ++i)
+    {
+        big[i] = static_cast<double>((i * 2654435761u) % 1000);
+    }
+
+    {
+        ElementOptions mean;
+        mean.pyramidLevels = 10;
+        ElementOptions max = mean;
+        max.pyramidReduction = PyramidReduction::Max;
+        ElementOptions stride = mean;
+        stride.pyramidReduction = PyramidReduction::Stride;
+        ElementOptions two;
+        two.pyramidLevels = 2;
+        ElementOptions preview;
+        preview.pyramidLevels = 8;
+
+        HDF5Writer writer(filename);
+        writer.AddElement("/a/mean", matrix, mean);
+        writer.AddElement("/a/max", matrix, max);
+        writer.AddElement("/stride", matrix, stride);
+        writer.AddElement("/integers", integers, mean);
+        writer.AddElement("/view", HDF5Utils::StridedView<float>(&matrix[0][0], {1, 7}), two);
+        writer.AddElement("/big", HDF5Utils::StridedView<double>(big.data(), {512, 512}), preview);
+        writer.Dump();
+    }
+
+    {
+        HDF5Reader reader(filename);
+        // levels stop once every dimension is 1
+        CHECK(reader.PyramidLevels("/a/mean") == 3);
+        CHECK(reader.PyramidLevels("/integers") == 4);
+        CHECK(reader.PyramidLevels("/view") == 2);
+        CHECK(reader.PyramidLevels("/nothing") == 0);
+
+        std::vector<std::vector<float>> level;
+        reader.ReadLevel("/a/mean", 0, level);
+        CHECK(level == matrix);
+        reader.ReadLevel("/a/mean", 1, level);
+        CHECK(level.size() == 3 and level[0].size() == 4);
+        CHECK(level[0][0] == (0 + 1 + 7 + 8) / 4.0f and level[0][3] == (6 + 13) / 2.0f);
+        CHECK(level[2][0] == (28 + 29) / 2.0f and level[2][3] == 34.0f);
+        reader.ReadLevel("/a/max", 1, level);
+        CHECK(level[0][0] == 8.0f and level[1][2] == 26.0f and level[2][3] == 34.0f);
+        reader.ReadLevel("/stride", 2, level);
+        CHECK((level == std::vector<std::vector<float>>{{0.0f, 4.0f}, {28.0f, 32.0f}}));
+
+        // integer means are stored as double
+        std::vector<double> values;
+        reader.ReadLevel("/integers", 1, values);
+        CHECK(values.size() == 5 and values[0] == 0.5 and values[4] == 8.0);
+        CHECK(reader.Info(HDF5Utils::PyramidPath("/integers") + "/1").typeName == "float64");
+        reader.ReadLevel("/integers", 4, values);
+        CHECK(values.size() == 1);
+        CHECK_THROWS(reader.ReadLevel("/integers", 5, values), std::runtime_error);
+
+        CHECK(reader.BestLevel("/a/mean", {5, 7}) == 0);
+        CHECK(reader.BestLevel("/a/mean", {2, 3}) == 1);
+        CHECK(reader.BestLevel("/a/mean", {3, 2}) == 1);
+        CHECK(reader.BestLevel("/a/mean", {1, 1}) == 3);
+        CHECK(reader.BestLevel("/big", {64, 64}) == 3);
+        reader.ReadLevel("/big", 3, values);
+        CHECK(values.size() == 64 * 64);
+        double sum = 0.0;
+        for(int i = 0; i < 8; ++i)
+        {
+            for(int j = 0; j < 8; ++j)
+            {
+                sum += big[i * 512 + j];
+            }
+        }
+        CHECK(std::fabs(values[0] - sum / 64) < 1e-9);
+    }
+
+    // rewriting with fewer levels removes the stale ones
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        ElementOptions one;
+        one.pyramidLevels = 1;
+        HDF5Writer writer(filename, options);
+        writer.AddElement("/a/mean", matrix, one);
+        writer.Dump();
+    }
+    CHECK(HDF5Reader(filename).PyramidLevels("/a/mean") == 1);
+
+    // rewriting without levels, in any way, removes them all
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        std::vector<int> large(9, 1000);
+        HDF5Writer writer(filename, options);
+        writer.WriteElement("/integers", large);
+        writer.WriteElement("/view", HDF5Utils::StridedView<int>(large.data(), {3, 3}));
+        writer.WriteBlocks<float>("/stride", {5, 7}, [](hsize_t, hsize_t rows, float *values)
+        {
+            std::fill(values, values + rows * 7, 1.0f);
+        });
+        writer.WriteElement("/a/max", std::string("no longer numeric"));
+    }
+    {
+        HDF5Reader reader(filename);
+        for(const char *path : {"/integers", "/view", "/stride", "/a/max"})
+        {
+            CHECK(reader.PyramidLevels(path) == 0);
+        }
+        CHECK(reader.PyramidLevels("/big") == 8);
+        std::vector<double> values;
+        CHECK_THROWS(reader.ReadLevel("/integers", 1, values), std::runtime_error);
+    }
+
+    {
+        const std::string planned = TestUtils::TempPath("pyramid_plan.h5");
+        ElementOptions mean;
+        mean.pyramidLevels = 2;
+        HDF5WritePlan plan;
+        plan.Add("/x", matrix, mean);
+        plan.Write(planned);
+        HDF5Reader plan_reader(planned);
+        CHECK(plan_reader.PyramidLevels("/x") == 2);
+        std::vector<std::vector<float>> level;
+        plan_reader.ReadLevel("/x", 2, level);
+        CHECK(level.size() == 2 and level[0].size() == 2);
+    }
+    {
+        const std::string planned = TestUtils::TempPath("pyramid_plan.h5");
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        HDF5Writer writer(planned, options);
+        HDF5WritePlan plan;
+        plan.Add("/x", matrix);
+        plan.Write(writer, "/");
+    }
+    CHECK(HDF5Reader(TestUtils::TempPath("pyramid_plan.h5")).PyramidLevels("/x") == 0);
+    return 0;
+}
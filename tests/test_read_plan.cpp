@@ -0,0 +1,155 @@
+// HDF5ReadPlan: one plan reads the same schema from many files, and rejects a file that does not match it before reading anything.
+#include "HDF5Writer.hpp"
+#include "HDF5ReadPlan.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Record
+    {
+        int a;
+        double b;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Record));
+            type.insertMember("a", HOFFSET(Record, a), H5::PredType::NATIVE_INT);
+            type.insertMember("b", HOFFSET(Record, b), H5::PredType::NATIVE_DOUBLE);
+            return type;
+        }
+
+        bool operator==(const Record &other) const
+        {
+            return a == other.a and b == other.b;
+        }
+    };
+
+    const int Fields = 50;
+
+    std::string FieldPath(int e)
+    {
+        return "/step/g" + std::to_string(e % 10) + "/f" + std::to_string(e);
+    }
+
+    std::string Write(int f, bool wider = false)
+    {
+        const std::string filename = TestUtils::TempPath("read_plan" + std::to_string(f) + ".h5");
+        HDF5Writer writer(filename);
+        for(int e = 0; e < Fields; ++e)
+        {
+            std::vector<double> field(16);
+            for(int i = 0; i < 16; ++i)
+            {
+                field[i] = f * 1000 + e + i * 0.5;
+            }
+            writer.WriteElement(FieldPath(e), field);
+        }
+        writer.WriteElement("/m", std::vector<std::vector<float>>(4, std::vector<float>(wider ? 4 : 3, float(f))));
+        std::vector<Record> records(5);
+        for(int i = 0; i < 5; ++i)
+        {
+            records[i] = Record{i + f, i * 0.5};
+        }
+        writer.WriteElement("/records", records);
+        HDF5Utils::ElementOptions columnar;
+        columnar.compoundLayout = HDF5Utils::CompoundLayout::Columnar;
+        writer.WriteElement("/columnar", records, columnar);
+        writer.WriteElement("/strings", std::vector<std::string>{"a", std::to_string(f)});
+        writer.WriteElement("/x", f * 2.0);
+        writer.WriteElement("/jagged", std::vector<std::vector<int>>{{1}, {2, f}});
+        return filename;
+    }
+}
+
+int main()
+{
+    std::vector<std::string> files;
+    for(int f = 0; f < 5; ++f)
+    {
+        files.push_back(Write(f));
+    }
+
+    std::vector<std::vector<double>> fields(Fields);
+    std::vector<std::vector<float>> matrix;
+    std::vector<Record> records;
+    std::vector<Record> columnar;
+    std::vector<std::string> strings;
+    double x = 0.0;
+    std::vector<std::vector<int>> jagged;
+    HDF5ReadPlan plan;
+    for(int e = 0; e < Fields; ++e)
+    {
+        plan.Add(FieldPath(e), fields[e]);
+    }
+    plan.Add("/m", matrix);
+    plan.Add("/records", records);
+    plan.Add("/columnar", columnar);
+    plan.Add("/strings", strings);
+    plan.Add("/x", x);
+    plan.Add("/jagged", jagged);
+    CHECK(plan.Size() == Fields + 6 and not plan.Compiled());
+
+    for(int f = 0; f < 5; ++f)
+    {
+        HDF5Reader reader(files[f]);
+        plan.Run(reader);
+        CHECK(plan.Compiled());
+        for(int e = 0; e < Fields; ++e)
+        {
+            CHECK(fields[e].size() == 16 and fields[e][3] == f * 1000 + e + 1.5);
+        }
+        CHECK(matrix.size() == 4 and matrix[3].size() == 3 and matrix[3][2] == f);
+        CHECK(records.size() == 5 and records[4].a == 4 + f and records[4].b == 2.0);
+        CHECK(columnar == records);
+        CHECK(strings.size() == 2 and strings[1] == std::to_string(f));
+        CHECK(x == f * 2.0);
+        CHECK(jagged.size() == 2 and jagged[1][1] == f);
+        plan.Release();
+    }
+
+    // the same file again, and through a concurrent reader
+    {
+        HDF5Reader reader(files[1]);
+        plan.Run(reader);
+        plan.Run(reader);
+        CHECK(x == 2.0);
+    }
+    {
+        HDF5Utils::ReaderOptions options;
+        options.concurrent = true;
+        HDF5Reader reader(files[3], options);
+        plan.Run(reader);
+        CHECK(records[0].a == 3 and fields[7][3] == 3007 + 1.5);
+    }
+
+    // a file with another shape fails before any element is read
+    fields[0][0] = -5.0;
+    {
+        HDF5Reader reader(Write(99, true));
+        CHECK_THROWS(plan.Run(reader), std::runtime_error);
+    }
+    CHECK(fields[0][0] == -5.0);
+
+    // so does one whose columnar element has longer columns, although it is read after the others
+    {
+        const std::string longer = Write(98);
+        {
+            HDF5Utils::WriterOptions options;
+            options.truncate = false;
+            HDF5Utils::ElementOptions layout;
+            layout.compoundLayout = HDF5Utils::CompoundLayout::Columnar;
+            HDF5Writer writer(longer, options);
+            writer.WriteElement("/columnar", std::vector<Record>(6), layout);
+        }
+        HDF5Reader reader(longer);
+        CHECK_THROWS(plan.Run(reader), std::runtime_error);
+    }
+    CHECK(fields[0][0] == -5.0 and columnar.size() == 5);
+
+    HDF5ReadPlan missing;
+    std::vector<double> values;
+    missing.Add("/missing", values);
+    HDF5Reader reader(files[0]);
+    CHECK_THROWS(missing.Run(reader), std::runtime_error);
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Sharded writing: partitioned elements read back whole through virtual datasets, whole elements through external links.
+#include "HDF5ShardedWriter.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Point
+    {
+        double x;
+        int id;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Point));
+            type.insertMember("x", HOFFSET(Point, x), H5::PredType::NATIVE_DOUBLE);
+            type.insertMember("id", HOFFSET(Point, id), H5::PredType::NATIVE_INT);
+            return type;
+        }
+    };
+
+    void WriteAndRead(const std::string &filename, HDF5Utils::ShardWorkers workers)
+    {
+        std::vector<double> big(1000003);
+        for(size_t i = 0; i < big.size(); ++i)
+        {
+            big[i] = static_cast<double>(i);
+        }
+        std::vector<std::vector<float>> matrix(10, std::vector<float>(3, 2.0f));
+        matrix[9][2] = 7.0f;
+        std::vector<Point> points(5);
+        for(int i = 0; i < 5; ++i)
+        {
+            points[i] = Point{i * 1.5, i};
+        }
+        const std::vector<std::string> strings{"a", "b", "c"};
+        const std::vector<std::vector<int>> jagged{{1}, {2, 3}};
+        const double scalar = 4.0;
+
+        HDF5ShardedWriter writer(filename, 4, workers);
+        writer.AddPartitionedElement("data/big", big);
+        writer.AddPartitionedElement("data/matrix", matrix);
+        writer.AddPartitionedElement("points", points);
+        writer.AddPartitionedElement("strings", strings);
+        writer.AddElement("jagged", jagged);
+        writer.AddElement("g/scalar", scalar);
+        writer.Dump();
+        CHECK(writer.ShardFiles().size() == 4 and writer.Workers() == workers);
+
+        HDF5Reader reader(filename);
+        std::vector<double> big_read;
+        reader.ReadElement("data/big", big_read);
+        CHECK(big_read == big);
+        std::vector<std::vector<float>> matrix_read;
+        reader.ReadElement("data/matrix", matrix_read);
+        CHECK(matrix_read == matrix);
+        std::vector<Point> points_read;
+        reader.ReadElement("points", points_read);
+        CHECK(points_read.size() == 5 and points_read[4].id == 4 and points_read[3].x == 4.5);
+        std::vector<std::string> strings_read;
+        reader.ReadElement("strings", strings_read);
+        CHECK(strings_read == strings);
+        std::vector<std::vector<int>> jagged_read;
+        reader.ReadElement("jagged", jagged_read);
+        CHECK(jagged_read == jagged);
+        double scalar_read = 0.0;
+        reader.ReadElement("g/scalar", scalar_read);
+        CHECK(scalar_read == scalar);
+    }
+}
+
+int main()
+{
+    WriteAndRead(TestUtils::TempPath("sharded_processes.h5"), HDF5Utils::ShardWorkers::Processes);
+    WriteAndRead(TestUtils::TempPath("sharded_threads.h5"), HDF5Utils::ShardWorkers::Threads);
+
+    // with a file open in the caller, children are not forked, and threads still write
+    const std::string open_file = TestUtils::TempPath("sharded_open.h5");
+    {
+        HDF5Writer writer(open_file);
+        writer.WriteElement("x", 1);
+    }
+    HDF5Reader reader(open_file);
+    CHECK_THROWS(WriteAndRead(TestUtils::TempPath("sharded_refused.h5"), HDF5Utils::ShardWorkers::Processes), std::runtime_error);
+    WriteAndRead(TestUtils::TempPath("sharded_open_threads.h5"), HDF5Utils::ShardWorkers::Threads);
+
+    // a jagged partition is refused
+    {
+        const std::vector<std::vector<int>> jagged{{1, 2}, {3}, {4, 5}, {6, 7}};
+        HDF5ShardedWriter writer(TestUtils::TempPath("sharded_jagged.h5"), 2, HDF5Utils::ShardWorkers::Threads);
+        writer.AddPartitionedElement("jagged", jagged);
+        CHECK_THROWS(writer.Dump(), std::runtime_error);
+    }
+    int x = 0;
+    reader.ReadElement("x", x);
+    CHECK(x == 1);
+    return 0;
+}
@@ -0,0 +1,234 @@
+// Sparse CSR, CSC and COO elements round-trip, and row ranges and dense blocks read from them match the dense matrix.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "HDF5ReadPlan.hpp"
+#include "HDF5WritePlan.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+#include <random>
+
+using HDF5Utils::SparseArray;
+using HDF5Utils::SparseFormat;
+
+namespace
+{
+    const hsize_t Rows = 400;
+    const hsize_t Cols = 500;
+
+    // Rows [first, first + count) of a sparse matrix in any format, expanded to dense row-major values.
+    std::vector<double> Expand(const SparseArray<double> &rows, hsize_t count)
+    {
+        std::vector<double> dense(count * Cols, 0.0);
+        if(rows.format == SparseFormat::COO)
+        {
+            for(size_t i = 0; i < rows.values.size(); ++i)
+            {
+                dense[rows.indices[2 * i] * Cols + rows.indices[2 * i + 1]] += rows.values[i];
+            }
+        }
+        else if(rows.format == SparseFormat::CSR)
+        {
+            for(hsize_t r = 0; r < count; ++r)
+            {
+                for(hsize_t i = rows.indptr[r]; i < rows.indptr[r + 1]; ++i)
+                {
+                    dense[r * Cols + rows.indices[i]] = rows.values[i];
+                }
+            }
+        }
+        else
+        {
+            for(hsize_t c = 0; c < Cols; ++c)
+            {
+                for(hsize_t i = rows.indptr[c]; i < rows.indptr[c + 1]; ++i)
+                {
+                    dense[rows.indices[i] * Cols + c] = rows.values[i];
+                }
+            }
+        }
+        return dense;
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("sparse.h5");
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    // values are exact in float, so the COO copy stored as float compares equal
+    std::vector<double> dense(Rows * Cols, 0.0);
+    for(double &x : dense)
+    {
+        if(uniform(generator) < 0.01)
+        {
+            x = 1.0 + std::floor(uniform(generator) * 1024.0) / 1024.0;
+        }
+    }
+
+    SparseArray<double> csr;
+    csr.shape = {Rows, Cols};
+    csr.indptr.push_back(0);
+    for(hsize_t r = 0; r < Rows; ++r)
+    {
+        for(hsize_t c = 0; c < Cols; ++c)
+        {
+            if(dense[r * Cols + c] != 0.0)
+            {
+                csr.indices.push_back(c);
+                csr.values.push_back(dense[r * Cols + c]);
+            }
+        }
+        csr.indptr.push_back(csr.values.size());
+    }
+    SparseArray<double> csc;
+    csc.format = SparseFormat::CSC;
+    csc.shape = {Rows, Cols};
+    csc.indptr.push_back(0);
+    for(hsize_t c = 0; c < Cols; ++c)
+    {
+        for(hsize_t r = 0; r < Rows; ++r)
+        {
+            if(dense[r * Cols + c] != 0.0)
+            {
+                csc.indices.push_back(r);
+                csc.values.push_back(dense[r * Cols + c]);
+            }
+        }
+        csc.indptr.push_back(csc.values.size());
+    }
+    SparseArray<float> coo;
+    coo.format = SparseFormat::COO;
+    coo.shape = {Rows, Cols};
+    for(hsize_t r = 0; r < Rows; ++r)
+    {
+        for(hsize_t c = 0; c < Cols; ++c)
+        {
+            if(dense[r * Cols + c] != 0.0)
+            {
+                coo.indices.insert(coo.indices.end(), {r, c});
+                coo.values.push_back(static_cast<float>(dense[r * Cols + c]));
+            }
+        }
+    }
+    // 3-D COO with duplicate coordinates, which add up
+    SparseArray<int> cube;
+    cube.format = SparseFormat::COO;
+    cube.shape = {50, 60, 70};
+    std::vector<int> cube_dense(50 * 60 * 70, 0);
+    for(int i = 0; i < 500; ++i)
+    {
+        const hsize_t a = generator() % 50;
+        const hsize_t b = generator() % 60;
+        const hsize_t c = generator() % 70;
+        cube.indices.insert(cube.indices.end(), {a, b, c});
+        cube.values.push_back(i + 1);
+        cube_dense[(a * 60 + b) * 70 + c] += i + 1;
+    }
+    SparseArray<double> empty;
+    empty.shape = {10, 10};
+    empty.indptr.assign(11, 0);
+
+    {
+        HDF5Writer writer(filename);
+        writer.AddElement("/m/csr", csr);
+        writer.AddElement("/m/csc", csc);
+        writer.AddElement("/m/coo", coo);
+        writer.AddElement("/cube", cube);
+        writer.AddElement("/empty", empty);
+        writer.Dump();
+    }
+
+    HDF5Reader reader(filename);
+    SparseArray<double> read;
+    reader.ReadElement("/m/csr", read);
+    CHECK(read.format == SparseFormat::CSR and read.shape == csr.shape);
+    CHECK(read.indptr == csr.indptr and read.indices == csr.indices and read.values == csr.values);
+    reader.ReadElement("/m/csc", read);
+    CHECK(read.format == SparseFormat::CSC and read.indptr == csc.indptr and read.indices == csc.indices and read.values == csc.values);
+    SparseArray<float> coo_read;
+    reader.ReadElement("/m/coo", coo_read);
+    CHECK(coo_read.indices == coo.indices and coo_read.values == coo.values and coo_read.indptr.empty());
+    SparseArray<int> cube_read;
+    reader.ReadElement("/cube", cube_read);
+    CHECK(cube_read.indices == cube.indices and cube_read.values == cube.values);
+    reader.ReadElement("/empty", read);
+    CHECK(read.values.empty() and read.indptr.size() == 11);
+
+    for(const char *path : {"/m/csr", "/m/csc", "/m/coo"})
+    {
+        SparseArray<double> rows;
+        reader.ReadSparseRows(path, 170, 13, rows);
+        CHECK(rows.shape[0] == 13);
+        std::vector<double> block;
+        reader.ReadDenseBlock(path, {170, 0}, {13, Cols}, block);
+        CHECK(std::equal(block.begin(), block.end(), dense.begin() + 170 * Cols));
+        CHECK(Expand(rows, 13) == block);
+        reader.ReadDenseBlock(path, {300, 210}, {77, 133}, block);
+        for(hsize_t i = 0; i < 77; ++i)
+        {
+            for(hsize_t j = 0; j < 133; ++j)
+            {
+                CHECK(block[i * 133 + j] == dense[(300 + i) * Cols + 210 + j]);
+            }
+        }
+    }
+    std::vector<int> cube_block;
+    reader.ReadDenseBlock("/cube", {10, 5, 3}, {20, 30, 40}, cube_block);
+    for(int a = 0; a < 20; ++a)
+    {
+        for(int b = 0; b < 30; ++b)
+        {
+            for(int c = 0; c < 40; ++c)
+            {
+                CHECK(cube_block[(a * 30 + b) * 40 + c] == cube_dense[((a + 10) * 60 + b + 5) * 70 + c + 3]);
+            }
+        }
+    }
+    CHECK_THROWS(reader.ReadSparseRows("/m/csr", Rows - 1, 2, read), std::runtime_error);
+    std::vector<double> bad_block;
+    CHECK_THROWS(reader.ReadDenseBlock("/m/csr", {0}, {1}, bad_block), std::runtime_error);
+
+    // plans, and an incremental dump that changes the format
+    {
+        HDF5ReadPlan plan;
+        SparseArray<double> planned;
+        plan.Add("/m/csr", planned);
+        plan.Run(reader);
+        CHECK(planned.values == csr.values and planned.indptr == csr.indptr);
+    }
+    {
+        const std::string planned = TestUtils::TempPath("sparse_plan.h5");
+        HDF5WritePlan plan;
+        plan.Add("/s", csr);
+        plan.Write(planned);
+        SparseArray<double> x;
+        HDF5Reader(planned).ReadElement("/s", x);
+        CHECK(x.indices == csr.indices and x.values == csr.values);
+    }
+    {
+        const std::string incremental = TestUtils::TempPath("sparse_incremental.h5");
+        HDF5Utils::WriterOptions options;
+        options.incremental = true;
+        HDF5Writer writer(incremental, options);
+        SparseArray<double> matrix = csr;
+        writer.AddElement("/s", matrix);
+        writer.Dump();
+        matrix = SparseArray<double>();
+        matrix.format = SparseFormat::COO;
+        matrix.shape = {4};
+        matrix.indices = {1, 3};
+        matrix.values = {5.0, 6.0};
+        writer.Dump();
+        HDF5Reader incremental_reader(incremental);
+        SparseArray<double> x;
+        incremental_reader.ReadElement("/s", x);
+        CHECK(x.format == SparseFormat::COO and x.shape == std::vector<hsize_t>{4} and x.values == matrix.values);
+        CHECK(not incremental_reader.Exists("/s/indptr"));
+    }
+
+    SparseArray<double> invalid = csr;
+    invalid.indices[3] = Cols;
+    HDF5Writer writer(TestUtils::TempPath("sparse_invalid.h5"));
+    CHECK_THROWS(writer.WriteElement("/bad", invalid), std::runtime_error);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Per-element storage options: float32 storage, scale-offset and n-bit filters round-trip within their precision.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+
+namespace
+{
+    double MaxError(const std::vector<double> &a, const std::vector<double> &b, bool relative)
+    {
+        CHECK(a.size() == b.size());
+        double error = 0.0;
+        for(size_t i = 0; i < a.size(); ++i)
+        {
+            const double diff = std::fabs(a[i] - b[i]);
+            error = std::max(error, relative and a[i] != 0.0 ? diff / std::fabs(a[i]) : diff);
+        }
+        return error;
+    }
+
+    // Storage size of the dataset's file type and the number of filters in its pipeline.
+    std::pair<size_t, int> Stored(const std::string &filename, const std::string &path)
+    {
+        H5::H5File file(filename, H5F_ACC_RDONLY);
+        H5::DataSet dataset = file.openDataSet(path);
+        return {dataset.getDataType().getSize(), dataset.getCreatePlist().getNfilters()};
+    }
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("storage_options.h5");
+    std::vector<double> wave(100000);
+    for(size_t i = 0; i < wave.size(); ++i)
+    {
+        wave[i] = std::sin(i * 0.001) * 100.0 + 0.5;
+    }
+    std::vector<std::vector<double>> matrix(300, std::vector<double>(200, 1.5));
+    std::vector<int> ids(100000);
+    for(size_t i = 0; i < ids.size(); ++i)
+    {
+        ids[i] = 1000 + static_cast<int>(i % 500);
+    }
+
+    {
+        HDF5Utils::ElementOptions float32;
+        float32.precision = HDF5Utils::StoragePrecision::Float32;
+        HDF5Utils::ElementOptions scaled;
+        scaled.scaleOffset = 3;
+        HDF5Utils::ElementOptions nbit;
+        nbit.nbitPrecision = 20;
+        HDF5Utils::ElementOptions int_scaled;
+        int_scaled.scaleOffset = 0;
+        HDF5Utils::ElementOptions int_nbit;
+        int_nbit.nbitPrecision = 12;
+        const double scalar = 3.25;
+        const std::vector<double> empty;
+
+        HDF5Writer writer(filename);
+        writer.AddElement("float32", wave, float32);
+        writer.AddElement("scaled", wave, scaled);
+        writer.AddElement("nbit", wave, nbit);
+        writer.AddElement("matrix", matrix, float32);
+        writer.AddElement("int_scaled", ids, int_scaled);
+        writer.AddElement("int_nbit", ids, int_nbit);
+        writer.AddElement("scalar", scalar, float32);
+        writer.AddElement("empty", empty, scaled);
+        writer.AddElement("plain", wave);
+        writer.Dump();
+    }
+
+    HDF5Reader reader(filename);
+    std::vector<double> values;
+    reader.ReadElement("plain", values);
+    CHECK(values == wave);
+    reader.ReadElement("float32", values);
+    CHECK(MaxError(wave, values, true) < 1e-7);
+    reader.ReadElement("scaled", values);
+    CHECK(MaxError(wave, values, false) <= 0.5e-3 + 1e-12);
+    reader.ReadElement("nbit", values);
+    CHECK(MaxError(wave, values, true) <= std::ldexp(1.0, -20));
+    CHECK(values != wave);
+
+    std::vector<std::vector<double>> matrix_read;
+    reader.ReadElement("matrix", matrix_read);
+    CHECK(matrix_read == matrix);
+    std::vector<int> ids_read;
+    reader.ReadElement("int_scaled", ids_read);
+    CHECK(ids_read == ids);
+    reader.ReadElement("int_nbit", ids_read);
+    CHECK(ids_read == ids);
+    double scalar = 0.0;
+    reader.ReadElement("scalar", scalar);
+    CHECK(scalar == 3.25);
+    reader.ReadElement("empty", values);
+    CHECK(values.empty());
+
+    CHECK(Stored(filename, "float32") == std::make_pair(size_t(4), 0));
+    CHECK(Stored(filename, "scaled").second == 1);
+    // n-bit keeps the native type size; the filter packs the significant bits
+    CHECK(Stored(filename, "nbit") == std::make_pair(sizeof(double), 1));
+    CHECK(Stored(filename, "int_nbit") == std::make_pair(sizeof(int), 1));
+    CHECK(Stored(filename, "plain") == std::make_pair(sizeof(double), 0));
+    return 0;
+}
@@ -0,0 +1,110 @@
+// SWMR: a reader in another process sees rows appended by the writer; appendable elements also grow outside SWMR.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace
+{
+    const size_t Rows = 20;
+
+    void AppendOutsideSWMR(const std::string &filename)
+    {
+        HDF5Utils::ElementOptions appendable;
+        appendable.appendable = true;
+        appendable.chunkRows = 4;
+        {
+            HDF5Writer writer(filename);
+            writer.WriteElement("names", std::vector<std::string>(), appendable);
+            writer.WriteElement("values", std::vector<std::vector<int>>{{0, 0}}, appendable);
+            for(int i = 0; i < 5; ++i)
+            {
+                writer.AppendElement("names", std::vector<std::string>{"n" + std::to_string(i)});
+                writer.AppendElement("values", std::vector<std::vector<int>>{{i, 2 * i}, {i, 3 * i}});
+            }
+        }
+        HDF5Reader reader(filename);
+        std::vector<std::string> names;
+        reader.ReadElement("names", names);
+        CHECK(names.size() == 5 and names[0] == "n0" and names[4] == "n4");
+        std::vector<std::vector<int>> values;
+        reader.ReadElement("values", values);
+        CHECK(values.size() == 11);
+        CHECK((values[9] == std::vector<int>{4, 8}) and (values[10] == std::vector<int>{4, 12}));
+    }
+
+    // Child process: creates the datasets, starts SWMR in Dump() and appends one row at a time.
+    [[noreturn]] void Write(const std::string &filename, int ready)
+    {
+        HDF5Utils::WriterOptions options;
+        options.swmr = true;
+        options.swmrFlushInterval = 0.0;
+        HDF5Writer writer(filename, options);
+        HDF5Utils::ElementOptions appendable;
+        appendable.appendable = true;
+        appendable.chunkRows = 8;
+        std::vector<std::vector<double>> rows;
+        writer.AddElement("series/values", rows, appendable);
+        writer.Dump();
+        const char signal = 'x';
+        if(write(ready, &signal, 1) != 1)
+        {
+            _exit(1);
+        }
+        for(size_t i = 0; i < Rows; ++i)
+        {
+            writer.AppendElement("series/values", std::vector<std::vector<double>>{{double(i), 2.0 * i, 3.0}});
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        writer.Close();
+        _exit(0);
+    }
+}
+
+int main()
+{
+    AppendOutsideSWMR(TestUtils::TempPath("append.h5"));
+
+    const std::string filename = TestUtils::TempPath("swmr.h5");
+    unlink(filename.c_str());
+    int pipe_fds[2];
+    CHECK(pipe(pipe_fds) == 0);
+    const pid_t pid = fork();
+    CHECK(pid >= 0);
+    if(pid == 0)
+    {
+        Write(filename, pipe_fds[1]);
+    }
+    char signal = 0;
+    CHECK(read(pipe_fds[0], &signal, 1) == 1);
+
+    HDF5Utils::ReaderOptions options;
+    options.swmr = true;
+    HDF5Reader reader(filename, options);
+    size_t seen = 0;
+    for(int poll = 0; seen < Rows and poll < 2000; ++poll)
+    {
+        const std::vector<hsize_t> dims = reader.Refresh("series/values");
+        CHECK(dims.size() == 2);
+        if(dims[0] > seen)
+        {
+            seen = dims[0];
+            std::vector<std::vector<double>> values;
+            reader.ReadElement("series/values", values);
+            CHECK(values.size() >= seen);
+            for(size_t i = 0; i < seen; ++i)
+            {
+                CHECK((values[i] == std::vector<double>{double(i), 2.0 * i, 3.0}));
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    int status = 0;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) and WEXITSTATUS(status) == 0);
+    CHECK(seen == Rows);
+    return 0;
+}
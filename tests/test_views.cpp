@@ -0,0 +1,152 @@
+// Raw pointers, strided views and spans are written without copying into nested vectors and read back as regular elements.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+
+namespace
+{
+    struct Record
+    {
+        int a;
+        double b;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Record));
+            type.insertMember("a", HOFFSET(Record, a), H5::PredType::NATIVE_INT);
+            type.insertMember("b", HOFFSET(Record, b), H5::PredType::NATIVE_DOUBLE);
+            return type;
+        }
+
+        bool operator==(const Record &other) const
+        {
+            return a == other.a and b == other.b;
+        }
+    };
+
+    using View = HDF5Utils::StridedView<double>;
+}
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("views.h5");
+    // 6 rows of 5 values, with a row pitch of 8
+    const size_t rows = 6;
+    const size_t cols = 5;
+    const size_t pitch = 8;
+    std::vector<double> buffer(rows * pitch);
+    for(size_t i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = static_cast<double>(i);
+    }
+    std::vector<Record> records(10);
+    for(int i = 0; i < 10; ++i)
+    {
+        records[i] = Record{i, i * 0.5};
+    }
+    std::vector<std::string> strings{"a", "b", "c", "d", "e", "f"};
+
+    {
+        HDF5Utils::ElementOptions columnar;
+        columnar.compoundLayout = HDF5Utils::CompoundLayout::Columnar;
+        HDF5Utils::ElementOptions filtered;
+        filtered.precision = HDF5Utils::StoragePrecision::Float32;
+        filtered.scaleOffset = 2;
+
+        HDF5Writer writer(filename);
+        writer.WriteElement("raw", buffer.data(), {rows, pitch});
+        writer.WriteElement("padded", View(buffer.data(), {rows, cols}, {pitch, 1}));
+        writer.WriteElement("every2", View(buffer.data(), {rows * pitch / 2}, {2}));
+        writer.WriteElement("transposed", View(buffer.data(), {pitch, rows}, {1, pitch}));
+        writer.WriteElement("sub3d", View(buffer.data() + 1, {2, 3, 2}, {24, 8, 2}));
+        writer.WriteElement("broadcast", View(buffer.data(), {3, 4}, {0, 1}));
+        // views are copied into the element, so temporaries are fine
+        writer.AddElement("records", HDF5Utils::StridedView<Record>(records.data(), {5}, {2}));
+        writer.AddElement("records_columnar", HDF5Utils::StridedView<Record>(records.data(), {5}, {2}), columnar);
+        writer.AddElement("strings", HDF5Utils::StridedView<std::string>(strings.data(), {3}, {2}));
+        writer.AddElement("filtered", View(buffer.data(), {rows, cols}, {pitch, 1}), filtered);
+        writer.AddElement("empty", View(buffer.data(), {0, 3}));
+        writer.AddElement("one_row", View(buffer.data() + 3, {1, 4}, {999, 1}));
+#ifdef HDF5UTILS_HAS_SPAN
+        writer.AddElement("span", std::span<const double>(buffer.data(), 7));
+        writer.WriteElement("record_span", std::span<Record>(records));
+#endif
+        writer.Dump();
+    }
+
+    HDF5Reader reader(filename);
+    std::vector<std::vector<double>> matrix;
+    reader.ReadElement("raw", matrix);
+    CHECK(matrix.size() == rows and matrix[2][3] == 2 * pitch + 3);
+    reader.ReadElement("padded", matrix);
+    CHECK(matrix.size() == rows and matrix[0].size() == cols);
+    for(size_t i = 0; i < rows; ++i)
+    {
+        for(size_t j = 0; j < cols; ++j)
+        {
+            CHECK(matrix[i][j] == i * pitch + j);
+        }
+    }
+    std::vector<double> values;
+    reader.ReadElement("every2", values);
+    CHECK(values.size() == rows * pitch / 2 and values[5] == 10.0);
+    reader.ReadElement("transposed", matrix);
+    CHECK(matrix.size() == pitch and matrix[0].size() == rows);
+    for(size_t i = 0; i < pitch; ++i)
+    {
+        for(size_t j = 0; j < rows; ++j)
+        {
+            CHECK(matrix[i][j] == j * pitch + i);
+        }
+    }
+    std::vector<std::vector<std::vector<double>>> cube;
+    reader.ReadElement("sub3d", cube);
+    for(int i = 0; i < 2; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            for(int k = 0; k < 2; ++k)
+            {
+                CHECK(cube[i][j][k] == 1 + 24 * i + 8 * j + 2 * k);
+            }
+        }
+    }
+    reader.ReadElement("broadcast", matrix);
+    CHECK(matrix.size() == 3 and matrix[2][3] == 3.0 and matrix[1][0] == 0.0);
+    std::vector<Record> records_read;
+    reader.ReadElement("records", records_read);
+    CHECK(records_read.size() == 5 and records_read[2] == records[4]);
+    reader.ReadElement("records_columnar", records_read);
+    CHECK(records_read.size() == 5 and records_read[4] == records[8]);
+    std::vector<std::string> strings_read;
+    reader.ReadElement("strings", strings_read);
+    CHECK((strings_read == std::vector<std::string>{"a", "c", "e"}));
+    reader.ReadElement("filtered", matrix);
+    CHECK(std::fabs(matrix[5][4] - (5 * pitch + 4)) < 0.01);
+    reader.ReadElement("empty", matrix);
+    CHECK(matrix.empty());
+    reader.ReadElement("one_row", matrix);
+    CHECK(matrix.size() == 1 and (matrix[0] == std::vector<double>{3, 4, 5, 6}));
+#ifdef HDF5UTILS_HAS_SPAN
+    reader.ReadElement("span", values);
+    CHECK(values.size() == 7 and values[6] == 6.0);
+    reader.ReadElement("record_span", records_read);
+    CHECK(records_read == records);
+#endif
+
+    // an incremental dump notices that the memory behind a view changed
+    const std::string incremental = TestUtils::TempPath("views_incremental.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.incremental = true;
+        HDF5Writer writer(incremental, options);
+        writer.AddElement("padded", View(buffer.data(), {rows, cols}, {pitch, 1}));
+        writer.Dump();
+        buffer[pitch] = -1.0;
+        writer.Dump();
+    }
+    HDF5Reader(incremental).ReadElement("padded", matrix);
+    CHECK(matrix[1][0] == -1.0);
+    return 0;
+}
@@ -0,0 +1,176 @@
+// HDF5WritePlan: one plan writes a fixed schema per step to new files and to step groups, and rejects changed shapes.
+#include "HDF5WritePlan.hpp"
+#include "HDF5Reader.hpp"
+#include "TestUtils.hpp"
+
+namespace
+{
+    struct Record
+    {
+        int a;
+        double b;
+
+        static H5::CompType CreateHDF5CompType()
+        {
+            H5::CompType type(sizeof(Record));
+            type.insertMember("a", HOFFSET(Record, a), H5::PredType::NATIVE_INT);
+            type.insertMember("b", HOFFSET(Record, b), H5::PredType::NATIVE_DOUBLE);
+            return type;
+        }
+
+        bool operator==(const Record &other) const
+        {
+            return a == other.a and b == other.b;
+        }
+    };
+
+    const int Fields = 30;
+
+    std::string FieldPath(int e)
+    {
+        return "/fields/g" + std::to_string(e % 10) + "/f" + std::to_string(e);
+    }
+
+    struct Step
+    {
+        std::vector<std::vector<double>> fields = std::vector<std::vector<double>>(Fields, std::vector<double>(16));
+        std::vector<std::vector<float>> matrix = std::vector<std::vector<float>>(4, std::vector<float>(3));
+        std::vector<Record> records = std::vector<Record>(5);
+        std::vector<std::vector<Record>> grid = std::vector<std::vector<Record>>(2, std::vector<Record>(3));
+        std::vector<std::string> strings{"a", "b"};
+        double time = 0.0;
+        std::vector<std::vector<int>> jagged{{1}, {2, 3}};
+        std::vector<double> buffer = std::vector<double>(6 * 8);
+
+        void Fill(int step)
+        {
+            for(int e = 0; e < Fields; ++e)
+            {
+                for(int i = 0; i < 16; ++i)
+                {
+                    fields[e][i] = step * 1000 + e + i;
+                }
+            }
+            for(std::vector<float> &row : matrix)
+            {
+                row.assign(row.size(), float(step));
+            }
+            for(int i = 0; i < 5; ++i)
+            {
+                records[i] = Record{i + step, i * 0.5};
+            }
+            for(std::vector<Record> &row : grid)
+            {
+                row.assign(row.size(), Record{step, 1.0});
+            }
+            strings[1] = std::to_string(step);
+            time = step * 0.1;
+            jagged[1][1] = step;
+            for(size_t i = 0; i < buffer.size(); ++i)
+            {
+                buffer[i] = step + static_cast<double>(i);
+            }
+        }
+
+        void Check(const HDF5Reader &reader, const std::string &root, int step) const
+        {
+            std::vector<double> field;
+            reader.ReadElement(root + FieldPath(17), field);
+            CHECK(field.size() == 16 and field[3] == step * 1000 + 17 + 3);
+            std::vector<std::vector<float>> matrix_read;
+            reader.ReadElement(root + "/m", matrix_read);
+            CHECK(matrix_read == matrix);
+            std::vector<Record> records_read;
+            reader.ReadElement(root + "/records", records_read);
+            CHECK(records_read == records);
+            reader.ReadElement(root + "/columnar", records_read);
+            CHECK(records_read == records);
+            std::vector<std::vector<Record>> grid_read;
+            reader.ReadElement(root + "/grid", grid_read);
+            CHECK(grid_read == grid);
+            std::vector<std::string> strings_read;
+            reader.ReadElement(root + "/strings", strings_read);
+            CHECK(strings_read == strings);
+            double time_read = -1.0;
+            reader.ReadElement(root + "/time", time_read);
+            CHECK(time_read == time);
+            std::vector<std::vector<int>> jagged_read;
+            reader.ReadElement(root + "/jagged", jagged_read);
+            CHECK(jagged_read == jagged);
+            std::vector<std::vector<double>> rows;
+            reader.ReadElement(root + "/raw", rows);
+            CHECK(rows.size() == 6 and rows[5][7] == step + 47);
+            reader.ReadElement(root + "/padded", rows);
+            CHECK(rows.size() == 6 and rows[0].size() == 5 and rows[5][4] == step + 44);
+            reader.ReadElement(root + "/transposed", rows);
+            CHECK(rows.size() == 8 and rows[7][5] == step + 47);
+        }
+    };
+}
+
+int main()
+{
+    Step step;
+    HDF5Utils::ElementOptions float32;
+    float32.precision = HDF5Utils::StoragePrecision::Float32;
+    HDF5Utils::ElementOptions columnar;
+    columnar.compoundLayout = HDF5Utils::CompoundLayout::Columnar;
+
+    HDF5WritePlan plan;
+    for(int e = 0; e < Fields; ++e)
+    {
+        plan.Add(FieldPath(e), step.fields[e]);
+    }
+    plan.Add("m", step.matrix, float32);
+    plan.Add("records", step.records);
+    plan.Add("grid", step.grid);
+    plan.Add("columnar", step.records, columnar);
+    plan.Add("strings", step.strings);
+    plan.Add("time", step.time);
+    plan.Add("jagged", step.jagged);
+    plan.Add("raw", step.buffer.data(), {6, 8});
+    plan.Add("padded", HDF5Utils::StridedView<double>(step.buffer.data(), {6, 5}, {8, 1}));
+    plan.Add("transposed", HDF5Utils::StridedView<double>(step.buffer.data(), {8, 6}, {1, 8}));
+    // a repeated Add() rebinds the path
+    std::vector<double> unused(3);
+    plan.Add("time_series", unused);
+    plan.Add("time_series", step.fields[0]);
+    CHECK(plan.Size() == Fields + 11);
+
+    for(int s = 0; s < 3; ++s)
+    {
+        step.Fill(s);
+        const std::string filename = TestUtils::TempPath("write_plan" + std::to_string(s) + ".h5");
+        plan.Write(filename);
+        HDF5Reader reader(filename);
+        step.Check(reader, "", s);
+        std::vector<double> series;
+        reader.ReadElement("time_series", series);
+        CHECK(series == step.fields[0]);
+    }
+
+    // steps as groups of one file, overwriting an existing step
+    const std::string grouped = TestUtils::TempPath("write_plan_groups.h5");
+    {
+        HDF5Utils::WriterOptions options;
+        options.incremental = true;
+        HDF5Writer writer(grouped, options);
+        for(int s = 0; s < 5; ++s)
+        {
+            step.Fill(s);
+            plan.Write(writer, "/step" + std::to_string(s));
+        }
+        step.Fill(7);
+        plan.Write(writer, "/step3");
+    }
+    {
+        HDF5Reader reader(grouped);
+        step.Check(reader, "/step3", 7);
+        step.Fill(4);
+        step.Check(reader, "/step4", 4);
+    }
+
+    step.fields[0].push_back(1.0);
+    CHECK_THROWS(plan.Write(TestUtils::TempPath("write_plan_shape.h5")), std::runtime_error);
+    return 0;
+}
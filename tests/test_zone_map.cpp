@@ -0,0 +1,188 @@
+// Zone maps: ReadWhere() returns exactly the matching values while reading only the blocks that may match, also when the
+// stored values differ from the written ones.
+#include "HDF5Writer.hpp"
+#include "HDF5Reader.hpp"
+#include "HDF5WritePlan.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+
+using HDF5Utils::ElementOptions;
+using HDF5Utils::ValueRange;
+
+int main()
+{
+    const std::string filename = TestUtils::TempPath("zone_map.h5");
+    // an increasing trend with noise
+    const size_t n = 800000;
+    std::vector<double> trend(n);
+    for(size_t i = 0; i < n; ++i)
+    {
+        trend[i] = i * 1e-5 + ((i * 2654435761u) % 1000) * 1e-4;
+    }
+    std::vector<std::vector<int>> matrix(1000, std::vector<int>(3));
+    for(int i = 0; i < 1000; ++i)
+    {
+        for(int j = 0; j < 3; ++j)
+        {
+            matrix[i][j] = i * 3 + j;
+        }
+    }
+    std::vector<float> with_nans(100, 1.0f);
+    for(int i = 0; i < 50; ++i)
+    {
+        with_nans[i] = NAN;
+    }
+    with_nans[70] = 5.0f;
+    // slightly above 1 in memory, exactly 1 once stored as float
+    std::vector<double> near_one(1000, 3.0);
+    near_one[500] = 1.0000000001;
+    std::vector<int> counts(1000, 300);
+    counts[500] = 1 << 20;
+
+    {
+        ElementOptions large;
+        large.zoneMapRows = 65536;
+        ElementOptions hundred;
+        hundred.zoneMapRows = 100;
+        ElementOptions ten;
+        ten.zoneMapRows = 10;
+        ElementOptions float32 = hundred;
+        float32.precision = HDF5Utils::StoragePrecision::Float32;
+        ElementOptions nbit = hundred;
+        nbit.nbitPrecision = 12;
+
+        HDF5Writer writer(filename);
+        writer.AddElement("/trend", trend, large);
+        writer.AddElement("/plain", trend);
+        writer.AddElement("/g/matrix", matrix, hundred);
+        writer.AddElement("/nans", with_nans, ten);
+        writer.AddElement("/float32", near_one, float32);
+        writer.AddElement("/nbit", counts, nbit);
+        writer.WriteBlocks<double>("/blocks32", {near_one.size()}, [&near_one](hsize_t first, hsize_t rows, double *out)
+        {
+            std::copy(near_one.begin() + first, near_one.begin() + first + rows, out);
+        }, float32);
+        // converted on the writing thread while the next block is produced
+        HDF5Utils::BlockWriteOptions pipelined;
+        pipelined.blockBytes = 100 * sizeof(double);
+        pipelined.pipelined = true;
+        writer.WriteBlocks<double>("/pipelined32", {near_one.size()}, [&near_one](hsize_t first, hsize_t rows, double *out)
+        {
+            std::copy(near_one.begin() + first, near_one.begin() + first + rows, out);
+        }, float32, pipelined);
+        writer.Dump();
+    }
+
+    {
+        HDF5Reader reader(filename);
+        std::vector<double> values;
+        std::vector<hsize_t> indices;
+        HDF5Utils::ScanStats stats = reader.ReadWhere("/trend", ValueRange<double>::Above(7.9), values, indices);
+        size_t expected = 0;
+        for(double x : trend)
+        {
+            expected += x > 7.9;
+        }
+        CHECK(stats.zoneMap and values.size() == expected and stats.blocksRead < stats.blocks);
+        for(size_t k = 0; k < indices.size(); ++k)
+        {
+            CHECK(trend[indices[k]] == values[k] and values[k] > 7.9);
+        }
+        std::vector<double> plain_values;
+        std::vector<hsize_t> plain_indices;
+        stats = reader.ReadWhere("/plain", ValueRange<double>::Above(7.9), plain_values, plain_indices);
+        CHECK(not stats.zoneMap and stats.blocksRead == stats.blocks);
+        CHECK(plain_values == values and plain_indices == indices);
+        // reading in another type converts the range
+        std::vector<float> as_float;
+        stats = reader.ReadWhere("/trend", ValueRange<float>::AtLeast(7.95f), as_float, indices);
+        CHECK(stats.zoneMap and not as_float.empty());
+
+        std::vector<int> ints;
+        stats = reader.ReadWhere("/g/matrix", ValueRange<int>::Between(350, 352), ints, indices);
+        CHECK(stats.blocks == 10 and stats.blocksRead == 1 and ints.size() == 3 and indices[0] == 350);
+        stats = reader.ReadWhere("/g/matrix", ValueRange<int>{349, 352, false, false}, ints, indices);
+        CHECK(ints.size() == 2 and ints[0] == 350);
+        stats = reader.ReadWhere("/g/matrix", ValueRange<int>::Equal(5000), ints, indices);
+        CHECK(stats.blocksRead == 0 and ints.empty());
+
+        // blocks of NaNs never match
+        std::vector<float> floats;
+        stats = reader.ReadWhere("/nans", ValueRange<float>(), floats, indices);
+        CHECK(stats.blocksRead == 5 and floats.size() == 50);
+        stats = reader.ReadWhere("/nans", ValueRange<float>::Above(2.0f), floats, indices);
+        CHECK(stats.blocksRead == 1 and floats.size() == 1 and indices[0] == 70);
+
+        // ranges of the stored values
+        for(const char *path : {"/float32", "/blocks32", "/pipelined32"})
+        {
+            stats = reader.ReadWhere(path, ValueRange<double>::AtMost(1.0), values, indices);
+            CHECK(stats.zoneMap and stats.blocksRead == 1);
+            CHECK(values.size() == 1 and indices[0] == 500 and values[0] == 1.0);
+        }
+        // 12 bits clip 2^20 to 2047
+        stats = reader.ReadWhere("/nbit", ValueRange<int>::Between(301, 2047), ints, indices);
+        CHECK(stats.zoneMap and stats.blocksRead == 1);
+        CHECK(ints.size() == 1 and indices[0] == 500 and ints[0] == 2047);
+    }
+
+    // an in-place rewrite without a zone map removes it
+    {
+        HDF5Utils::WriterOptions options;
+        options.truncate = false;
+        std::vector<std::vector<int>> changed = matrix;
+        changed[0][0] = 5000;
+        HDF5Writer writer(filename, options);
+        writer.WriteElement("/g/matrix", changed);
+    }
+    {
+        std::vector<int> ints;
+        std::vector<hsize_t> indices;
+        const HDF5Utils::ScanStats stats = HDF5Reader(filename).ReadWhere("/g/matrix", ValueRange<int>::Equal(5000), ints, indices);
+        CHECK(not stats.zoneMap and ints.size() == 1);
+    }
+
+    // an incremental dump keeps it current
+    {
+        const std::string incremental = TestUtils::TempPath("zone_map_incremental.h5");
+        HDF5Utils::WriterOptions options;
+        options.incremental = true;
+        ElementOptions hundred;
+        hundred.zoneMapRows = 100;
+        std::vector<int> a(1000);
+        for(int i = 0; i < 1000; ++i)
+        {
+            a[i] = i;
+        }
+        HDF5Writer writer(incremental, options);
+        writer.AddElement("/a", a, hundred);
+        writer.Dump();
+        a[5] = 99999;
+        writer.Dump();
+        std::vector<int> ints;
+        std::vector<hsize_t> indices;
+        const HDF5Utils::ScanStats stats = HDF5Reader(incremental).ReadWhere("/a", ValueRange<int>::Above(5000), ints, indices);
+        CHECK(stats.zoneMap and ints.size() == 1 and indices[0] == 5);
+    }
+    {
+        const std::string planned = TestUtils::TempPath("zone_map_plan.h5");
+        ElementOptions hundred;
+        hundred.zoneMapRows = 100;
+        HDF5WritePlan plan;
+        plan.Add("/m", matrix, hundred);
+        plan.Write(planned);
+        std::vector<int> ints;
+        std::vector<hsize_t> indices;
+        CHECK(HDF5Reader(planned).ReadWhere("/m", ValueRange<int>::Equal(7), ints, indices).blocksRead == 1);
+    }
+
+    // rounding scale-offset would store other values than the ranges are computed from
+    HDF5Writer writer(TestUtils::TempPath("zone_map_scaled.h5"));
+    ElementOptions scaled;
+    scaled.zoneMapRows = 100;
+    scaled.scaleOffset = 2;
+    CHECK_THROWS(writer.WriteElement("/scaled", near_one, scaled), std::runtime_error);
+    scaled.scaleOffset = 0;
+    writer.WriteElement("/counts", counts, scaled);
+    return 0;
+}